@@ -0,0 +1,99 @@
+#include "AccessSchedule.h"
+#include <algorithm>
+
+// Days since 1970-01-01 of a Gregorian date (civil-from-days inverse, valid for all years >= 0)
+static int32_t daysFromCivil(int32_t year, int32_t month, int32_t day) {
+  year -= month <= 2 ? 1 : 0;
+  int32_t era = year / 400;
+  int32_t yearOfEra = year - era * 400;
+  int32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  int32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+// 1..4 decimal digits. Returns the position after them, nullptr if there are none.
+static const char* parseNumber(const char* text, int* value) {
+  int digits = 0;
+  *value = 0;
+  while (*text >= '0' && *text <= '9' && digits < 4) {
+    *value = *value * 10 + (*text++ - '0');
+    digits++;
+  }
+  return digits > 0 ? text : nullptr;
+}
+
+static bool compileWindows(const char* text, uint8_t hours[ACCESS_HOURS_PER_WEEK / 8]) {
+  const char* p = text;
+  for (;;) {
+    int firstDay, lastDay, from, to;
+    if ((p = parseNumber(p, &firstDay)) == nullptr) return false;
+    lastDay = firstDay;
+    if (*p == '-' && (p = parseNumber(p + 1, &lastDay)) == nullptr) return false;
+    if (*p != '/' || (p = parseNumber(p + 1, &from)) == nullptr) return false;
+    if (*p != '-' || (p = parseNumber(p + 1, &to)) == nullptr) return false;
+    if (firstDay < 1 || firstDay > 7 || lastDay < 1 || lastDay > 7 || from > 23 || to > 24) return false;
+
+    // Day ranges may wrap (6-1 = Saturday to Monday); hours past midnight
+    // wrap into the next day, Sunday into Monday
+    for (int day = firstDay - 1;; day = (day + 1) % 7) {
+      int start = day * 24 + from;
+      int end = to > from ? day * 24 + to : (day + 1) * 24 + to;
+      for (int hour = start; hour < end; hour++) {
+        int h = hour % ACCESS_HOURS_PER_WEEK;
+        hours[h >> 3] |= (uint8_t)(1u << (h & 7));
+      }
+      if (day == lastDay - 1) break;
+    }
+
+    if (*p == '\0') return true;
+    if (*p++ != ';') return false;
+  }
+}
+
+static bool compileExpiry(const char* text, uint16_t* expiresDay) {
+  int year, month, day;
+  const char* p = text;
+  if ((p = parseNumber(p, &year)) == nullptr || *p != '-') return false;
+  if ((p = parseNumber(p + 1, &month)) == nullptr || *p != '-') return false;
+  if ((p = parseNumber(p + 1, &day)) == nullptr || *p != '\0') return false;
+  if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+  int32_t days = daysFromCivil(year, month, day);
+  if (days <= 0 || days > UINT16_MAX) return false;  // 1970-01-02 .. 2149-06-06
+  *expiresDay = (uint16_t)days;
+  return true;
+}
+
+bool compileAccessSchedule(const char* windows, const char* expiry, AccessSchedule* schedule) {
+  memset(schedule, 0, sizeof(AccessSchedule));
+  if (windows == nullptr) {
+    memset(schedule->hours, 0xFF, sizeof(schedule->hours));
+  } else if (!compileWindows(windows, schedule->hours)) {
+    return false;
+  }
+  schedule->expiresDay = ACCESS_NO_EXPIRY;
+  return expiry == nullptr || compileExpiry(expiry, &schedule->expiresDay);
+}
+
+AccessSchedule mergeAccessSchedules(const AccessSchedule& a, const AccessSchedule& b) {
+  AccessSchedule merged;
+  for (size_t i = 0; i < sizeof(merged.hours); i++) {
+    merged.hours[i] = a.hours[i] | b.hours[i];
+  }
+  merged.reserved = 0;
+  merged.expiresDay = a.expiresDay == ACCESS_NO_EXPIRY || b.expiresDay == ACCESS_NO_EXPIRY
+                        ? ACCESS_NO_EXPIRY
+                        : std::max(a.expiresDay, b.expiresDay);
+  return merged;
+}
+
+AccessTime accessTimeAt(time_t now) {
+  AccessTime at = {};
+  struct tm local;
+  if (now < (time_t)LOG_EVENT_MIN_VALID_EPOCH || localtime_r(&now, &local) == nullptr) {
+    return at;  // Clock not set: time-restricted dongles are denied
+  }
+  at.day = (uint16_t)daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+  at.hourOfWeek = (uint8_t)(((local.tm_wday + 6) % 7) * 24 + local.tm_hour);
+  at.valid = true;
+  return at;
+}
@@ -0,0 +1,60 @@
+#ifndef ACCESS_SCHEDULE_H
+#define ACCESS_SCHEDULE_H
+
+#include "Config.h"
+
+// =============================================================
+// Access Schedules
+// Optional time restriction of a dongle: the hours of the week it may
+// open a door and the last day it is valid. googleScript sends them with
+// the dongle list in a compact text form; they are compiled once per
+// refresh into an AccessSchedule, so a scan only reads the local time
+// and tests one bit.
+//
+// Text form (after "@" in a dongle list entry, see DongleListParser.h):
+//   windows separated by ';', each "<day>[-<day>]/<from>-<to>"
+//   days 1..7 = Monday..Sunday, hours 0..24 local time, <to> exclusive.
+//   A window with <to> <= <from> runs past midnight into the next day.
+//   Example: "1-5/7-19;6/9-13" — weekdays 07:00-19:00, Saturday 09:00-13:00
+// Expiry (after "!"): "YYYY-MM-DD", the last local day with access.
+// =============================================================
+
+constexpr int ACCESS_HOURS_PER_WEEK = 7 * 24;
+constexpr size_t ACCESS_WINDOWS_TEXT_MAX = 80;  // Longest window text accepted (8 windows like "1-5/10-19;")
+constexpr size_t ACCESS_EXPIRY_TEXT_MAX = 10;   // "YYYY-MM-DD"
+constexpr uint16_t ACCESS_NO_EXPIRY = 0;
+
+struct AccessSchedule {
+  uint8_t hours[ACCESS_HOURS_PER_WEEK / 8];  // Bit h % 8 of hours[h / 8]: hour h of the week, 0 = Monday 00:00
+  uint8_t reserved;                           // 0
+  uint16_t expiresDay;                        // Last day with access (days since 1970-01-01), ACCESS_NO_EXPIRY
+};
+static_assert(sizeof(AccessSchedule) == 24, "AccessSchedule is stored in flash and hashed");
+
+// Compile the text form. windows == nullptr: every hour; expiry == nullptr: no expiry.
+// Returns false (schedule undefined) for malformed text.
+bool compileAccessSchedule(const char* windows, const char* expiry, AccessSchedule* schedule);
+
+// Union of two schedules, as googleScript merges rows of the same dongle:
+// the hours of both and the later expiry (no expiry wins).
+AccessSchedule mergeAccessSchedules(const AccessSchedule& a, const AccessSchedule& b);
+
+// Local time reduced to what a schedule needs. Computed once per scan.
+struct AccessTime {
+  uint16_t day;         // Days since 1970-01-01 (local date)
+  uint8_t hourOfWeek;   // 0 = Monday 00:00-00:59
+  bool valid;           // False before the first NTP sync: schedules deny
+};
+
+AccessTime accessTimeAt(time_t now);
+
+inline bool accessScheduleAllows(const AccessSchedule& schedule, const AccessTime& at) {
+  return at.valid && (schedule.expiresDay == ACCESS_NO_EXPIRY || at.day <= schedule.expiresDay) &&
+         ((schedule.hours[at.hourOfWeek >> 3] >> (at.hourOfWeek & 7)) & 1);
+}
+
+inline bool sameAccessSchedule(const AccessSchedule& a, const AccessSchedule& b) {
+  return memcmp(&a, &b, sizeof(AccessSchedule)) == 0;
+}
+
+#endif // ACCESS_SCHEDULE_H
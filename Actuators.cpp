@@ -0,0 +1,105 @@
+#include "Actuators.h"
+
+// Patterns for the active buzzer (KY-012 beeps while its pin is HIGH):
+// alternating on/off durations in ms, starting and ending with a beep.
+static const uint16_t PATTERN_OK[] = { 120 };
+static const uint16_t PATTERN_AUTH_OK[] = { 60, 60, 60 };
+static const uint16_t PATTERN_NO_AUTH[] = { 600 };
+static const uint16_t PATTERN_SOS[] = {
+  100, 100, 100, 100, 100, 300,  // . . .
+  300, 100, 300, 100, 300, 300,  // - - -
+  100, 100, 100, 100, 100,       // . . .
+};
+
+// =============================================================
+// ActuatorTimer
+// =============================================================
+
+void ActuatorTimer::onExpired(TimerHandle_t timer) {
+  // Timer task context: hand the step over to the owning task
+  ActuatorTimer* self = static_cast<ActuatorTimer*>(pvTimerGetTimerID(timer));
+  xTaskNotify(self->_notifyTask, self->_notifyBit, eSetBits);
+}
+
+void ActuatorTimer::beginTimer(const char* name, TaskHandle_t notifyTask, uint32_t notifyBit) {
+  _notifyTask = notifyTask;
+  _notifyBit = notifyBit;
+  _timer = xTimerCreate(name, 1, pdFALSE, this, onExpired);
+  configASSERT(_timer != nullptr);
+}
+
+void ActuatorTimer::arm(uint32_t durationMs) {
+  _armedMs = millis();
+  _durationMs = durationMs;
+  TickType_t ticks = pdMS_TO_TICKS(durationMs);
+  xTimerChangePeriod(_timer, ticks > 0 ? ticks : 1, 0);  // Also (re)starts the timer
+}
+
+bool ActuatorTimer::isDue() const {
+  // Tick rounding may expire the timer up to a tick early
+  return millis() - _armedMs + 2 >= _durationMs;
+}
+
+// =============================================================
+// RelayPulse
+// =============================================================
+
+void RelayPulse::begin(int pin, TaskHandle_t notifyTask, uint32_t notifyBit) {
+  _pin = pin;
+  pinMode(_pin, OUTPUT);
+  digitalWrite(_pin, LOW);
+  beginTimer("Relay", notifyTask, notifyBit);
+}
+
+void RelayPulse::pulse(uint32_t durationMs) {
+  digitalWrite(_pin, HIGH);
+  _active = true;
+  arm(durationMs);
+}
+
+void RelayPulse::onTimer() {
+  if (_active && isDue()) {
+    digitalWrite(_pin, LOW);
+    _active = false;
+  }
+}
+
+// =============================================================
+// BuzzerSequencer
+// =============================================================
+
+void BuzzerSequencer::begin(int pin, TaskHandle_t notifyTask, uint32_t notifyBit) {
+  _pin = pin;
+  pinMode(_pin, OUTPUT);
+  digitalWrite(_pin, LOW);
+  beginTimer("Buzzer", notifyTask, notifyBit);
+}
+
+void BuzzerSequencer::play(BuzzerSound sound) {
+  switch (sound) {
+    case BuzzerSound::OK:     _steps = PATTERN_OK;      _stepCount = sizeof(PATTERN_OK) / sizeof(PATTERN_OK[0]); break;
+    case BuzzerSound::AuthOk: _steps = PATTERN_AUTH_OK; _stepCount = sizeof(PATTERN_AUTH_OK) / sizeof(PATTERN_AUTH_OK[0]); break;
+    case BuzzerSound::NoAuth: _steps = PATTERN_NO_AUTH; _stepCount = sizeof(PATTERN_NO_AUTH) / sizeof(PATTERN_NO_AUTH[0]); break;
+    case BuzzerSound::SOS:    _steps = PATTERN_SOS;     _stepCount = sizeof(PATTERN_SOS) / sizeof(PATTERN_SOS[0]); break;
+  }
+  _step = 0;
+  applyStep();
+}
+
+void BuzzerSequencer::onTimer() {
+  if (_steps == nullptr || !isDue()) {
+    return;
+  }
+  _step++;
+  applyStep();
+}
+
+void BuzzerSequencer::applyStep() {
+  if (_step >= _stepCount) {
+    digitalWrite(_pin, LOW);
+    _steps = nullptr;
+    return;
+  }
+  digitalWrite(_pin, _step % 2 == 0 ? HIGH : LOW);  // Even steps beep, odd steps pause
+  arm(_steps[_step]);
+}
@@ -0,0 +1,75 @@
+#ifndef ACTUATORS_H
+#define ACTUATORS_H
+
+#include "Config.h"
+
+// =============================================================
+// Actuators (Core 1)
+// Relay pulse and buzzer patterns as small state machines on one-shot
+// FreeRTOS timers. Starting a pulse or a pattern only sets the pin and
+// arms the timer; the timer callback merely notifies the owning task,
+// which calls onTimer() to take the next step. Nothing here blocks, so
+// scans and door changes keep being handled while the door is unlocked
+// or a pattern plays.
+// =============================================================
+
+enum class BuzzerSound : uint8_t {
+  OK,      // Dongle list updated
+  AuthOk,  // Access granted
+  NoAuth,  // Access denied
+  SOS,     // Network/log failure
+};
+
+// Base: one-shot timer that notifies a task with a bit when it expires
+class ActuatorTimer {
+  private:
+    TimerHandle_t _timer = nullptr;
+    TaskHandle_t _notifyTask = nullptr;
+    uint32_t _notifyBit = 0;
+    unsigned long _armedMs = 0;
+    uint32_t _durationMs = 0;
+
+    static void onExpired(TimerHandle_t timer);
+
+  protected:
+    void beginTimer(const char* name, TaskHandle_t notifyTask, uint32_t notifyBit);
+    void arm(uint32_t durationMs);  // (Re)start, replacing any pending expiry
+
+    // False for a stale notification: the timer expired just before it was re-armed.
+    // (Timer commands are queued, so xTimerIsTimerActive() can lag behind arm().)
+    bool isDue() const;
+};
+
+class RelayPulse : public ActuatorTimer {
+  private:
+    int _pin = -1;
+    bool _active = false;
+
+  public:
+    void begin(int pin, TaskHandle_t notifyTask, uint32_t notifyBit);
+
+    // Energize the relay for durationMs. A pulse while active extends it.
+    void pulse(uint32_t durationMs);
+    void onTimer();
+    bool isActive() const { return _active; }
+};
+
+class BuzzerSequencer : public ActuatorTimer {
+  private:
+    int _pin = -1;
+    const uint16_t* _steps = nullptr;  // Alternating on/off durations (ms), starting with on
+    uint8_t _stepCount = 0;
+    uint8_t _step = 0;
+
+    void applyStep();
+
+  public:
+    void begin(int pin, TaskHandle_t notifyTask, uint32_t notifyBit);
+
+    // Start a pattern, cutting off the one still playing.
+    void play(BuzzerSound sound);
+    void onTimer();
+    bool isPlaying() const { return _steps != nullptr; }
+};
+
+#endif // ACTUATORS_H
@@ -8,14 +8,15 @@
 // #define DEBUG_MODE
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
+#include <esp_timer.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
+#include "freertos/timers.h"
 
 // =============================================================
-// Pin Definitions
+// Pin Definitions (door 1, see DOORS below)
 // =============================================================
 constexpr int BUZZERPIN = 4;
 constexpr int UNLOCKPIN = 2;
@@ -27,12 +28,31 @@ constexpr int INTERRUPT_IO_PIN_2 = 8;
 // Timing Constants
 // =============================================================
 constexpr int SWITCHDURATION_MS = 250;                 // Relay pulse duration for unlock
-constexpr int WIEGAND_TIMEOUT_MS = 200;                // Reset partial RFID reads (see loop() for rationale)
+constexpr int WIEGAND_TIMEOUT_MS = 200;                // Reset partial RFID reads (see receiveWiegandBit() for rationale)
+constexpr uint32_t WIEGAND_FRAME_RING_SIZE = 4;         // Completed frames waiting for loop() (power of two)
+constexpr int DOOR_DEBOUNCE_MS = 50;                   // Door contact must be stable this long before a change is logged
 constexpr float DONGLE_REFRESH_INTERVAL_HOURS = 4.0;   // Periodic dongle DB refresh (0.01 for testing, 0.5-72.0 production)
 constexpr unsigned long DONGLE_REFRESH_INTERVAL_MS = (unsigned long)(DONGLE_REFRESH_INTERVAL_HOURS * 3600.0f * 1000.0f);
-constexpr unsigned long WIFI_RECONNECT_INTERVAL_MS = 30000;   // WiFi reconnect check every 30s
 constexpr unsigned long DONGLE_REFRESH_DEBOUNCE_MS = 30000;   // MasterCard refresh cooldown (30s)
-constexpr unsigned long LOG_RETRY_BACKOFF_MS = 60000;          // Wait 60s between retry attempts for failed logs
+
+// Connectivity (see LinkMonitor.h): retries back off exponentially with jitter
+constexpr unsigned long WIFI_CONNECT_TIMEOUT_MS = 10000;       // First association after boot, before reconnecting
+constexpr unsigned long WIFI_RECONNECT_MIN_MS = 5000;          // First disconnect()/begin() after the link is lost
+constexpr unsigned long WIFI_RECONNECT_MAX_MS = 60000;
+constexpr unsigned long LINK_RETRY_MIN_MS = 1000;              // First retry after a failed request
+constexpr unsigned long LINK_RETRY_MAX_MS = 30000;
+constexpr uint8_t LINK_OFFLINE_AFTER_FAILURES = 3;             // Consecutive failed requests: degraded -> offline
+
+// =============================================================
+// Main Loop Wake-up Reasons
+// Notification bits of the loop task (Core 1). loop() sleeps until one is set.
+// =============================================================
+constexpr uint32_t MAIN_NOTIFY_WIEGAND_FRAME = 1 << 0;    // ISR: frame complete (in the door's frame ring)
+constexpr uint32_t MAIN_NOTIFY_WIEGAND_TIMEOUT = 1 << 1;  // Timer: partial frame stalled
+constexpr uint32_t MAIN_NOTIFY_DOOR_SETTLED = 1 << 2;     // Timer: door contact stable after an edge
+constexpr uint32_t MAIN_NOTIFY_BUZZER_SIGNAL = 1 << 3;    // Network task: signal in buzzerSignalQueue
+constexpr uint32_t MAIN_NOTIFY_RELAY_TIMER = 1 << 4;      // Timer: unlock pulse over
+constexpr uint32_t MAIN_NOTIFY_BUZZER_TIMER = 1 << 5;     // Timer: next step of the buzzer pattern
 
 // =============================================================
 // NTP Configuration
@@ -46,8 +66,19 @@ constexpr const char TIME_SERVER_3[] = "time.nist.gov";
 // =============================================================
 // Persistent Memory Keys
 // =============================================================
-constexpr const char PERS_MEM_DONGLE_IDS[] = "DongleIds";
-constexpr const char PERS_MEM_FAILED_LOGS[] = "Failed_Logs";
+// Legacy dongle storage in NVS — read once at boot to migrate into the "dongles" partition
+constexpr const char PERS_MEM_DONGLE_IDS[] = "DongleIds";      // Raw read_pa JSON
+constexpr const char PERS_MEM_FAILED_LOGS[] = "Failed_Logs";  // Legacy failed-log keyArray, migrated into "logring"
+constexpr const char PERS_MEM_LOG_CLOCK[] = "logClock";       // Namespace of the boot counter (see LogClock.h)
+constexpr const char PERS_MEM_BOOT_ID[] = "BootId";           // Boot number of boot-relative log times
+
+// Flash partition holding the dongle table (see partitions.csv, DongleStore.h)
+constexpr const char DONGLE_PARTITION_LABEL[] = "dongles";
+constexpr int DONGLE_PARTITION_SUBTYPE = 0x40;  // Custom data subtype
+
+// Flash partition holding the failed-log ring (see LogRing.h)
+constexpr const char LOG_RING_PARTITION_LABEL[] = "logring";
+constexpr int LOG_RING_PARTITION_SUBTYPE = 0x41;
 
 // =============================================================
 // Door State Constants
@@ -58,17 +89,26 @@ constexpr int DOOR_IS_OPEN = 1;
 // =============================================================
 // Network Task Configuration
 // =============================================================
-constexpr int LOG_QUEUE_SIZE = 30;              // Max queued log entries (30 x 62 bytes = ~1.9 KB)
-constexpr int NETWORK_TASK_STACK_SIZE = 16384;  // 16 KB — HTTPS with TLS + JSON parsing needs generous stack
+constexpr uint32_t LOG_QUEUE_SIZE = 1024;       // Log events buffered from Core 1 to the network task (x 8 bytes = 8 KB, power of two)
+// #define LOG_QUEUE_IN_PSRAM  // Place that buffer in PSRAM (needs CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY), then raise LOG_QUEUE_SIZE
+constexpr int NETWORK_TASK_STACK_SIZE = 16384;  // 16 KB — HTTPS with TLS needs generous stack
 constexpr int NETWORK_TASK_PRIORITY = 1;        // Same as default loop task (both pinned to separate cores)
-constexpr int MAX_FAILED_LOGS = 50;             // Max stored failed log entries in NVS (prevents partition exhaustion)
 constexpr int NETWORK_TASK_CORE = 0;            // Core 0 (Core 1 = main loop + ISRs)
-constexpr int NETWORK_TASK_LOOP_DELAY_MS = 100; // Task loop interval
+constexpr uint16_t SCRIPT_HTTP_TIMEOUT_MS = 20000;  // Per request to the Apps Script web app
+constexpr uint16_t SCRIPT_PROBE_TIMEOUT_MS = 6000;  // Per request while degraded or offline
+constexpr int LOG_BATCH_MAX_BYTES = 2048;       // write_log_batch POST body limit
+constexpr int LOG_BATCH_MAX_ENTRIES = 22;       // 22 x <= 90 bytes of JSON per entry fits LOG_BATCH_MAX_BYTES
+constexpr unsigned long LOG_BATCH_MAX_AGE_MS = 2000;  // Send a partial batch once its oldest entry is this old
+constexpr int LOG_BATCH_RESPONSE_MAX_BYTES = 128;     // {"success":...} answer kept for the check, rest discarded
+constexpr uint16_t METRICS_HTTP_PORT = 80;              // Prometheus scrape: GET /metrics
 
 // =============================================================
 // Types
 // =============================================================
 
+constexpr int DONGLE_ID_BITS = 26;  // Wiegand 26: 1 parity + 24 data + 1 parity
+
+// Text sizes of the log columns, formatted by the network task at upload time
 enum CharArraySizes {
   CharArrayDateSize = 11,      // DD.MM.YYYY + null
   CharArrayTimeSize = 9,       // HH:MM:SS + null
@@ -76,12 +116,70 @@ enum CharArraySizes {
   CharArrayDongleIdSize = 27,  // 26 Wiegand bits + null
 };
 
-typedef struct {
-  char date[CharArrayDateSize];
-  char time[CharArrayTimeSize];
-  char access[CharArrayAccessSize];
-  char dongle_id[CharArrayDongleIdSize];
-} LogEntryStruct;
+enum LogEventType : uint8_t {
+  LOG_EVENT_AUTHORISED,   // "authorised"
+  LOG_EVENT_DENIED,       // "denied"
+  LOG_EVENT_DOOR_CLOSED,  // "door_is_closed"
+  LOG_EVENT_DOOR_OPEN,    // "door_is_open"
+  LOG_EVENT_TYPE_COUNT,
+};
+
+// time() before the first NTP sync counts from 1970; same threshold as getLocalTime()
+constexpr uint32_t LOG_EVENT_MIN_VALID_EPOCH = 1451606400;  // 2016-01-01
+
+// One scan or door change, from Core 1 through the log event ring and the failed-log ring
+// to the upload. Date, time and the sheet's strings are only produced by
+// buildLogBatchBody() on Core 0.
+// Core 1 stamps the event with the uptime; the network task turns that into
+// wall time when it takes the event from the ring (see LogClock.h).
+struct LogEvent {
+  uint32_t epoch;                      // Uptime (s) in the ring; then time(), or boot-relative if not yet synced
+  uint32_t dongleId : DONGLE_ID_BITS;  // Raw Wiegand value, 0 for door events
+  uint32_t type : 3;                   // LogEventType
+  uint32_t door : 3;                   // Index into DOORS (records from single-door firmware read as 0)
+};
+static_assert(sizeof(LogEvent) == 8, "LogEvent is queued and stored in flash");
+static_assert(LOG_EVENT_TYPE_COUNT <= 8, "LogEvent::type has 3 bits");
+
+// Scans (granted or denied) are uploaded ahead of door events when a backlog is drained
+inline bool isAccessEvent(const LogEvent& event) {
+  return event.type == LOG_EVENT_AUTHORISED || event.type == LOG_EVENT_DENIED;
+}
+
+// =============================================================
+// Doors
+// Each door has its own reader, relay, door contact and buzzer, all
+// served by the loop task (see DoorChannel.h); the dongle table,
+// network task and log pipeline are shared. A door's position in DOORS
+// is its index in log events and, counted from 1, its number in the
+// door column of the dongle sheet.
+// =============================================================
+struct DoorConfig {
+  const char* name;  // Door column of the log sheet (at most DOOR_NAME_MAX - 1 chars)
+  uint8_t data0Pin;  // Wiegand D0
+  uint8_t data1Pin;  // Wiegand D1
+  uint8_t relayPin;
+  uint8_t contactPin;  // Door contact, INPUT_PULLUP
+  uint8_t buzzerPin;
+};
+
+constexpr DoorConfig DOORS[] = {
+  { "Technikecke", INTERRUPT_IO_PIN_1, INTERRUPT_IO_PIN_2, UNLOCKPIN, DOOR_STATE_PIN, BUZZERPIN },
+#ifdef HOST_TEST_SECOND_DOOR
+  { "Testtuer", 20, 21, 22, 23, 24 },  // Host tests only (door_channel_test): doors sharing the MAIN_NOTIFY_* bits
+#endif
+};
+constexpr int DOOR_COUNT = sizeof(DOORS) / sizeof(DOORS[0]);
+constexpr int MAX_DOORS = 32 - DONGLE_ID_BITS;  // Door mask bits above the ID in a dongle table entry
+constexpr size_t DOOR_NAME_MAX = 16;
+static_assert(DOOR_COUNT >= 1 && DOOR_COUNT <= MAX_DOORS, "1..MAX_DOORS doors");
+
+constexpr size_t doorNameLength(const char* name) { return *name == '\0' ? 0 : 1 + doorNameLength(name + 1); }
+constexpr bool doorNamesFit(int door = 0) {
+  return door == DOOR_COUNT || (doorNameLength(DOORS[door].name) < DOOR_NAME_MAX && doorNamesFit(door + 1));
+}
+static_assert(doorNamesFit(), "door names are limited to DOOR_NAME_MAX - 1 chars (log batch size)");
+static_assert(MAX_DOORS <= 8, "LogEvent::door has 3 bits");
 
 // Buzzer signals passed from network task to main loop via FreeRTOS queue.
 // Network task cannot call buzzer directly (not thread-safe).
@@ -95,32 +193,37 @@ enum BuzzerSignal : int8_t {
 // Shared Inline Utilities
 // =============================================================
 
-// Safely copy an Arduino String into a fixed-size char array.
-// Returns false if the string is too long or the destination is invalid.
-inline bool safeCopyStringToChar(const String& source, char* dest, size_t destSize) {
-  if (dest == nullptr || destSize == 0) {
-    return false;
-  }
-  if (source.length() + 1 > destSize) {
-    return false;
+// CRC-32 (IEEE 802.3, reflected), nibble table: 64 bytes of rodata, ~4x the bitwise speed.
+// Runs over the whole dongle table when validating the flash slot at boot.
+// Pass the previous result as crc to continue over several buffers.
+inline uint32_t crc32Update(uint32_t crc, const void* data, size_t length) {
+  static const uint32_t nibbleTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+  };
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= bytes[i];
+    crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+    crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
   }
-  memset(dest, 0, destSize);
-  source.toCharArray(dest, source.length() + 1);
-  return true;
+  return ~crc;
 }
 
-// Format the current date and time from NTP into char arrays.
-inline void getCurrentDateTime(char formattedDate[CharArrayDateSize], char formattedTime[CharArrayTimeSize]) {
-  struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) {
-    static_assert(sizeof("Date Error") <= CharArrayDateSize, "Error string too long for date buffer");
-    static_assert(sizeof("Date Err") <= CharArrayTimeSize, "Error string too long for time buffer");
-    safeCopyStringToChar("Date Error", formattedDate, CharArrayDateSize);
-    safeCopyStringToChar("Date Err", formattedTime, CharArrayTimeSize);
-    return;
-  }
-  strftime(formattedDate, CharArrayDateSize, "%d.%m.%Y", &timeinfo);
-  strftime(formattedTime, CharArrayTimeSize, "%H:%M:%S", &timeinfo);
+// Seconds since boot: monotonic and valid from power-up on, no NTP needed
+inline uint32_t uptimeSeconds() {
+  return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// Timestamp an event with the uptime. Only reads the clock — no formatting on the caller's core.
+inline LogEvent makeLogEvent(LogEventType type, uint32_t dongleId = 0, uint8_t door = 0) {
+  LogEvent event;
+  event.epoch = uptimeSeconds();
+  event.dongleId = dongleId;
+  event.type = type;
+  event.door = door;
+  return event;
 }
 
 #endif // CONFIG_H
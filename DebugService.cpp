@@ -2,10 +2,8 @@
 
 #ifdef DEBUG_MODE
 
-DebugService::DebugService() {
-  _serialPrintMutex = xSemaphoreCreateMutex();
-  configASSERT(_serialPrintMutex != nullptr);
-}
+#include "esp_memory_utils.h"
+#include <algorithm>
 
 // Meyers singleton: C++11 guarantees thread-safe initialization of static locals.
 // Safe even when first DBG() call happens concurrently on Core 0 and Core 1.
@@ -14,4 +12,143 @@ DebugService* DebugService::getInstance() {
   return &instance;
 }
 
+void DebugService::begin() {
+  BaseType_t created = xTaskCreatePinnedToCore(
+    drainTaskLoop,
+    "DebugDrain",
+    DEBUG_DRAIN_TASK_STACK_SIZE,
+    this,
+    DEBUG_DRAIN_TASK_PRIORITY,
+    nullptr,
+    DEBUG_DRAIN_TASK_CORE
+  );
+  configASSERT(created == pdPASS);
+  (void)created;
+}
+
+void DebugService::drainTaskLoop(void* param) {
+  DebugService* service = static_cast<DebugService*>(param);
+  for (;;) {
+    service->drain(Serial);
+    vTaskDelay(pdMS_TO_TICKS(DEBUG_DRAIN_INTERVAL_MS));
+  }
+}
+
+// =============================================================
+// Producer side (any task, any core)
+// =============================================================
+
+void DebugService::push(const DebugRecord& record) {
+  // Masking interrupts pins the caller to its core and keeps the other tasks
+  // of that core out, so each ring has exactly one producer at a time.
+  // The other core is not involved: no lock is shared between the cores.
+  UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+  bool queued = _rings[xPortGetCoreID()].push(record);
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+  if (!queued) {
+    _droppedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void encodeDebugArg(DebugRecord& record, const char* text) {
+  DebugArg& arg = record.args[record.argCount];
+  if (text == nullptr) {
+    text = "";
+  }
+  if (esp_ptr_in_drom(text)) {
+    // Literal or const table: still there when the drain task formats the record
+    record.types[record.argCount] = DEBUG_ARG_LITERAL;
+    arg.literal = text;
+  } else {
+    // Stack or heap buffer: copy what fits, an exhausted text area yields ""
+    record.types[record.argCount] = DEBUG_ARG_TEXT;
+    arg.textOffset = record.textLength < DEBUG_TEXT_BYTES ? record.textLength : DEBUG_TEXT_BYTES - 1;
+    size_t room = DEBUG_TEXT_BYTES - arg.textOffset - 1;
+    size_t length = strnlen(text, room);
+    memcpy(&record.text[arg.textOffset], text, length);
+    record.text[arg.textOffset + length] = '\0';
+    record.textLength = (uint8_t)(arg.textOffset + length + 1);
+  }
+  record.argCount++;
+}
+
+void encodeDebugArg(DebugRecord& record, const String& text) {
+  encodeDebugArg(record, text.c_str());
+}
+
+void encodeDebugArg(DebugRecord& record, const IPAddress& address) {
+  record.types[record.argCount] = DEBUG_ARG_IPV4;
+  record.args[record.argCount].u = (uint32_t)address;
+  record.argCount++;
+}
+
+void encodeDebugArg(DebugRecord& record, char c) {
+  record.types[record.argCount] = DEBUG_ARG_CHAR;
+  record.args[record.argCount].u = (uint8_t)c;
+  record.argCount++;
+}
+
+// =============================================================
+// Consumer side (drain task)
+// =============================================================
+
+size_t formatDebugRecord(const DebugRecord& record, char* buf, size_t bufSize) {
+  size_t length = 0;
+  for (uint8_t i = 0; i < record.argCount && length + 1 < bufSize; i++) {
+    const DebugArg& arg = record.args[i];
+    char* out = buf + length;
+    size_t room = bufSize - length;
+    int written = 0;
+    switch (record.types[i]) {
+      case DEBUG_ARG_LITERAL:
+        written = snprintf(out, room, "%s", arg.literal);
+        break;
+      case DEBUG_ARG_TEXT:
+        written = snprintf(out, room, "%s", &record.text[arg.textOffset]);
+        break;
+      case DEBUG_ARG_INT:
+        written = snprintf(out, room, "%ld", (long)arg.i);
+        break;
+      case DEBUG_ARG_UINT:
+        written = snprintf(out, room, "%lu", (unsigned long)arg.u);
+        break;
+      case DEBUG_ARG_CHAR:
+        written = snprintf(out, room, "%c", (char)arg.u);
+        break;
+      case DEBUG_ARG_IPV4:
+        written = snprintf(out, room, "%u.%u.%u.%u", (unsigned)(arg.u & 0xFF), (unsigned)((arg.u >> 8) & 0xFF),
+                           (unsigned)((arg.u >> 16) & 0xFF), (unsigned)(arg.u >> 24));
+        break;
+    }
+    length += written < 0 ? 0 : std::min((size_t)written, room - 1);
+  }
+  if (bufSize > 0) {
+    buf[length] = '\0';
+  }
+  return length;
+}
+
+size_t DebugService::drain(Print& out) {
+  char line[DEBUG_LINE_MAX + 1];
+  DebugRecord record;
+  size_t drained = 0;
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    while (_rings[core].pop(&record)) {
+      size_t length = formatDebugRecord(record, line, sizeof(line) - 1);
+      line[length++] = '\n';
+      out.write((const uint8_t*)line, length);
+      drained++;
+    }
+  }
+
+  uint32_t dropped = droppedCount();
+  if (dropped != _reportedDropCount) {
+    int length = snprintf(line, sizeof(line), "[debug] %lu message(s) dropped (total %lu)\n",
+                          (unsigned long)(dropped - _reportedDropCount), (unsigned long)dropped);
+    out.write((const uint8_t*)line, (size_t)length);
+    _reportedDropCount = dropped;
+  }
+  return drained;
+}
+
 #endif // DEBUG_MODE
@@ -5,6 +5,10 @@
 
 #ifdef DEBUG_MODE
 
+#include <atomic>
+#include <type_traits>
+#include "SpscRing.h"
+
 // =============================================================
 // Per-subsystem debug flags (only exist in debug builds).
 // Toggle individual flags to narrow debug output.
@@ -21,21 +25,87 @@ struct DebugFlags {
   static constexpr bool NETWORK_TASK = true;
 };
 
+// =============================================================
+// Debug Records
+// DBG() does not print. It packs its arguments into a DebugRecord —
+// string literals as pointers into flash, other strings copied, numbers
+// raw — and pushes it into the ring of the calling core. The drain task
+// formats the records and writes them to Serial from Core 0, so a DBG()
+// on the scan path never waits for a mutex or the UART.
+// A full ring drops the message; the drain task reports the count.
+// =============================================================
+constexpr int DEBUG_MAX_ARGS = 16;               // Arguments per DBG() (checked at compile time)
+constexpr size_t DEBUG_TEXT_BYTES = 64;          // Copied strings per message, truncated beyond
+constexpr uint32_t DEBUG_RING_SIZE = 32;         // Messages per core waiting for the drain task
+constexpr unsigned long DEBUG_DRAIN_INTERVAL_MS = 10;
+constexpr int DEBUG_DRAIN_TASK_STACK_SIZE = 3072;
+constexpr int DEBUG_DRAIN_TASK_PRIORITY = tskIDLE_PRIORITY;  // Below the network task: output only uses idle time
+constexpr int DEBUG_DRAIN_TASK_CORE = 0;                      // Never competes with loop() on Core 1
+constexpr size_t DEBUG_LINE_MAX = 256;                        // Formatted message, truncated beyond
+
+enum DebugArgType : uint8_t {
+  DEBUG_ARG_LITERAL,  // Pointer to a string in flash
+  DEBUG_ARG_TEXT,     // Offset of a copied string in DebugRecord::text
+  DEBUG_ARG_INT,
+  DEBUG_ARG_UINT,
+  DEBUG_ARG_CHAR,
+  DEBUG_ARG_IPV4,     // First octet in the low byte
+};
+
+union DebugArg {
+  const char* literal;
+  uint32_t textOffset;
+  int32_t i;
+  uint32_t u;
+};
+
+struct DebugRecord {
+  uint8_t argCount;
+  uint8_t textLength;
+  DebugArgType types[DEBUG_MAX_ARGS];
+  DebugArg args[DEBUG_MAX_ARGS];
+  char text[DEBUG_TEXT_BYTES];
+};
+
+// Record encoders, one per argument type DBG() accepts
+void encodeDebugArg(DebugRecord& record, const char* text);
+void encodeDebugArg(DebugRecord& record, const String& text);
+void encodeDebugArg(DebugRecord& record, const IPAddress& address);
+void encodeDebugArg(DebugRecord& record, char c);
+
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value>::type encodeDebugArg(DebugRecord& record, T value) {
+  DebugArg& arg = record.args[record.argCount];
+  if (std::is_signed<T>::value) {
+    record.types[record.argCount] = DEBUG_ARG_INT;
+    arg.i = (int32_t)value;
+  } else {
+    record.types[record.argCount] = DEBUG_ARG_UINT;
+    arg.u = (uint32_t)value;
+  }
+  record.argCount++;
+}
+
+// Format a record as one line (without line end). Returns the length (truncated to bufSize - 1).
+size_t formatDebugRecord(const DebugRecord& record, char* buf, size_t bufSize);
+
 class DebugService {
   private:
-    SemaphoreHandle_t _serialPrintMutex = nullptr;
+    SpscRing<DebugRecord, DEBUG_RING_SIZE> _rings[portNUM_PROCESSORS];  // Producer: the tasks of one core
+    std::atomic<uint32_t> _droppedCount{0};
+    uint32_t _reportedDropCount = 0;  // Drain task only
 
-    DebugService();
+    DebugService() = default;
 
-    // Variadic print helpers (single + recursive)
-    template<typename T>
-    void printHelper(T arg) {
-        Serial.print(arg);
-    }
+    static void drainTaskLoop(void* param);
+    void push(const DebugRecord& record);
+
+    // Variadic encode helpers (empty + recursive)
+    static void encode(DebugRecord& record) { (void)record; }
     template<typename T, typename... Args>
-    void printHelper(T arg, Args... args) {
-        Serial.print(arg);
-        printHelper(args...);
+    static void encode(DebugRecord& record, const T& arg, const Args&... args) {
+      encodeDebugArg(record, arg);
+      encode(record, args...);
     }
 
   public:
@@ -44,19 +114,29 @@ class DebugService {
 
     static DebugService* getInstance();
 
-    // Thread-safe println with mutex protection.
+    // Start the drain task. Messages logged before are kept (up to DEBUG_RING_SIZE per core).
+    void begin();
+
+    // Queue one message. Never blocks; a full ring drops it.
     // Flag check is done by the DBG() macro before calling this.
     template<typename... Args>
-    void println(Args... args) {
-      if (xSemaphoreTake(_serialPrintMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-          printHelper(args...);
-          Serial.println();
-          xSemaphoreGive(_serialPrintMutex);
-      }
+    void println(const Args&... args) {
+      static_assert(sizeof...(Args) <= DEBUG_MAX_ARGS, "Too many DBG() arguments, raise DEBUG_MAX_ARGS");
+      DebugRecord record;
+      record.argCount = 0;
+      record.textLength = 0;
+      encode(record, args...);
+      push(record);
     }
+
+    // Format and write every queued message to out, then a note about dropped
+    // messages if there are new ones. Called by the drain task (or a test).
+    size_t drain(Print& out);
+
+    uint32_t droppedCount() const { return _droppedCount.load(std::memory_order_relaxed); }
 };
 
-// DBG macro: checks the per-subsystem flag, then calls println.
+// DBG macro: checks the per-subsystem flag, then queues the message.
 // do-while(0) ensures safe use in if/else without braces.
 #define DBG(flag, ...) do { if (flag) DebugService::getInstance()->println(__VA_ARGS__); } while(0)
 
@@ -0,0 +1,273 @@
+#include "DongleListParser.h"
+
+static uint32_t decodeDoorMask(const char* doors) {
+  // "<door numbers>". Door numbers beyond MAX_DOORS are ignored, but a list
+  // without any known door is rejected: it must not become "every door".
+  uint32_t mask = 0;
+  uint32_t number = 0;
+  for (const char* c = doors;; c++) {
+    if (*c >= '0' && *c <= '9') {
+      number = number < 100 ? number * 10 + (uint32_t)(*c - '0') : number;
+    } else if (*c == ',' || *c == '\0') {
+      if (number >= 1 && number <= MAX_DOORS) {
+        mask |= 1u << (number - 1);
+      }
+      if (*c == '\0') break;
+      number = 0;
+    } else {
+      return INVALID_DONGLE_ID;
+    }
+  }
+  if (mask == 0) {
+    return INVALID_DONGLE_ID;
+  }
+  // All MAX_DOORS listed is "every door" (and keeps 0x3FFFFFF:1..6 apart from INVALID_DONGLE_ID)
+  return mask == (1u << MAX_DOORS) - 1 ? 0 : mask;
+}
+
+static uint32_t decodeDongleEntry(char* token, AccessSchedule* schedule, bool* hasSchedule) {
+  // "<ID>[:<doors>][@<windows>][!<expiry>]"; the suffixes are split off back to front
+  char* expiry = strchr(token, '!');
+  if (expiry != nullptr) {
+    *expiry++ = '\0';
+  }
+  char* windows = strchr(token, '@');
+  if (windows != nullptr) {
+    *windows++ = '\0';
+  }
+  char* doors = strchr(token, ':');
+  if (doors != nullptr) {
+    *doors++ = '\0';
+  }
+  uint32_t dongleId = decodeDongleId(token);
+  if (dongleId == INVALID_DONGLE_ID) {
+    return INVALID_DONGLE_ID;
+  }
+  uint32_t mask = doors != nullptr ? decodeDoorMask(doors) : 0;
+  if (mask == INVALID_DONGLE_ID) {
+    return INVALID_DONGLE_ID;
+  }
+  *hasSchedule = windows != nullptr || expiry != nullptr;
+  if (*hasSchedule && !compileAccessSchedule(windows, expiry, schedule)) {
+    return INVALID_DONGLE_ID;
+  }
+  return makeDongleEntry(dongleId, mask);
+}
+
+bool DongleListParser::feed(const char* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (!onChar(data[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DongleListParser::finish(DongleTable* added, DongleTable* removed) {
+  if (_status != DONE) {
+    if (_status == PARSING) {
+      _status = INVALID_INPUT;  // Truncated or empty input
+    }
+    return false;
+  }
+  _added.build(added);
+  if (removed != nullptr) {
+    _removed.build(removed);
+  }
+  return true;
+}
+
+const char* DongleListParser::statusString() const {
+  switch (_status) {
+    case PARSING: return "Incomplete";
+    case DONE: return "Ok";
+    case INVALID_INPUT: return "InvalidInput";
+    case TOO_DEEP: return "TooDeep";
+    case NO_MEMORY: return "NoMemory";
+  }
+  return "Unknown";
+}
+
+bool DongleListParser::onChar(char c) {
+  if (_status != PARSING && _status != DONE) {
+    return false;
+  }
+  switch (_lexer) {
+    case IN_STRING:
+      if (c == '"') {
+        _lexer = BETWEEN_TOKENS;
+        onStringComplete();
+      } else if (c == '\\') {
+        _lexer = IN_ESCAPE;
+        _tokenOverflow = true;  // IDs and known keys never contain escapes
+      } else if (_tokenLength < MAX_TOKEN) {
+        _token[_tokenLength++] = c;
+      } else {
+        _tokenOverflow = true;
+      }
+      return _status != NO_MEMORY;
+
+    case IN_ESCAPE:
+      _lexer = IN_STRING;  // \uXXXX digits are consumed as ordinary (overflowed) chars
+      return true;
+
+    case IN_SCALAR:
+      if (c >= '0' && c <= '9') {
+        _number = _number * 10 + (uint32_t)(c - '0');
+        return true;
+      }
+      if ((c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E') {
+        return true;
+      }
+      _lexer = BETWEEN_TOKENS;
+      onScalarComplete();
+      return onStructural(c);
+
+    case BETWEEN_TOKENS:
+      return onStructural(c);
+  }
+  return fail(INVALID_INPUT);
+}
+
+bool DongleListParser::onValueStart() {
+  if (_expect != VALUE && _expect != VALUE_OR_CLOSE) {
+    return fail(INVALID_INPUT);
+  }
+  _expect = COMMA_OR_CLOSE;
+  return true;
+}
+
+bool DongleListParser::onStructural(char c) {
+  if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+    return true;
+  }
+  if (_status == DONE) {
+    return fail(INVALID_INPUT);  // Garbage after the closing bracket
+  }
+
+  if (c == '[' || c == '{') {
+    if (!onValueStart()) return false;
+    if (c == '{') {
+      if (_depth != 0) return fail(INVALID_INPUT);  // Only the delta envelope is an object
+      _isDelta = true;
+    }
+    if (_depth >= MAX_DEPTH) return fail(TOO_DEEP);
+    _started = true;
+    _depth++;
+    if (c == '{') {
+      _objectLevels |= (uint8_t)(1u << (_depth - 1));
+      _expect = KEY_OR_CLOSE;
+    } else {
+      _objectLevels &= (uint8_t)~(1u << (_depth - 1));
+      _expect = VALUE_OR_CLOSE;
+    }
+    return true;
+  }
+  if (!_started) {
+    return fail(INVALID_INPUT);  // The document must be an array or object
+  }
+
+  bool inObject = (_objectLevels >> (_depth - 1)) & 1u;
+  if (c == ']' || c == '}') {
+    // "[]" and "{}" are fine, "[x,]" and {"k":} are not
+    if ((c == '}') != inObject) return fail(INVALID_INPUT);
+    if (_expect != VALUE_OR_CLOSE && _expect != KEY_OR_CLOSE && _expect != COMMA_OR_CLOSE) {
+      return fail(INVALID_INPUT);
+    }
+    _depth--;
+    _expect = COMMA_OR_CLOSE;
+    if (_depth == 0) {
+      _status = DONE;
+    }
+    return true;
+  }
+  if (c == ',') {
+    if (_expect != COMMA_OR_CLOSE) return fail(INVALID_INPUT);
+    _expect = inObject ? KEY : VALUE;
+    return true;
+  }
+  if (c == ':') {
+    if (_expect != COLON) return fail(INVALID_INPUT);
+    _expect = VALUE;
+    return true;
+  }
+  if (c == '"') {
+    if (_expect == KEY || _expect == KEY_OR_CLOSE) {
+      _tokenIsKey = true;
+      _expect = COLON;
+    } else if (!onValueStart()) {
+      return false;
+    }
+    _lexer = IN_STRING;
+    _tokenLength = 0;
+    _tokenOverflow = false;
+    return true;
+  }
+  if ((c >= '0' && c <= '9') || c == '-' || c == 't' || c == 'f' || c == 'n') {
+    if (!onValueStart()) return false;
+    if (_isDelta && _depth == 1 && _field == FIELD_RESET) {
+      _reset = (c == 't');
+    }
+    _number = (c >= '0' && c <= '9') ? (uint32_t)(c - '0') : 0;
+    _lexer = IN_SCALAR;
+    return true;
+  }
+  return fail(INVALID_INPUT);
+}
+
+void DongleListParser::onScalarComplete() {
+  if (_isDelta && _depth == 1) {
+    if (_field == FIELD_VERSION) _version = _number;
+    else if (_field == FIELD_HASH) _hash = _number;
+    return;
+  }
+  _skipped++;  // Numbers, true/false/null inside a list: not an ID
+}
+
+DongleTableBuilder* DongleListParser::targetBuilder() {
+  if (!_isDelta) {
+    return &_added;
+  }
+  if (_depth >= 2 && _field == FIELD_ADDED) return &_added;
+  if (_depth >= 2 && _field == FIELD_REMOVED) return &_removed;
+  return nullptr;
+}
+
+void DongleListParser::onStringComplete() {
+  _token[_tokenLength] = '\0';
+
+  if (_tokenIsKey) {
+    _tokenIsKey = false;
+    _field = FIELD_OTHER;
+    if (_tokenOverflow || _depth != 1) return;
+    if (strcmp(_token, "version") == 0) _field = FIELD_VERSION;
+    else if (strcmp(_token, "hash") == 0) _field = FIELD_HASH;
+    else if (strcmp(_token, "reset") == 0) _field = FIELD_RESET;
+    else if (strcmp(_token, "added") == 0) _field = FIELD_ADDED;
+    else if (strcmp(_token, "removed") == 0) _field = FIELD_REMOVED;
+    return;
+  }
+
+  DongleTableBuilder* target = targetBuilder();
+  if (target == nullptr) {
+    return;
+  }
+  if (_tokenOverflow) {
+    _skipped++;
+    return;
+  }
+  if (strcmp(_token, OPEN_FOR_ALL_DONGLES) == 0) {
+    target->setOpenForAll();
+    return;
+  }
+  AccessSchedule schedule;
+  bool hasSchedule = false;
+  uint32_t entry = decodeDongleEntry(_token, &schedule, &hasSchedule);
+  if (entry == INVALID_DONGLE_ID) {
+    _skipped++;
+    return;
+  }
+  if (!target->add(entry, hasSchedule ? &schedule : nullptr)) {
+    fail(NO_MEMORY);
+  }
+}
@@ -0,0 +1,98 @@
+#ifndef DONGLE_LIST_PARSER_H
+#define DONGLE_LIST_PARSER_H
+
+#include "Config.h"
+#include "DongleTable.h"
+
+// =============================================================
+// DongleListParser
+// Incremental parser for the dongle list responses of googleScript.
+// Bytes are fed in arbitrary chunks as they arrive from the network;
+// every ID string is decoded on the fly into a DongleTableBuilder.
+// No payload buffer, single pass, constant stack: the only per-list
+// memory is the resulting 4-byte-per-ID table.
+//
+// An ID string may name the doors it opens: "0101...:1,3" (door
+// numbers from 1, see DOORS). Without the suffix it opens every door.
+// It may further carry a schedule and an expiry date (AccessSchedule.h):
+//   "<ID>[:<doors>][@<windows>][!<YYYY-MM-DD>]"   e.g. "0101...:2@1-5/7-19!2026-12-31"
+// An entry whose suffix does not parse is skipped, never widened.
+//
+// Accepted documents:
+//   read_pa:        [["0101..."], ...]  (googleScript rows) or ["0101...", ...]
+//   read_pa_delta:  {"version":N,"hash":H,"reset":bool,"added":[...],"removed":[...]}
+// Non-ID strings and scalars inside the lists are skipped, unknown
+// object keys are ignored, nested objects are rejected.
+// =============================================================
+class DongleListParser {
+  public:
+    enum Status : uint8_t {
+      PARSING,       // More input expected
+      DONE,          // Outermost array/object closed
+      INVALID_INPUT, // Not one of the accepted documents
+      TOO_DEEP,      // Nesting exceeds MAX_DEPTH
+      NO_MEMORY,     // Builder could not grow
+    };
+
+    static constexpr int MAX_DEPTH = 4;
+
+    // Feed the next chunk. Returns false once the parser has failed.
+    bool feed(const char* data, size_t length);
+
+    // Complete parsing: on success moves the IDs into the tables and returns true.
+    // For a plain list everything lands in added; removed may be nullptr then.
+    bool finish(DongleTable* added, DongleTable* removed = nullptr);
+
+    Status status() const { return _status; }
+    const char* statusString() const;
+    size_t skippedCount() const { return _skipped + _added.droppedCount() + _removed.droppedCount(); }
+
+    // read_pa_delta fields (zero/false for a plain list)
+    bool isDelta() const { return _isDelta; }
+    bool isReset() const { return _reset; }
+    uint32_t version() const { return _version; }
+    uint32_t hash() const { return _hash; }
+
+  private:
+    enum Lexer : uint8_t { BETWEEN_TOKENS, IN_STRING, IN_ESCAPE, IN_SCALAR };
+    enum Expect : uint8_t { VALUE_OR_CLOSE, VALUE, COMMA_OR_CLOSE, KEY_OR_CLOSE, KEY, COLON };
+    enum Field : uint8_t { FIELD_OTHER, FIELD_VERSION, FIELD_HASH, FIELD_RESET, FIELD_ADDED, FIELD_REMOVED };
+
+    // Longest string we need to recognize: an ID with every door listed
+    // (":1,2,..."), a schedule and an expiry, or the OPEN_FOR_ALL_DONGLES word
+    static constexpr size_t MAX_ENTRY_TOKEN =
+        CharArrayDongleIdSize - 1 + 2 * MAX_DOORS + 1 + ACCESS_WINDOWS_TEXT_MAX + 1 + ACCESS_EXPIRY_TEXT_MAX;
+    static constexpr size_t MAX_TOKEN = sizeof(OPEN_FOR_ALL_DONGLES) - 1 > MAX_ENTRY_TOKEN
+                                          ? sizeof(OPEN_FOR_ALL_DONGLES) - 1
+                                          : MAX_ENTRY_TOKEN;
+
+    DongleTableBuilder _added;
+    DongleTableBuilder _removed;
+    Status _status = PARSING;
+    Lexer _lexer = BETWEEN_TOKENS;
+    Expect _expect = VALUE;  // Top level: only the opening '[' or '{' is a valid "value"
+    Field _field = FIELD_OTHER;
+    bool _started = false;
+    bool _isDelta = false;
+    bool _reset = false;
+    bool _tokenIsKey = false;
+    bool _tokenOverflow = false;
+    uint8_t _depth = 0;
+    uint8_t _objectLevels = 0;  // Bit (d - 1) set if nesting level d is an object
+    uint8_t _tokenLength = 0;
+    uint32_t _version = 0;
+    uint32_t _hash = 0;
+    uint32_t _number = 0;  // Scalar being accumulated (version/hash)
+    size_t _skipped = 0;
+    char _token[MAX_TOKEN + 1];
+
+    bool fail(Status status) { _status = status; return false; }
+    bool onChar(char c);
+    bool onStructural(char c);
+    bool onValueStart();
+    void onScalarComplete();
+    void onStringComplete();
+    DongleTableBuilder* targetBuilder();
+};
+
+#endif // DONGLE_LIST_PARSER_H
@@ -0,0 +1,172 @@
+#include "DongleStore.h"
+#include "DebugService.h"
+
+static uint32_t headerCrc(const DongleStoreHeader& header) {
+  return crc32Update(0, &header, offsetof(DongleStoreHeader, headerCrc));
+}
+
+// Schedule indices are padded so the AccessSchedules after them stay aligned
+static size_t scheduleIndexBytes(size_t count) {
+  return (count + 3) & ~(size_t)3;
+}
+
+static size_t payloadBytes(size_t count, size_t scheduleCount) {
+  size_t bytes = count * sizeof(uint32_t);
+  if (scheduleCount > 0) {
+    bytes += scheduleIndexBytes(count) + scheduleCount * sizeof(AccessSchedule);
+  }
+  return bytes;
+}
+
+// Copy through RAM: the source may be a view of the other slot, and flash
+// cannot be read through the cache while it is being written
+static bool writeStaged(const esp_partition_t* partition, size_t offset, const void* data, size_t length) {
+  const uint8_t* src = static_cast<const uint8_t*>(data);
+  uint8_t chunk[256];
+  for (size_t done = 0; done < length; done += sizeof(chunk)) {
+    size_t part = length - done < sizeof(chunk) ? length - done : sizeof(chunk);
+    memcpy(chunk, src + done, part);
+    if (esp_partition_write(partition, offset + done, chunk, part) != ESP_OK) {
+      return false;
+    }
+  }
+  return true;
+}
+
+DongleStore::~DongleStore() {
+  if (_mapped != nullptr) {
+    esp_partition_munmap(_mapHandle);
+  }
+}
+
+bool DongleStore::begin(const char* label) {
+  if (_mapped != nullptr) {
+    esp_partition_munmap(_mapHandle);
+    _mapped = nullptr;
+  }
+  _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)DONGLE_PARTITION_SUBTYPE, label);
+  if (_partition == nullptr) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Dongle partition '", label, "' not found — check partitions.csv");
+    return false;
+  }
+  const void* mapped = nullptr;
+  if (esp_partition_mmap(_partition, 0, _partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &_mapHandle) != ESP_OK) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Dongle partition mmap failed");
+    _partition = nullptr;
+    return false;
+  }
+  _mapped = static_cast<const uint8_t*>(mapped);
+  _slotSize = (_partition->size / 2) & ~(size_t)(SPI_FLASH_SEC_SIZE - 1);
+
+  // Newest valid slot wins (sequence compared wrap-around safe)
+  _activeSlot = -1;
+  for (int slot = 0; slot < 2; slot++) {
+    const DongleStoreHeader* header = validHeader(slot);
+    if (header != nullptr && (_activeSlot < 0 || (int32_t)(header->sequence - _sequence) > 0)) {
+      _activeSlot = slot;
+      _sequence = header->sequence;
+    }
+  }
+  return true;
+}
+
+const DongleStoreHeader* DongleStore::validHeader(int slot) const {
+  const uint8_t* base = _mapped + slot * _slotSize;
+  const DongleStoreHeader* header = reinterpret_cast<const DongleStoreHeader*>(base);
+  bool withSchedules = header->formatVersion == DONGLE_STORE_FORMAT_VERSION_SCHEDULES;
+  if (header->magic != DONGLE_STORE_MAGIC ||
+      (header->formatVersion != DONGLE_STORE_FORMAT_VERSION && !withSchedules) ||
+      header->headerSize != sizeof(DongleStoreHeader) ||
+      header->count > capacity() ||
+      (withSchedules ? header->scheduleCount == 0 || header->scheduleCount > DONGLE_MAX_SCHEDULES
+                     : header->scheduleCount != 0) ||
+      sizeof(DongleStoreHeader) + payloadBytes(header->count, header->scheduleCount) > _slotSize ||
+      header->headerCrc != headerCrc(*header)) {
+    return nullptr;
+  }
+  if (crc32Update(0, base + sizeof(DongleStoreHeader), payloadBytes(header->count, header->scheduleCount)) != header->idsCrc) {
+    return nullptr;
+  }
+  return header;
+}
+
+bool DongleStore::load(DongleTable* table, uint32_t* listVersion) const {
+  if (_activeSlot < 0) {
+    return false;
+  }
+  const uint8_t* base = _mapped + _activeSlot * _slotSize;
+  const DongleStoreHeader* header = reinterpret_cast<const DongleStoreHeader*>(base);
+  const uint8_t* ids = base + sizeof(DongleStoreHeader);
+  const uint8_t* scheduleOf = ids + header->count * sizeof(uint32_t);
+  const uint8_t* schedules = scheduleOf + scheduleIndexBytes(header->count);
+  table->view(reinterpret_cast<const uint32_t*>(ids), header->count, (header->flags & DONGLE_STORE_FLAG_OPEN_FOR_ALL) != 0,
+              scheduleOf, reinterpret_cast<const AccessSchedule*>(schedules), (uint8_t)header->scheduleCount);
+  *listVersion = header->listVersion;
+  return true;
+}
+
+bool DongleStore::save(const DongleTable& table, uint32_t listVersion) {
+  if (_partition == nullptr) {
+    return false;
+  }
+  size_t scheduleCount = table.scheduleCount();
+  size_t bytes = payloadBytes(table.size(), scheduleCount);
+  if (table.size() > capacity() || sizeof(DongleStoreHeader) + bytes > _slotSize) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Dongle table too large for partition: ", table.size(), " > ", capacity());
+    return false;
+  }
+
+  int slot = _activeSlot == 0 ? 1 : 0;
+  size_t offset = slot * _slotSize;
+  size_t idBytes = table.size() * sizeof(uint32_t);
+  size_t eraseBytes = (sizeof(DongleStoreHeader) + bytes + SPI_FLASH_SEC_SIZE - 1) & ~(size_t)(SPI_FLASH_SEC_SIZE - 1);
+  if (esp_partition_erase_range(_partition, offset, eraseBytes) != ESP_OK) {
+    return false;
+  }
+
+  // Payload first: IDs, then schedule indices (zero padded) and schedules
+  size_t pos = offset + sizeof(DongleStoreHeader);
+  if (!writeStaged(_partition, pos, table.ids(), idBytes)) {
+    return false;
+  }
+  uint32_t payloadCrc = crc32Update(0, table.ids(), idBytes);
+  if (scheduleCount > 0) {
+    const uint8_t padding[3] = {};
+    size_t paddingBytes = scheduleIndexBytes(table.size()) - table.size();
+    size_t schedulesPos = pos + idBytes + scheduleIndexBytes(table.size());
+    if (!writeStaged(_partition, pos + idBytes, table.scheduleIndices(), table.size()) ||
+        (paddingBytes > 0 && esp_partition_write(_partition, pos + idBytes + table.size(), padding, paddingBytes) != ESP_OK) ||
+        !writeStaged(_partition, schedulesPos, table.schedules(), scheduleCount * sizeof(AccessSchedule))) {
+      return false;
+    }
+    payloadCrc = crc32Update(payloadCrc, table.scheduleIndices(), table.size());
+    payloadCrc = crc32Update(payloadCrc, padding, paddingBytes);
+    payloadCrc = crc32Update(payloadCrc, table.schedules(), scheduleCount * sizeof(AccessSchedule));
+  }
+
+  // Header last: commits the slot
+  DongleStoreHeader header;
+  header.magic = DONGLE_STORE_MAGIC;
+  header.formatVersion = scheduleCount > 0 ? DONGLE_STORE_FORMAT_VERSION_SCHEDULES : DONGLE_STORE_FORMAT_VERSION;
+  header.headerSize = sizeof(DongleStoreHeader);
+  header.sequence = _sequence + 1;
+  header.count = table.size();
+  header.flags = table.isOpenForAll() ? DONGLE_STORE_FLAG_OPEN_FOR_ALL : 0;
+  header.scheduleCount = (uint16_t)scheduleCount;
+  header.listVersion = listVersion;
+  header.idsCrc = payloadCrc;
+  header.headerCrc = headerCrc(header);
+  if (esp_partition_write(_partition, offset, &header, sizeof(header)) != ESP_OK ||
+      validHeader(slot) == nullptr) {
+    return false;
+  }
+
+  _activeSlot = slot;
+  _sequence = header.sequence;
+  DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Dongle table saved to slot ", slot, " (", bytes, " bytes, seq ", _sequence, ")");
+  return true;
+}
+
+size_t DongleStore::capacity() const {
+  return _slotSize > sizeof(DongleStoreHeader) ? (_slotSize - sizeof(DongleStoreHeader)) / sizeof(uint32_t) : 0;
+}
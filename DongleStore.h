@@ -0,0 +1,79 @@
+#ifndef DONGLE_STORE_H
+#define DONGLE_STORE_H
+
+#include "Config.h"
+#include "DongleTable.h"
+#include <esp_partition.h>
+
+// =============================================================
+// DongleStore
+// Persists the dongle table in its own flash partition and serves it
+// memory-mapped: load() returns a DongleTable *view* into flash, so
+// lookups run directly against the mapped partition — no RAM copy and
+// no parsing at boot.
+//
+// The partition is split into two slots (A/B). Each slot holds:
+//   DongleStoreHeader (32 bytes, little-endian) | uint32_t ids[count] (sorted, unique)
+// and, for a table with schedules (format version 2):
+//   | uint8_t scheduleOf[count], padded to 4 bytes | AccessSchedule schedules[scheduleCount]
+// Tables without schedules are still written as version 1, readable by
+// older firmware; a version 2 slot is invalid there (it would lose the
+// restrictions) and that firmware syncs the full list instead.
+// save() always writes the slot that is not active: erase, IDs, header
+// last. The header carries a sequence number and two CRCs, so a write
+// torn by a reset leaves an invalid slot and the previous one wins.
+// Single writer (network task; setup before it starts).
+// =============================================================
+
+struct DongleStoreHeader {
+  uint32_t magic;          // DONGLE_STORE_MAGIC
+  uint16_t formatVersion;  // DONGLE_STORE_FORMAT_VERSION
+  uint16_t headerSize;     // sizeof(DongleStoreHeader)
+  uint32_t sequence;       // Incremented per save; the valid slot with the newest wins
+  uint32_t count;          // Number of IDs following the header
+  uint16_t flags;          // DONGLE_STORE_FLAG_*
+  uint16_t scheduleCount;  // AccessSchedules after the IDs (version 2), 0 in version 1
+  uint32_t listVersion;    // googleScript list version (read_pa_delta), 0 = unknown
+  uint32_t idsCrc;         // crc32Update(0, payload) over everything after the header
+  uint32_t headerCrc;      // CRC of all fields above
+};
+static_assert(sizeof(DongleStoreHeader) == 32, "DongleStoreHeader is an on-flash format");
+
+constexpr uint32_t DONGLE_STORE_MAGIC = 0x4C474E44;  // "DNGL"
+constexpr uint16_t DONGLE_STORE_FORMAT_VERSION = 1;            // IDs only
+constexpr uint16_t DONGLE_STORE_FORMAT_VERSION_SCHEDULES = 2;  // IDs + schedules
+constexpr uint32_t DONGLE_STORE_FLAG_OPEN_FOR_ALL = 1u << 0;
+
+class DongleStore {
+  private:
+    const esp_partition_t* _partition = nullptr;
+    const uint8_t* _mapped = nullptr;
+    esp_partition_mmap_handle_t _mapHandle = 0;
+    size_t _slotSize = 0;
+    int _activeSlot = -1;  // Slot of the newest valid table, -1 if none
+    uint32_t _sequence = 0;
+
+    const DongleStoreHeader* validHeader(int slot) const;
+
+  public:
+    DongleStore() = default;
+    ~DongleStore();
+    DongleStore(const DongleStore&) = delete;
+    DongleStore& operator=(const DongleStore&) = delete;
+
+    // Find and map the partition, select the newest valid slot. False if the partition is missing.
+    bool begin(const char* label = DONGLE_PARTITION_LABEL);
+
+    // Point table at the active slot (zero-copy). False if no valid table is stored.
+    // The view stays valid until the slot is overwritten, i.e. two save() calls later.
+    bool load(DongleTable* table, uint32_t* listVersion) const;
+
+    // Write table into the inactive slot and make it active. The table may itself
+    // be a view of the active slot.
+    bool save(const DongleTable& table, uint32_t listVersion);
+
+    // IDs that fit into one slot (without schedules)
+    size_t capacity() const;
+};
+
+#endif // DONGLE_STORE_H
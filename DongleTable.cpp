@@ -0,0 +1,435 @@
+#include "DongleTable.h"
+#include <algorithm>
+#include <new>
+
+void formatDongleId(uint32_t dongleId, char dest[CharArrayDongleIdSize]) {
+  for (int i = 0; i < DONGLE_ID_BITS; i++) {
+    dest[i] = ((dongleId >> (DONGLE_ID_BITS - 1 - i)) & 1) ? '1' : '0';
+  }
+  dest[DONGLE_ID_BITS] = '\0';
+}
+
+void DongleTable::release() {
+  if (_owned) {
+    delete[] _ids;
+    delete[] _scheduleOf;
+    delete[] _schedules;
+  }
+  _ids = nullptr;
+  _scheduleOf = nullptr;
+  _schedules = nullptr;
+  _count = 0;
+  _scheduleCount = 0;
+}
+
+static bool entryIdLess(uint32_t a, uint32_t b) {
+  return dongleEntryId(a) < dongleEntryId(b);
+}
+
+// In-place heapsort by ID that carries the schedule index along (std::sort
+// cannot permute two arrays without a temporary copy)
+static void siftDown(uint32_t* ids, uint8_t* scheduleOf, size_t root, size_t count) {
+  for (;;) {
+    size_t child = 2 * root + 1;
+    if (child >= count) return;
+    if (child + 1 < count && entryIdLess(ids[child], ids[child + 1])) child++;
+    if (!entryIdLess(ids[root], ids[child])) return;
+    std::swap(ids[root], ids[child]);
+    std::swap(scheduleOf[root], scheduleOf[child]);
+    root = child;
+  }
+}
+
+static void sortEntries(uint32_t* ids, uint8_t* scheduleOf, size_t count) {
+  for (size_t i = count / 2; i-- > 0;) {
+    siftDown(ids, scheduleOf, i, count);
+  }
+  for (size_t end = count; end-- > 1;) {
+    std::swap(ids[0], ids[end]);
+    std::swap(scheduleOf[0], scheduleOf[end]);
+    siftDown(ids, scheduleOf, 0, end);
+  }
+}
+
+// Slot (1-based) of the union of slots a and b, appended to *schedules if new;
+// 0 if the list is full or out of memory
+static uint8_t mergedScheduleSlot(AccessSchedule** schedules, uint8_t* count, uint8_t a, uint8_t b) {
+  AccessSchedule merged = mergeAccessSchedules((*schedules)[a - 1], (*schedules)[b - 1]);
+  for (uint8_t i = 0; i < *count; i++) {
+    if (sameAccessSchedule((*schedules)[i], merged)) {
+      return i + 1;
+    }
+  }
+  if (*count == DONGLE_MAX_SCHEDULES) {
+    return 0;
+  }
+  AccessSchedule* grown = new (std::nothrow) AccessSchedule[*count + 1];
+  if (grown == nullptr) {
+    return 0;
+  }
+  memcpy(grown, *schedules, *count * sizeof(AccessSchedule));
+  grown[*count] = merged;
+  delete[] *schedules;
+  *schedules = grown;
+  return ++*count;
+}
+
+void DongleTable::adopt(uint32_t* ids, uint8_t* scheduleOf, size_t count, AccessSchedule* schedules,
+                        uint8_t scheduleCount, bool openForAll) {
+  release();
+  if (ids != nullptr && count > 0) {
+    if (scheduleOf != nullptr) {
+      sortEntries(ids, scheduleOf, count);
+    } else {
+      std::sort(ids, ids + count, entryIdLess);
+    }
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (unique > 0 && dongleEntryId(ids[unique - 1]) == dongleEntryId(ids[i])) {
+        uint32_t doors = dongleEntryDoors(ids[unique - 1]);
+        uint32_t more = dongleEntryDoors(ids[i]);
+        ids[unique - 1] = makeDongleEntry(ids[i], doors == 0 || more == 0 ? 0 : doors | more);
+        if (scheduleOf != nullptr) {
+          uint8_t kept = scheduleOf[unique - 1];
+          uint8_t other = scheduleOf[i];
+          if (kept == 0 || other == 0) {
+            scheduleOf[unique - 1] = 0;
+          } else if (kept != other) {
+            // Without room for the union the first schedule stays: less access, never more
+            uint8_t merged = mergedScheduleSlot(&schedules, &scheduleCount, kept, other);
+            scheduleOf[unique - 1] = merged != 0 ? merged : kept;
+          }
+        }
+      } else {
+        if (scheduleOf != nullptr) {
+          scheduleOf[unique] = scheduleOf[i];
+        }
+        ids[unique++] = ids[i];
+      }
+    }
+    count = unique;
+  } else {
+    count = 0;
+  }
+  if (scheduleCount == 0) {
+    delete[] scheduleOf;
+    delete[] schedules;
+    scheduleOf = nullptr;
+    schedules = nullptr;
+  }
+  _ids = ids;
+  _scheduleOf = scheduleOf;
+  _schedules = schedules;
+  _count = count;
+  _scheduleCount = scheduleCount;
+  _openForAll = openForAll;
+  _owned = true;
+}
+
+void DongleTable::view(const uint32_t* ids, size_t count, bool openForAll, const uint8_t* scheduleOf,
+                       const AccessSchedule* schedules, uint8_t scheduleCount) {
+  release();
+  _ids = ids;
+  _scheduleOf = scheduleCount > 0 ? scheduleOf : nullptr;
+  _schedules = scheduleCount > 0 ? schedules : nullptr;
+  _count = count;
+  _scheduleCount = scheduleCount;
+  _openForAll = openForAll;
+  _owned = false;
+}
+
+void DongleTable::swap(DongleTable& other) {
+  std::swap(_ids, other._ids);
+  std::swap(_scheduleOf, other._scheduleOf);
+  std::swap(_schedules, other._schedules);
+  std::swap(_count, other._count);
+  std::swap(_scheduleCount, other._scheduleCount);
+  std::swap(_openForAll, other._openForAll);
+  std::swap(_owned, other._owned);
+}
+
+// Index (1-based) of schedule in list, appended if new; 0 if the list is full
+static uint8_t findOrAppendSchedule(AccessSchedule* list, uint8_t* count, const AccessSchedule& schedule) {
+  for (uint8_t i = 0; i < *count; i++) {
+    if (sameAccessSchedule(list[i], schedule)) {
+      return i + 1;
+    }
+  }
+  if (*count == DONGLE_MAX_SCHEDULES) {
+    return 0;
+  }
+  list[(*count)++] = schedule;
+  return *count;
+}
+
+bool DongleTable::assignDelta(const DongleTable& base, const DongleTable& added, const DongleTable& removed) {
+  size_t capacity = base._count + added._count;
+  uint32_t* ids = new (std::nothrow) uint32_t[capacity > 0 ? capacity : 1];
+  if (ids == nullptr) {
+    return false;
+  }
+  uint8_t* scheduleOf = nullptr;
+  AccessSchedule* schedules = nullptr;
+  uint8_t scheduleCount = 0;
+  if (base._scheduleCount > 0 || added._scheduleCount > 0) {
+    size_t scheduleCapacity = std::min(base._scheduleCount + added._scheduleCount, DONGLE_MAX_SCHEDULES);
+    scheduleOf = new (std::nothrow) uint8_t[capacity];
+    schedules = new (std::nothrow) AccessSchedule[scheduleCapacity];
+    if (scheduleOf == nullptr || schedules == nullptr) {
+      delete[] ids;
+      delete[] scheduleOf;
+      delete[] schedules;
+      return false;
+    }
+  }
+
+  size_t b = 0, a = 0, r = 0, count = 0;
+  while (b < base._count || a < added._count) {
+    uint32_t baseId = b < base._count ? dongleEntryId(base._ids[b]) : UINT32_MAX;
+    uint32_t addedId = a < added._count ? dongleEntryId(added._ids[a]) : UINT32_MAX;
+    const DongleTable* source;
+    size_t index;
+    if (addedId <= baseId) {
+      source = &added;
+      index = a++;
+      if (addedId == baseId) {
+        b++;  // Replaced
+      }
+    } else {
+      while (r < removed._count && dongleEntryId(removed._ids[r]) < baseId) {
+        r++;
+      }
+      if (r < removed._count && dongleEntryId(removed._ids[r]) == baseId) {
+        b++;
+        continue;
+      }
+      source = &base;
+      index = b++;
+    }
+
+    if (scheduleOf != nullptr) {
+      const AccessSchedule* schedule = source->scheduleAt(index);
+      scheduleOf[count] = schedule != nullptr ? findOrAppendSchedule(schedules, &scheduleCount, *schedule) : 0;
+      if (schedule != nullptr && scheduleOf[count] == 0) {
+        delete[] ids;
+        delete[] scheduleOf;
+        delete[] schedules;
+        return false;
+      }
+    }
+    ids[count++] = source->_ids[index];
+  }
+
+  bool openForAll = (base._openForAll || added._openForAll) && !removed._openForAll;
+  release();
+  if (scheduleCount == 0) {
+    delete[] scheduleOf;
+    delete[] schedules;
+    scheduleOf = nullptr;
+    schedules = nullptr;
+  }
+  _ids = ids;
+  _scheduleOf = scheduleOf;
+  _schedules = schedules;
+  _count = count;
+  _scheduleCount = scheduleCount;
+  _openForAll = openForAll;
+  _owned = true;
+  return true;
+}
+
+int DongleTable::find(uint32_t dongleId) const {
+  if (_count == 0) {
+    return -1;
+  }
+  const uint32_t* end = _ids + _count;
+  const uint32_t* it = std::lower_bound(_ids, end, dongleId,
+                                        [](uint32_t entry, uint32_t id) { return dongleEntryId(entry) < id; });
+  return it != end && dongleEntryId(*it) == dongleId ? (int)(it - _ids) : -1;
+}
+
+bool DongleTable::contains(uint32_t dongleId) const {
+  return find(dongleId) >= 0;
+}
+
+bool DongleTable::allows(uint32_t dongleId, uint8_t door, time_t now) const {
+  int index = find(dongleId);
+  if (index < 0) {
+    return false;
+  }
+  uint32_t doors = dongleEntryDoors(_ids[index]);
+  if (doors != 0 && !((doors >> door) & 1)) {
+    return false;
+  }
+  const AccessSchedule* schedule = scheduleAt(index);
+  return schedule == nullptr || accessScheduleAllows(*schedule, accessTimeAt(now));
+}
+
+bool DongleTable::equals(const DongleTable& other) const {
+  if (_openForAll != other._openForAll || _count != other._count || !std::equal(_ids, _ids + _count, other._ids)) {
+    return false;
+  }
+  if (_scheduleOf == nullptr && other._scheduleOf == nullptr) {
+    return true;
+  }
+  for (size_t i = 0; i < _count; i++) {
+    const AccessSchedule* mine = scheduleAt(i);
+    const AccessSchedule* theirs = other.scheduleAt(i);
+    if ((mine == nullptr) != (theirs == nullptr) || (mine != nullptr && !sameAccessSchedule(*mine, *theirs))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t DongleTable::hash() const {
+  uint32_t crc = crc32Update(0, _ids, _count * sizeof(uint32_t));
+  for (size_t i = 0; _scheduleOf != nullptr && i < _count; i++) {
+    const AccessSchedule* schedule = scheduleAt(i);
+    if (schedule != nullptr) {
+      crc = crc32Update(crc, &_ids[i], sizeof(uint32_t));
+      crc = crc32Update(crc, schedule, sizeof(AccessSchedule));
+    }
+  }
+  if (_openForAll) {
+    const uint32_t openForAllMarker = UINT32_MAX;
+    crc = crc32Update(crc, &openForAllMarker, sizeof(openForAllMarker));
+  }
+  return crc;
+}
+
+DongleTableBuilder::~DongleTableBuilder() {
+  delete[] _ids;
+  delete[] _scheduleOf;
+  delete[] _schedules;
+}
+
+int DongleTableBuilder::internSchedule(const AccessSchedule& schedule) {
+  for (uint8_t i = 0; i < _scheduleCount; i++) {
+    if (sameAccessSchedule(_schedules[i], schedule)) {
+      return i + 1;
+    }
+  }
+  if (_scheduleCount == DONGLE_MAX_SCHEDULES) {
+    return 0;
+  }
+  if (_scheduleCount == _scheduleCapacity) {
+    int newCapacity = std::min(_scheduleCapacity > 0 ? _scheduleCapacity * 2 : 8, DONGLE_MAX_SCHEDULES);
+    AccessSchedule* grown = new (std::nothrow) AccessSchedule[newCapacity];
+    if (grown == nullptr) {
+      return -1;
+    }
+    if (_scheduleCount > 0) {
+      memcpy(grown, _schedules, _scheduleCount * sizeof(AccessSchedule));
+    }
+    delete[] _schedules;
+    _schedules = grown;
+    _scheduleCapacity = (uint8_t)newCapacity;
+  }
+  _schedules[_scheduleCount++] = schedule;
+  return _scheduleCount;
+}
+
+bool DongleTableBuilder::grow(size_t capacity, bool withSchedules) {
+  uint32_t* ids = new (std::nothrow) uint32_t[capacity];
+  uint8_t* scheduleOf = withSchedules ? new (std::nothrow) uint8_t[capacity] : nullptr;
+  if (ids == nullptr || (withSchedules && scheduleOf == nullptr)) {
+    delete[] ids;
+    delete[] scheduleOf;
+    return false;
+  }
+  if (_count > 0) {
+    memcpy(ids, _ids, _count * sizeof(uint32_t));
+  }
+  if (withSchedules) {
+    if (_scheduleOf != nullptr) {
+      memcpy(scheduleOf, _scheduleOf, _count);
+    } else {
+      memset(scheduleOf, 0, _count);  // Entries so far: any time
+    }
+  }
+  delete[] _ids;
+  delete[] _scheduleOf;
+  _ids = ids;
+  _scheduleOf = scheduleOf;
+  _capacity = capacity;
+  return true;
+}
+
+bool DongleTableBuilder::add(uint32_t entry, const AccessSchedule* schedule) {
+  uint8_t slot = 0;
+  if (schedule != nullptr) {
+    int interned = internSchedule(*schedule);
+    if (interned < 0) {
+      return false;
+    }
+    if (interned == 0) {
+      _dropped++;  // Without its schedule the dongle would get more access, not less
+      return true;
+    }
+    slot = (uint8_t)interned;
+  }
+  bool withSchedules = _scheduleOf != nullptr || slot != 0;
+  if (_count == _capacity || withSchedules != (_scheduleOf != nullptr)) {
+    size_t capacity = _count < _capacity ? _capacity : (_capacity > 0 ? _capacity * 2 : 64);
+    if (!grow(capacity, withSchedules)) {
+      return false;
+    }
+  }
+  if (_scheduleOf != nullptr) {
+    _scheduleOf[_count] = slot;
+  }
+  _ids[_count++] = entry;
+  return true;
+}
+
+void DongleTableBuilder::build(DongleTable* table) {
+  table->adopt(_ids, _scheduleOf, _count, _schedules, _scheduleCount, _openForAll);
+  _ids = nullptr;
+  _scheduleOf = nullptr;
+  _schedules = nullptr;
+  _count = 0;
+  _capacity = 0;
+  _dropped = 0;
+  _scheduleCount = 0;
+  _scheduleCapacity = 0;
+  _openForAll = false;
+}
+
+PublishedDongleTable::PublishedDongleTable() {
+  _readers[0].store(0);
+  _readers[1].store(0);
+}
+
+uint8_t PublishedDongleTable::pin() const {
+  // Lock-free: retries only if a publish happens between load and increment.
+  // The re-check after incrementing guarantees the writer sees our pin before
+  // it could reclaim the slot.
+  for (;;) {
+    uint8_t slot = _active.load();
+    _readers[slot].fetch_add(1);
+    if (_active.load() == slot) {
+      return slot;
+    }
+    _readers[slot].fetch_sub(1);
+  }
+}
+
+void PublishedDongleTable::unpin(uint8_t slot) const {
+  _readers[slot].fetch_sub(1);
+}
+
+void PublishedDongleTable::publish(DongleTable& table) {
+  uint8_t oldSlot = _active.load();
+  uint8_t newSlot = oldSlot ^ 1;
+
+  // The inactive slot is empty and unpinned (drained at the end of the previous publish)
+  _slots[newSlot].swap(table);
+  _active.store(newSlot);
+
+  // Grace period: readers that pinned the old slot finish within microseconds
+  while (_readers[oldSlot].load() != 0) {
+    vTaskDelay(1);
+  }
+  _slots[oldSlot].swap(table);
+}
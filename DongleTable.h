@@ -0,0 +1,218 @@
+#ifndef DONGLE_TABLE_H
+#define DONGLE_TABLE_H
+
+#include "Config.h"
+#include "AccessSchedule.h"
+#include "Secrets.h"
+#include <atomic>
+
+// =============================================================
+// Dongle ID Encoding
+// Dongle IDs travel as 26-char binary strings ("0100...") between the
+// sheet, NVS and the log. In RAM they are held as their integer value,
+// which is exactly what the Wiegand ISR assembles.
+// =============================================================
+
+constexpr uint32_t INVALID_DONGLE_ID = UINT32_MAX;  // Never produced by a 26-bit frame
+
+// Recursive (C++11 constexpr) so IDs from Secrets.h can be decoded at compile time.
+constexpr uint32_t decodeDongleIdStep(const char* str, int pos, uint32_t acc) {
+  return pos == DONGLE_ID_BITS
+           ? (str[pos] == '\0' ? acc : INVALID_DONGLE_ID)
+           : (str[pos] == '0' || str[pos] == '1')
+               ? decodeDongleIdStep(str, pos + 1, (acc << 1) | (uint32_t)(str[pos] - '0'))
+               : INVALID_DONGLE_ID;
+}
+
+// Decode a null-terminated 26-char binary string.
+// Returns INVALID_DONGLE_ID for anything else (wrong length, other characters).
+constexpr uint32_t decodeDongleId(const char* str) {
+  return str == nullptr ? INVALID_DONGLE_ID : decodeDongleIdStep(str, 0, 0);
+}
+
+// Format a 26-bit ID as binary string (MSB first) into dest. Zero heap allocation.
+void formatDongleId(uint32_t dongleId, char dest[CharArrayDongleIdSize]);
+
+// A table entry is the ID in the low DONGLE_ID_BITS plus a mask of the
+// doors it opens above them (bit d: DOORS[d]). Mask 0 means every door,
+// so lists without door numbers and tables stored by single-door
+// firmware keep their meaning.
+constexpr uint32_t DONGLE_ENTRY_ID_MASK = (1u << DONGLE_ID_BITS) - 1;
+
+constexpr uint32_t makeDongleEntry(uint32_t dongleId, uint32_t doorMask) {
+  return (doorMask << DONGLE_ID_BITS) | (dongleId & DONGLE_ENTRY_ID_MASK);
+}
+constexpr uint32_t dongleEntryId(uint32_t entry) { return entry & DONGLE_ENTRY_ID_MASK; }
+constexpr uint32_t dongleEntryDoors(uint32_t entry) { return entry >> DONGLE_ID_BITS; }
+
+// MasterCard ID precomputed once — INVALID_DONGLE_ID if Secrets.h holds a placeholder.
+constexpr uint32_t DONGLE_MASTER_CARD_ID = decodeDongleId(DONGLE_MASTER_CARD_UPDATE_DB);
+
+// =============================================================
+// DongleTable
+// Array of authorized entries (ID + door mask), sorted and unique by ID,
+// plus the precomputed OPEN_FOR_ALL_DONGLES flag. Built once per
+// load/refresh, then only read: lookups are a binary search without
+// allocation.
+// Entries may have an AccessSchedule: a per-entry index (parallel to the
+// entries) into a small array of distinct schedules, so a restricted
+// scan costs one more array read and a bit test.
+// The arrays are either owned (heap) or a view into memory-mapped flash.
+// =============================================================
+constexpr int DONGLE_MAX_SCHEDULES = 255;  // Distinct schedules per table (uint8_t index, 0 = any time)
+
+class DongleTable {
+  private:
+    const uint32_t* _ids = nullptr;
+    const uint8_t* _scheduleOf = nullptr;  // Per entry: 0 = any time, s = _schedules[s - 1]; nullptr if no schedules
+    const AccessSchedule* _schedules = nullptr;
+    size_t _count = 0;
+    uint8_t _scheduleCount = 0;
+    bool _openForAll = false;
+    bool _owned = false;
+
+    void release();
+    int find(uint32_t dongleId) const;
+
+  public:
+    DongleTable() = default;
+    ~DongleTable() { release(); }
+    DongleTable(const DongleTable&) = delete;
+    DongleTable& operator=(const DongleTable&) = delete;
+
+    // Take ownership of a new[]-allocated entry array; sorts by ID in place and
+    // merges entries of the same ID (union of their doors, 0 = every door wins).
+    void adopt(uint32_t* ids, size_t count, bool openForAll) { adopt(ids, nullptr, count, nullptr, 0, openForAll); }
+
+    // Same, with new[]-allocated schedules: scheduleOf[i] belongs to ids[i] and is
+    // sorted along. Merged entries keep a schedule only if both have one; it is
+    // then their union (mergeAccessSchedules), appended to the schedules.
+    void adopt(uint32_t* ids, uint8_t* scheduleOf, size_t count, AccessSchedule* schedules, uint8_t scheduleCount,
+               bool openForAll);
+
+    // Reference entries already sorted and unique by ID, owned elsewhere (e.g. mapped flash).
+    // The memory must outlive the table; nothing is copied.
+    void view(const uint32_t* ids, size_t count, bool openForAll, const uint8_t* scheduleOf = nullptr,
+              const AccessSchedule* schedules = nullptr, uint8_t scheduleCount = 0);
+
+    // Exchange contents with another table (O(1), no allocation).
+    void swap(DongleTable& other);
+
+    // Replace contents with (base + added) - removed, all three sorted: O(n) merge.
+    // An added entry replaces a base entry of the same ID (changed doors or
+    // schedules arrive as the old entry in removed and the new one in added);
+    // removed only drops base entries. The OPEN_FOR_ALL flag follows the same
+    // rule. Returns false if out of memory or the result would need more than
+    // DONGLE_MAX_SCHEDULES schedules.
+    bool assignDelta(const DongleTable& base, const DongleTable& added, const DongleTable& removed);
+
+    // ID listed, for any door and time
+    bool contains(uint32_t dongleId) const;
+    // ID listed for door (index into DOORS) and, if it has a schedule, within it at
+    // time now (local time is only computed for restricted entries)
+    bool allows(uint32_t dongleId, uint8_t door, time_t now) const;
+    bool equals(const DongleTable& other) const;
+
+    // Content hash shared with googleScript (dongleListHash_): CRC-32 over the
+    // sorted entries as 4-byte little-endian words, then the entry word and the
+    // 24-byte AccessSchedule of every restricted entry, plus 0xFFFFFFFF if open for all.
+    uint32_t hash() const;
+    bool isOpenForAll() const { return _openForAll; }
+    size_t size() const { return _count; }
+    const uint32_t* ids() const { return _ids; }
+
+    // Schedule of entry index, nullptr if unrestricted
+    const AccessSchedule* scheduleAt(size_t index) const {
+      return _scheduleOf != nullptr && _scheduleOf[index] != 0 ? &_schedules[_scheduleOf[index] - 1] : nullptr;
+    }
+    const uint8_t* scheduleIndices() const { return _scheduleOf; }
+    const AccessSchedule* schedules() const { return _schedules; }
+    uint8_t scheduleCount() const { return _scheduleCount; }
+};
+
+// =============================================================
+// DongleTableBuilder
+// Collects entries one at a time (e.g. from the streaming parser) into a
+// geometrically grown array, then hands it to a DongleTable. Schedules
+// are deduplicated as they arrive; the per-entry index array is only
+// allocated once the first restricted entry shows up.
+// =============================================================
+class DongleTableBuilder {
+  private:
+    uint32_t* _ids = nullptr;
+    uint8_t* _scheduleOf = nullptr;
+    AccessSchedule* _schedules = nullptr;
+    size_t _count = 0;
+    size_t _capacity = 0;
+    size_t _dropped = 0;
+    uint8_t _scheduleCount = 0;
+    uint8_t _scheduleCapacity = 0;
+    bool _openForAll = false;
+
+    int internSchedule(const AccessSchedule& schedule);  // 1-based slot, 0 = table full, -1 = out of memory
+    bool grow(size_t capacity, bool withSchedules);
+
+  public:
+    DongleTableBuilder() = default;
+    ~DongleTableBuilder();
+    DongleTableBuilder(const DongleTableBuilder&) = delete;
+    DongleTableBuilder& operator=(const DongleTableBuilder&) = delete;
+
+    // entry: an ID or makeDongleEntry(); schedule: nullptr for any time.
+    // Returns false if out of memory (the entry is lost, builder stays usable).
+    // An entry with a schedule beyond DONGLE_MAX_SCHEDULES distinct ones is
+    // dropped (denied) and counted in droppedCount().
+    bool add(uint32_t entry, const AccessSchedule* schedule = nullptr);
+    void setOpenForAll() { _openForAll = true; }
+    size_t size() const { return _count; }
+    size_t droppedCount() const { return _dropped; }
+
+    // Move collected entries into table (sorted, merged by ID). Builder is empty afterwards.
+    void build(DongleTable* table);
+};
+
+// =============================================================
+// PublishedDongleTable
+// RCU-style publication of immutable DongleTables: one writer
+// (network task), any number of readers on any core. Readers pin the
+// active slot with a per-slot reader count and never block; the writer
+// fills the inactive slot, publishes it with a single atomic store and
+// then waits for the old slot to drain before reclaiming it.
+// =============================================================
+class PublishedDongleTable {
+  private:
+    DongleTable _slots[2];
+    std::atomic<uint8_t> _active{0};
+    mutable std::atomic<uint32_t> _readers[2];
+
+    uint8_t pin() const;
+    void unpin(uint8_t slot) const;
+
+  public:
+    PublishedDongleTable();
+    PublishedDongleTable(const PublishedDongleTable&) = delete;
+    PublishedDongleTable& operator=(const PublishedDongleTable&) = delete;
+
+    // Scoped read access. The pinned table stays valid and unchanged until destruction.
+    // Keep the scope short: the writer waits for it before reclaiming the old table.
+    class Reader {
+      private:
+        const PublishedDongleTable& _owner;
+        uint8_t _slot;
+
+      public:
+        explicit Reader(const PublishedDongleTable& owner) : _owner(owner), _slot(owner.pin()) {}
+        ~Reader() { _owner.unpin(_slot); }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        const DongleTable* operator->() const { return &_owner._slots[_slot]; }
+        const DongleTable& operator*() const { return _owner._slots[_slot]; }
+    };
+
+    // Single writer only. Publishes the contents of table and hands the retired
+    // table back in it once no reader can still hold it (caller frees it).
+    void publish(DongleTable& table);
+};
+
+#endif // DONGLE_TABLE_H
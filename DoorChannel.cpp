@@ -0,0 +1,199 @@
+#include "DoorChannel.h"
+#include "DebugService.h"
+#include "LatencyTrace.h"
+#include "NetworkTask.h"
+
+static_assert(DoorReaderFormat::BITS <= DONGLE_ID_BITS, "dongle tables and log records hold DONGLE_ID_BITS-bit IDs");
+
+// =============================================================
+// Setup
+// =============================================================
+
+void DoorChannel::begin(uint8_t door, TaskHandle_t notifyTask) {
+  const DoorConfig& config = DOORS[door];
+  _door = door;
+  _notifyTask = notifyTask;
+
+  // Timer ID = channel: the callbacks only notify, the channel re-checks its own state in loop()
+  _wiegandTimeoutTimer = xTimerCreate("Wiegand", pdMS_TO_TICKS(WIEGAND_TIMEOUT_MS), pdFALSE, this, onWiegandTimeout);
+  _doorDebounceTimer = xTimerCreate("Door", pdMS_TO_TICKS(DOOR_DEBOUNCE_MS), pdFALSE, this, onDoorSettled);
+  configASSERT(_wiegandTimeoutTimer != nullptr);
+  configASSERT(_doorDebounceTimer != nullptr);
+
+  _unlockRelay.begin(config.relayPin, notifyTask, MAIN_NOTIFY_RELAY_TIMER);
+  _buzzer.begin(config.buzzerPin, notifyTask, MAIN_NOTIFY_BUZZER_TIMER);
+  pinMode(config.contactPin, INPUT_PULLUP);
+  attachInterruptArg(digitalPinToInterrupt(config.contactPin), ISRdoorStateChanged, this, CHANGE);
+
+  pinMode(config.data0Pin, INPUT_PULLUP);
+  pinMode(config.data1Pin, INPUT_PULLUP);
+  attachInterruptArg(digitalPinToInterrupt(config.data0Pin), ISRreceiveData0, this, FALLING);
+  attachInterruptArg(digitalPinToInterrupt(config.data1Pin), ISRreceiveData1, this, FALLING);
+}
+
+// =============================================================
+// ISR Handlers
+// =============================================================
+
+// IRAM_ATTR: On ESP32, ISR code must reside in Internal RAM (IRAM), not in Flash.
+// During Flash operations (e.g., Preferences writes), Flash is temporarily unavailable.
+// Without IRAM_ATTR, an interrupt during a Flash operation would try to execute code
+// from unavailable Flash memory, causing a "Guru Meditation Error" (crash).
+
+void IRAM_ATTR DoorChannel::receiveWiegandBit(DoorReaderFormat::Frame bit) {
+  _frameBits = (_frameBits << 1) | bit;
+  _bitCount++;
+  _lastBitTime = millis();  // millis() is ISR-safe on ESP32 (reads hardware timer)
+
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  if (_bitCount == DoorReaderFormat::BITS) {
+    // Hand the frame to loop() and start the next one at once: a scan arriving
+    // while the previous one is handled is queued instead of discarded.
+    // Parity is checked in loop(); a full ring (loop() stuck) drops the frame.
+    WiegandFrame frame = { _frameBits, traceTimestamp() };
+    _frameBits = 0;
+    _bitCount = 0;
+    if (_frames.push(frame)) {
+      xTaskNotifyFromISR(_notifyTask, MAIN_NOTIFY_WIEGAND_FRAME, eSetBits, &higherPriorityTaskWoken);
+    }
+  } else {
+    // Partial frame: the Wiegand protocol transmits a 26-bit frame within ~52ms (2ms per bit).
+    // If interference leaves a frame incomplete, no further scans could succeed, so
+    // the frame is dropped WIEGAND_TIMEOUT_MS after its last bit — well above the maximum
+    // valid transmission time while still recovering quickly.
+    xTimerResetFromISR(_wiegandTimeoutTimer, &higherPriorityTaskWoken);
+  }
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+void IRAM_ATTR DoorChannel::ISRreceiveData0(void* channel) {
+  // ISR for Data0 (bit '0') in the Wiegand protocol.
+  static_cast<DoorChannel*>(channel)->receiveWiegandBit(0);
+}
+
+void IRAM_ATTR DoorChannel::ISRreceiveData1(void* channel) {
+  // ISR for Data1 (bit '1') in the Wiegand protocol.
+  static_cast<DoorChannel*>(channel)->receiveWiegandBit(1);
+}
+
+void IRAM_ATTR DoorChannel::ISRdoorStateChanged(void* channel) {
+  // Contact bounce restarts the timer; the state is read once it is stable
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  xTimerResetFromISR(static_cast<DoorChannel*>(channel)->_doorDebounceTimer, &higherPriorityTaskWoken);
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+// =============================================================
+// Timer Callbacks (FreeRTOS timer task — only notify, work happens in loop())
+// =============================================================
+
+void DoorChannel::onWiegandTimeout(TimerHandle_t timer) {
+  DoorChannel* channel = static_cast<DoorChannel*>(pvTimerGetTimerID(timer));
+  xTaskNotify(channel->_notifyTask, MAIN_NOTIFY_WIEGAND_TIMEOUT, eSetBits);
+}
+
+void DoorChannel::onDoorSettled(TimerHandle_t timer) {
+  DoorChannel* channel = static_cast<DoorChannel*>(pvTimerGetTimerID(timer));
+  xTaskNotify(channel->_notifyTask, MAIN_NOTIFY_DOOR_SETTLED, eSetBits);
+}
+
+void DoorChannel::resetStalledWiegandFrame() {
+  // Re-check under the lock: a new bit may have arrived since the timer fired
+  // (or the notification came from another door's timer)
+  bool stillReceiving = false;
+  noInterrupts();
+  if (_bitCount > 0) {
+    if (millis() - _lastBitTime >= WIEGAND_TIMEOUT_MS) {
+      _bitCount = 0;
+      _frameBits = 0;
+    } else {
+      stillReceiving = true;
+    }
+  }
+  interrupts();
+  if (stillReceiving) {
+    xTimerReset(_wiegandTimeoutTimer, 0);  // Timer tick rounding: check again later
+  }
+}
+
+// =============================================================
+// Door State Monitoring
+// =============================================================
+
+void DoorChannel::trackDoorStateChange() {
+  // MAIN_NOTIFY_DOOR_SETTLED is shared by all doors: while this door's contact
+  // is still bouncing, the wake-up came from another door's timer. This door
+  // is read once its own timer has run out.
+  if (xTimerIsTimerActive(_doorDebounceTimer)) {
+    return;
+  }
+
+  // Read pin once to avoid inconsistency between comparison and assignment
+  int currentDoorState = digitalRead(DOORS[_door].contactPin);
+
+  if (_doorStateMemory != currentDoorState) {
+    _doorStateMemory = currentDoorState;
+
+    if (_doorStateMemory == DOOR_IS_CLOSED) {
+      DBG(DebugFlags::DOOR_STATE, DOORS[_door].name, ": door closed — logging");
+      enqueueLogEvent(LOG_EVENT_DOOR_CLOSED, 0, _door);
+    } else if (_doorStateMemory == DOOR_IS_OPEN) {
+      DBG(DebugFlags::DOOR_STATE, DOORS[_door].name, ": door opened — logging");
+      enqueueLogEvent(LOG_EVENT_DOOR_OPEN, 0, _door);
+    } else {
+      // Shouldn't happen — pin reads only 0 or 1
+    }
+  }
+}
+
+// =============================================================
+// RFID Scan Processing
+// =============================================================
+
+void DoorChannel::handleWiegandFrames() {
+  WiegandFrame frame;
+  while (_frames.pop(&frame)) {
+    handleRFIDScanResult(frame);
+  }
+}
+
+void DoorChannel::handleRFIDScanResult(const WiegandFrame& frame) {
+  traceScanStart(frame.endCycles);
+  traceScanStage(LATENCY_STAGE_WAKE);
+
+  // Corrupted read: reject before the lookup; nothing is logged for an unreadable ID
+  if (!DoorReaderFormat::hasValidParity(frame.bits)) {
+    DBG(DebugFlags::DONGLE_SCAN, DOORS[_door].name, ": Wiegand parity error — frame rejected: ", (uint32_t)frame.bits);
+    _buzzer.play(BuzzerSound::NoAuth);
+    return;
+  }
+
+  // Authorization and the log event both work on the raw frame (parity bits
+  // included, as in the sheet); the binary string is only formatted by the
+  // network task at upload time
+  uint32_t dongleId = (uint32_t)frame.bits;
+  bool authorized = isDongleIdAuthorized(dongleId, _door);
+  traceScanStage(LATENCY_STAGE_DECISION);
+  DBG(DebugFlags::DONGLE_SCAN, DOORS[_door].name, ": scanned dongle ", dongleId);
+
+  if (authorized) {
+    DBG(DebugFlags::DONGLE_SCAN, "Access granted");
+    _buzzer.play(BuzzerSound::AuthOk);
+    unlock();
+    traceScanStage(LATENCY_STAGE_RELAY);
+  } else {
+    DBG(DebugFlags::DONGLE_SCAN, "Access denied");
+    _buzzer.play(BuzzerSound::NoAuth);
+  }
+  enqueueLogEvent(authorized ? LOG_EVENT_AUTHORISED : LOG_EVENT_DENIED, dongleId, _door);
+  traceScanStage(LATENCY_STAGE_ENQUEUE);
+}
+
+// =============================================================
+// Unlock
+// =============================================================
+
+void DoorChannel::unlock() {
+  // Relay drops after SWITCHDURATION_MS via onRelayTimer(); loop() keeps running
+  _unlockRelay.pulse(SWITCHDURATION_MS);
+}
@@ -0,0 +1,62 @@
+#ifndef DOOR_CHANNEL_H
+#define DOOR_CHANNEL_H
+
+#include "Config.h"
+#include "Actuators.h"
+#include "SpscRing.h"
+#include "WiegandFormat.h"
+
+// =============================================================
+// DoorChannel (Core 1)
+// One door of DOORS: Wiegand reader ISRs, frame ring, door contact,
+// unlock relay and buzzer. Every channel has its own ISR context (the
+// ISRs get the channel as argument) and its own timers, but all of them
+// wake the loop task with the shared MAIN_NOTIFY_* bits. loop() passes
+// each bit to every channel; a channel with nothing due ignores it.
+// =============================================================
+class DoorChannel {
+  private:
+    // ISR-shared (modified in ISR context)
+    volatile DoorReaderFormat::Frame _frameBits = 0;  // Frame being received, MSB first
+    volatile int _bitCount = 0;
+    volatile unsigned long _lastBitTime = 0;
+    SpscRing<WiegandFrame, WIEGAND_FRAME_RING_SIZE> _frames;  // Completed frames: ISR -> loop()
+
+    uint8_t _door = 0;                              // Index into DOORS
+    TaskHandle_t _notifyTask = nullptr;             // Loop task, woken by MAIN_NOTIFY_* bits
+    TimerHandle_t _wiegandTimeoutTimer = nullptr;  // One-shot, restarted by every Wiegand bit
+    TimerHandle_t _doorDebounceTimer = nullptr;    // One-shot, restarted by every door contact edge
+    int _doorStateMemory = 2;                       // Initial = 2 (neither open nor closed), in use: 0 or 1
+
+    RelayPulse _unlockRelay;  // Timer-driven: unlock() returns immediately
+    BuzzerSequencer _buzzer;  // Timer-driven patterns, never blocks loop()
+
+    static void IRAM_ATTR ISRreceiveData0(void* channel);
+    static void IRAM_ATTR ISRreceiveData1(void* channel);
+    static void IRAM_ATTR ISRdoorStateChanged(void* channel);
+    static void onWiegandTimeout(TimerHandle_t timer);
+    static void onDoorSettled(TimerHandle_t timer);
+    void IRAM_ATTR receiveWiegandBit(DoorReaderFormat::Frame bit);
+    void handleRFIDScanResult(const WiegandFrame& frame);
+
+  public:
+    DoorChannel() = default;
+    DoorChannel(const DoorChannel&) = delete;
+    DoorChannel& operator=(const DoorChannel&) = delete;
+
+    // Set up the pins, timers and ISRs of DOORS[door]; notifyTask is woken with MAIN_NOTIFY_* bits.
+    void begin(uint8_t door, TaskHandle_t notifyTask);
+
+    // loop() handlers, one per MAIN_NOTIFY_* bit
+    void handleWiegandFrames();       // MAIN_NOTIFY_WIEGAND_FRAME
+    void resetStalledWiegandFrame();  // MAIN_NOTIFY_WIEGAND_TIMEOUT
+    void trackDoorStateChange();      // MAIN_NOTIFY_DOOR_SETTLED (and once at boot)
+    void onRelayTimer() { _unlockRelay.onTimer(); }  // MAIN_NOTIFY_RELAY_TIMER
+    void onBuzzerTimer() { _buzzer.onTimer(); }      // MAIN_NOTIFY_BUZZER_TIMER
+
+    void play(BuzzerSound sound) { _buzzer.play(sound); }
+    void unlock();
+    uint8_t index() const { return _door; }
+};
+
+#endif // DOOR_CHANNEL_H
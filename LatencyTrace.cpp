@@ -0,0 +1,91 @@
+#include "LatencyTrace.h"
+#include <esp_cpu.h>
+#include <algorithm>
+#include <atomic>
+
+static uint32_t frameEndCycles = 0;                   // Scan being handled (loop task only)
+static LatencyHistogram histograms[LATENCY_STAGE_COUNT];  // Written by the loop task only
+static std::atomic<bool> resetRequested{false};
+
+static const char* const LATENCY_STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+  "wake", "decision", "relay", "enqueue",
+};
+
+uint32_t IRAM_ATTR traceTimestamp() {
+  return esp_cpu_get_cycle_count();
+}
+
+void traceScanStart(uint32_t frameEnd) {
+  frameEndCycles = frameEnd;
+}
+
+void traceScanStage(LatencyStage stage) {
+  uint32_t cycles = esp_cpu_get_cycle_count() - frameEndCycles;  // Wraps after ~17 s at 240 MHz
+  if (stage >= LATENCY_STAGE_COUNT) {
+    return;
+  }
+  if (resetRequested.exchange(false)) {
+    memset(histograms, 0, sizeof(histograms));
+  }
+
+  uint32_t us = cycles / getCpuFrequencyMhz();
+  int bucket = us < 2 ? 0 : 31 - __builtin_clz(us);  // floor(log2(us)): [2^i, 2^(i+1))
+  if (bucket >= LATENCY_BUCKET_COUNT) {
+    bucket = LATENCY_BUCKET_COUNT - 1;
+  }
+
+  LatencyHistogram& histogram = histograms[stage];
+  histogram.buckets[bucket]++;
+  histogram.count++;
+  histogram.sumUs += us;
+  if (us > histogram.maxUs) {
+    histogram.maxUs = us;
+  }
+}
+
+void requestLatencyTraceReset() {
+  resetRequested.store(true);
+}
+
+bool snapshotLatencyHistogram(LatencyStage stage, LatencyHistogram* out) {
+  if (stage >= LATENCY_STAGE_COUNT) {
+    return false;
+  }
+  memcpy(out, &histograms[stage], sizeof(LatencyHistogram));
+  if (resetRequested.load()) {
+    memset(out, 0, sizeof(LatencyHistogram));  // Pending reset: report what the next scan will see
+  }
+  return true;
+}
+
+const char* latencyStageName(LatencyStage stage) {
+  return stage < LATENCY_STAGE_COUNT ? LATENCY_STAGE_NAMES[stage] : "?";
+}
+
+size_t formatLatencyHistogram(LatencyStage stage, char* buf, size_t bufSize) {
+  if (bufSize == 0) {
+    return 0;
+  }
+  buf[0] = '\0';
+  LatencyHistogram histogram;
+  if (!snapshotLatencyHistogram(stage, &histogram)) {
+    return 0;
+  }
+
+  uint32_t meanUs = histogram.count > 0 ? (uint32_t)(histogram.sumUs / histogram.count) : 0;
+  int written = snprintf(buf, bufSize, "%-8s n=%lu mean=%luus max=%luus", latencyStageName(stage),
+                         (unsigned long)histogram.count, (unsigned long)meanUs, (unsigned long)histogram.maxUs);
+  size_t pos = written < 0 ? 0 : std::min((size_t)written, bufSize - 1);
+  for (int i = 0; i < LATENCY_BUCKET_COUNT && pos < bufSize - 1; i++) {
+    if (histogram.buckets[i] == 0) {
+      continue;
+    }
+    if (i == LATENCY_BUCKET_COUNT - 1) {
+      written = snprintf(buf + pos, bufSize - pos, " >=%lu:%lu", 1UL << i, (unsigned long)histogram.buckets[i]);
+    } else {
+      written = snprintf(buf + pos, bufSize - pos, " <%lu:%lu", 1UL << (i + 1), (unsigned long)histogram.buckets[i]);
+    }
+    pos = written < 0 ? pos : std::min(pos + (size_t)written, bufSize - 1);
+  }
+  return pos;
+}
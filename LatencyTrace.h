@@ -0,0 +1,63 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include "Config.h"
+
+// =============================================================
+// Scan Latency Trace (always on, also in production builds)
+// The Wiegand ISR stamps the last bit of a frame with the CPU cycle
+// counter and passes it along with the frame; handleRFIDScanResult()
+// then records how long each stage took relative to that stamp into
+// fixed log2 histograms in RAM.
+// Recording is a cycle counter read, a shift and two increments —
+// no allocation, no locks, no floating point.
+//
+// ISR and loop() both run on Core 1, so both stamps come from the
+// same per-core counter. Histograms are written on Core 1 only; other
+// readers see plain 32-bit words and may be off by a scan in flight.
+// =============================================================
+
+enum LatencyStage : uint8_t {
+  LATENCY_STAGE_WAKE,      // loop() picked up the completed frame
+  LATENCY_STAGE_DECISION,  // Authorization decided
+  LATENCY_STAGE_RELAY,     // Relay energized (granted scans only)
+  LATENCY_STAGE_ENQUEUE,   // Log event queued for the network task
+  LATENCY_STAGE_COUNT,
+};
+
+// Bucket i counts latencies below 2^(i+1) µs (bucket 0: < 2 µs); the last
+// bucket also takes everything slower (>= 32.768 ms).
+constexpr int LATENCY_BUCKET_COUNT = 16;
+
+struct LatencyHistogram {
+  uint32_t buckets[LATENCY_BUCKET_COUNT];
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t sumUs;
+};
+
+// ISR: cycle counter at the last bit of a complete frame.
+uint32_t IRAM_ATTR traceTimestamp();
+
+// Loop task: start timing a scan whose frame ended at frameEndCycles (from traceTimestamp()).
+void traceScanStart(uint32_t frameEndCycles);
+
+// Loop task: record the time since the frame end for one stage of the current scan.
+void traceScanStage(LatencyStage stage);
+
+// Any task: clear all histograms (applied by the loop task at the next scan).
+void requestLatencyTraceReset();
+
+// Any task: copy one histogram. Returns false for an invalid stage.
+bool snapshotLatencyHistogram(LatencyStage stage, LatencyHistogram* out);
+
+// Short stage name ("wake", "decision", ...) for reports and metrics.
+const char* latencyStageName(LatencyStage stage);
+
+// One report line: name, count, mean and max µs, non-empty buckets as
+// "<upper_us:count". Returns the length (truncated to bufSize - 1).
+size_t formatLatencyHistogram(LatencyStage stage, char* buf, size_t bufSize);
+
+constexpr size_t LATENCY_REPORT_LINE_MAX = 48 + LATENCY_BUCKET_COUNT * 18;
+
+#endif // LATENCY_TRACE_H
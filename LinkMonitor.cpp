@@ -0,0 +1,71 @@
+#include "LinkMonitor.h"
+#include "DebugService.h"
+#include <climits>
+
+// =============================================================
+// Backoff
+// =============================================================
+
+void Backoff::fail(unsigned long now, uint32_t random) {
+  _intervalMs = _intervalMs == 0 ? _minMs : (_intervalMs >= _maxMs / 2 ? _maxMs : _intervalMs * 2);
+  unsigned long half = _intervalMs / 2;
+  _dueMs = now + (_intervalMs - half) + random % (half + 1);
+}
+
+unsigned long Backoff::msUntilDue(unsigned long now) const {
+  if (_intervalMs == 0) {
+    return 0;
+  }
+  long remaining = (long)(_dueMs - now);  // Signed: millis() wraps after 49 days
+  return remaining > 0 ? (unsigned long)remaining : 0;
+}
+
+// =============================================================
+// LinkMonitor
+// =============================================================
+
+static const char* const LINK_STATE_NAMES[] = { "online", "degraded", "offline" };
+
+void LinkMonitor::onRequest(bool ok, unsigned long now, uint32_t random) {
+  LinkState previous = _state;
+  if (ok) {
+    _failures = 0;
+    _retry.reset();
+    _state = LINK_ONLINE;
+  } else {
+    if (_failures < UINT8_MAX) {
+      _failures++;
+    }
+    _retry.fail(now, random);
+    _state = _failures >= LINK_OFFLINE_AFTER_FAILURES ? LINK_OFFLINE : LINK_DEGRADED;
+  }
+  if (_state != previous) {
+    DBG(DebugFlags::NETWORK_TASK, "Link ", LINK_STATE_NAMES[previous], " -> ", LINK_STATE_NAMES[_state],
+        " (next retry in ", _retry.msUntilDue(now), " ms)");
+  }
+}
+
+void LinkMonitor::onWifi(bool connected) {
+  if (connected == _wifiUp) {
+    return;
+  }
+  _wifiUp = connected;
+  LinkState previous = _state;
+  if (connected) {
+    // Request at once: on the first association nothing has failed yet,
+    // after a loss the probe finds out whether the web app is reachable again
+    _failures = 0;
+    _retry.reset();
+    _state = _wifiWasUp ? LINK_DEGRADED : LINK_ONLINE;
+    _wifiWasUp = true;
+  } else {
+    _state = LINK_OFFLINE;
+  }
+  DBG(DebugFlags::NETWORK_TASK, "Link ", LINK_STATE_NAMES[previous], " -> ", LINK_STATE_NAMES[_state],
+      connected ? " (WiFi up)" : " (WiFi lost)");
+  (void)previous;
+}
+
+unsigned long LinkMonitor::msUntilRequestDue(unsigned long now) const {
+  return _wifiUp ? _retry.msUntilDue(now) : ULONG_MAX;
+}
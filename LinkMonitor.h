@@ -0,0 +1,83 @@
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include "Config.h"
+
+// =============================================================
+// Backoff
+// Exponential backoff with jitter for one kind of retry. Each failure
+// doubles the interval (minMs .. maxMs) and schedules the
+// next attempt at a random point in the upper half of it, so devices
+// that lost the link together do not retry in lockstep.
+// =============================================================
+class Backoff {
+  private:
+    unsigned long _minMs;
+    unsigned long _maxMs;
+    unsigned long _intervalMs = 0;  // 0 = no failure since the last reset()
+    unsigned long _dueMs = 0;       // millis() of the next attempt
+
+  public:
+    Backoff(unsigned long minMs, unsigned long maxMs) : _minMs(minMs), _maxMs(maxMs) {}
+
+    // Attempt failed at now. random: any 32-bit value (esp_random()).
+    void fail(unsigned long now, uint32_t random);
+    // Attempt succeeded: the next failure starts over at minMs.
+    void reset() { _intervalMs = 0; }
+
+    bool due(unsigned long now) const { return msUntilDue(now) == 0; }
+    unsigned long msUntilDue(unsigned long now) const;
+    unsigned long intervalMs() const { return _intervalMs; }
+};
+
+// =============================================================
+// LinkMonitor
+// Connectivity state of the network task, fed with the WiFi status
+// and the outcome of every request to the web app:
+//
+//   ONLINE    last request succeeded. Log events are batched in RAM,
+//             the backlog is drained batch after batch.
+//   DEGRADED  requests fail. New events go straight to the backlog;
+//             one backlog batch is retried per backoff step, with the
+//             short SCRIPT_PROBE_TIMEOUT_MS.
+//   OFFLINE   WiFi down (no requests at all; the state at boot), or
+//             LINK_OFFLINE_AFTER_FAILURES failures in a row (probes
+//             continue at the backoff's pace).
+//
+// One successful request returns to ONLINE from either state. The first
+// association after boot goes straight to ONLINE: nothing has failed
+// yet, so the first dongle fetch gets the full SCRIPT_HTTP_TIMEOUT_MS.
+// WiFi coming back after a loss moves OFFLINE to DEGRADED with a probe
+// due at once.
+// Single user: the network task.
+// =============================================================
+enum LinkState : uint8_t {
+  LINK_ONLINE,
+  LINK_DEGRADED,
+  LINK_OFFLINE,
+};
+
+class LinkMonitor {
+  private:
+    LinkState _state = LINK_OFFLINE;
+    bool _wifiUp = false;
+    bool _wifiWasUp = false;  // Associated before: coming back after a loss starts DEGRADED
+    uint8_t _failures = 0;  // Consecutive failed requests
+    Backoff _retry{LINK_RETRY_MIN_MS, LINK_RETRY_MAX_MS};
+
+  public:
+    void onRequest(bool ok, unsigned long now, uint32_t random);
+    void onWifi(bool connected);
+
+    LinkState state() const { return _state; }
+    bool isOnline() const { return _state == LINK_ONLINE; }
+
+    // A request may be sent now (always when online, once per backoff step otherwise)
+    bool requestDue(unsigned long now) const { return _wifiUp && _retry.due(now); }
+    unsigned long msUntilRequestDue(unsigned long now) const;  // ULONG_MAX while WiFi is down
+
+    // Timeout for the next request: a dead link costs a probe, not a full timeout
+    uint16_t requestTimeoutMs() const { return isOnline() ? SCRIPT_HTTP_TIMEOUT_MS : SCRIPT_PROBE_TIMEOUT_MS; }
+};
+
+#endif // LINK_MONITOR_H
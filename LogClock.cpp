@@ -0,0 +1,23 @@
+#include "LogClock.h"
+
+void LogClock::sync(uint32_t now, uint32_t uptime) {
+  if (now >= LOG_EVENT_MIN_VALID_EPOCH) {
+    _bootEpoch = now - uptime;
+  }
+}
+
+uint32_t LogClock::fromUptime(uint32_t uptime) const {
+  if (isSet()) {
+    return _bootEpoch + uptime;
+  }
+  return (_bootId << LOG_CLOCK_UPTIME_BITS) | (uptime < LOG_CLOCK_UPTIME_MASK ? uptime : LOG_CLOCK_UPTIME_MASK);
+}
+
+uint32_t LogClock::backfill(uint32_t epoch) const {
+  // Not this boot's, or clamped (no clock for 48 days after boot): left as is
+  if (!isSet() || epoch >= LOG_EVENT_MIN_VALID_EPOCH || _bootId == 0 || (epoch >> LOG_CLOCK_UPTIME_BITS) != _bootId ||
+      (epoch & LOG_CLOCK_UPTIME_MASK) == LOG_CLOCK_UPTIME_MASK) {
+    return epoch;
+  }
+  return _bootEpoch + (epoch & LOG_CLOCK_UPTIME_MASK);
+}
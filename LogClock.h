@@ -0,0 +1,53 @@
+#ifndef LOG_CLOCK_H
+#define LOG_CLOCK_H
+
+#include "Config.h"
+
+// =============================================================
+// LogClock
+// Wall time of log events. Core 1 stamps each event with the uptime
+// (uptimeSeconds()), so the door works and logs from power-up on,
+// long before WiFi and NTP are up. The network task converts the stamp
+// when it takes the event from the ring:
+//
+//   clock set      uptime + wall time at boot = time() of the event
+//   not yet set    boot-relative stamp: the uptime (low 22 bits, 48 days)
+//                  tagged with the boot number (bits 22-29), which stays
+//                  below LOG_EVENT_MIN_VALID_EPOCH
+//
+// Boot-relative stamps of the current boot are back-filled to wall time
+// before they are sent, also from the flash backlog. Those of an earlier
+// boot (or of firmware before boot numbers) are sent as "Date Error".
+// Single user: the network task.
+// =============================================================
+
+constexpr int LOG_CLOCK_UPTIME_BITS = 22;
+constexpr uint32_t LOG_CLOCK_UPTIME_MASK = (1u << LOG_CLOCK_UPTIME_BITS) - 1;
+constexpr uint32_t LOG_CLOCK_BOOT_IDS = 255;  // Boot numbers 1..255; 0 never matches
+static_assert((LOG_CLOCK_BOOT_IDS << LOG_CLOCK_UPTIME_BITS) + LOG_CLOCK_UPTIME_MASK < LOG_EVENT_MIN_VALID_EPOCH,
+              "boot-relative stamps must read as not synced");
+
+class LogClock {
+  private:
+    uint32_t _bootEpoch = 0;  // Wall time at uptime 0; 0 until the clock is set
+    uint32_t _bootId = 0;
+
+  public:
+    // Boot number of this boot, 1..LOG_CLOCK_BOOT_IDS (kept in NVS by the caller).
+    void begin(uint32_t bootId) { _bootId = bootId; }
+
+    // Wall time now (time()) and the uptime at the same moment. Ignored while
+    // now is not valid yet; later calls follow NTP's corrections.
+    void sync(uint32_t now, uint32_t uptime);
+    bool isSet() const { return _bootEpoch != 0; }
+
+    // Stamp from makeLogEvent() -> wall time, or boot-relative while not set.
+    uint32_t fromUptime(uint32_t uptime) const;
+    // Boot-relative stamp of this boot -> wall time once set; others unchanged.
+    uint32_t backfill(uint32_t epoch) const;
+
+    // Next boot number after previous (0 = none yet).
+    static uint32_t nextBootId(uint32_t previous) { return previous % LOG_CLOCK_BOOT_IDS + 1; }
+};
+
+#endif // LOG_CLOCK_H
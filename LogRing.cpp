@@ -0,0 +1,228 @@
+#include "LogRing.h"
+#include "DebugService.h"
+#include <algorithm>
+
+static constexpr uint32_t RECORDS_PER_SECTOR = SPI_FLASH_SEC_SIZE / LOG_RING_RECORD_SIZE;
+
+static uint32_t recordCrc(const LogRingRecord& record) {
+  uint32_t crc = crc32Update(0, &record.sequence, sizeof(record.sequence));
+  return crc32Update(crc, &record.event, sizeof(record.event));
+}
+
+LogRing::~LogRing() {
+  if (_mapped != nullptr) {
+    esp_partition_munmap(_mapHandle);
+  }
+}
+
+bool LogRing::begin(const char* label) {
+  if (_mapped != nullptr) {
+    esp_partition_munmap(_mapHandle);
+    _mapped = nullptr;
+  }
+  _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)LOG_RING_PARTITION_SUBTYPE, label);
+  if (_partition == nullptr) {
+    DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Log partition '", label, "' not found — check partitions.csv");
+    return false;
+  }
+  const void* mapped = nullptr;
+  if (esp_partition_mmap(_partition, 0, _partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &_mapHandle) != ESP_OK) {
+    DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Log partition mmap failed");
+    _partition = nullptr;
+    return false;
+  }
+  _mapped = static_cast<const uint8_t*>(mapped);
+  _slots = (_partition->size / SPI_FLASH_SEC_SIZE) * RECORDS_PER_SECTOR;
+  _pending = 0;
+  _dropped = 0;
+
+  // Newest record: the write position follows it
+  bool found = false;
+  uint32_t newest = 0;
+  uint32_t newestSequence = 0;
+  for (uint32_t slot = 0; slot < _slots; slot++) {
+    const LogRingRecord* r = record(slot);
+    if (isValid(r) && (!found || (int32_t)(r->sequence - newestSequence) > 0)) {
+      found = true;
+      newest = slot;
+      newestSequence = r->sequence;
+    }
+  }
+  if (!found) {
+    // Empty (or foreign data): append() erases each sector as it reaches it
+    _head = _tail = 0;
+    _peekCount = 0;
+    _nextSequence = 1;
+    return true;
+  }
+  _head = (newest + 1) % _slots;
+  _nextSequence = newestSequence + 1;
+
+  // Oldest first: the ring in write order starts right after the newest record
+  _tail = _head;
+  bool tailFound = false;
+  for (uint32_t i = 0; i < _slots; i++) {
+    uint32_t slot = (_head + i) % _slots;
+    const LogRingRecord* r = record(slot);
+    if (isValid(r) && r->pending == LOG_RING_PENDING) {
+      if (!tailFound) {
+        _tail = slot;
+        tailFound = true;
+      }
+      _pending++;
+    }
+  }
+  _peekCount = 0;
+  DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Log ring: ", _pending, " pending, next sequence ", _nextSequence);
+  return true;
+}
+
+bool LogRing::append(const LogEvent& event) {
+  if (_partition == nullptr) {
+    return false;
+  }
+
+  // Skip slots left dirty by a torn write; erase each sector on entry
+  for (uint32_t attempts = 0; attempts < _slots; attempts++) {
+    if (_head % RECORDS_PER_SECTOR == 0 && !eraseSectorAt(_head)) {
+      return false;
+    }
+    if (isBlank(record(_head))) {
+      break;
+    }
+    _head = (_head + 1) % _slots;
+  }
+
+  LogRingRecord r;
+  memset(&r, 0xFF, sizeof(r));
+  r.sequence = _nextSequence;
+  r.event = event;
+  r.crc = recordCrc(r);
+  r.pending = LOG_RING_PENDING;
+  if (esp_partition_write(_partition, slotOffset(_head), &r, sizeof(r)) != ESP_OK) {
+    return false;
+  }
+
+  if (_pending == 0) {
+    _tail = _head;
+  }
+  _head = (_head + 1) % _slots;
+  _nextSequence++;
+  _pending++;
+  return true;
+}
+
+int LogRing::peek(LogEvent* events, int maxCount) {
+  maxCount = std::min(maxCount, LOG_RING_PEEK_MAX);
+  _peekCount = 0;
+  for (uint32_t slot = _tail; _peekCount < maxCount && slot != _head; slot = (slot + 1) % _slots) {
+    if (isPending(slot)) {
+      events[_peekCount] = record(slot)->event;
+      _peekSlots[_peekCount++] = slot;
+    }
+  }
+  return _peekCount;
+}
+
+int LogRing::peekPrioritized(LogEvent* events, int maxCount) {
+  maxCount = std::min(maxCount, LOG_RING_PEEK_MAX);
+  _peekCount = 0;
+  int count = peekMatching(events, 0, maxCount, true);
+  return peekMatching(events, count, maxCount, false);
+}
+
+int LogRing::peekMatching(LogEvent* events, int count, int maxCount, bool access) {
+  // Oldest first within the window; appends to the records already peeked
+  uint32_t slot = _tail;
+  for (uint32_t i = 0; i < LOG_RING_PRIORITY_WINDOW && count < maxCount && slot != _head; i++) {
+    if (isPending(slot) && isAccessEvent(record(slot)->event) == access) {
+      events[count] = record(slot)->event;
+      _peekSlots[count++] = slot;
+    }
+    slot = (slot + 1) % _slots;
+  }
+  _peekCount = count;
+  return count;
+}
+
+void LogRing::consume() {
+  const uint32_t sent = 0;
+  for (int i = 0; i < _peekCount; i++) {
+    uint32_t slot = _peekSlots[i];
+    if (isPending(slot)) {
+      // Clearing bits: no erase, a single word write per record
+      esp_partition_write(_partition, slotOffset(slot) + offsetof(LogRingRecord, pending), &sent, sizeof(sent));
+      _pending--;
+    }
+  }
+  _peekCount = 0;
+
+  // The tail moves to the oldest record still pending (a skipped door event stops it)
+  while (_tail != _head && !isPending(_tail)) {
+    _tail = (_tail + 1) % _slots;
+  }
+}
+
+uint32_t LogRing::capacity() const {
+  return _slots > RECORDS_PER_SECTOR ? _slots - RECORDS_PER_SECTOR : 0;
+}
+
+const LogRingRecord* LogRing::record(uint32_t slot) const {
+  return reinterpret_cast<const LogRingRecord*>(_mapped + slotOffset(slot));
+}
+
+size_t LogRing::slotOffset(uint32_t slot) const {
+  return (slot / RECORDS_PER_SECTOR) * SPI_FLASH_SEC_SIZE + (slot % RECORDS_PER_SECTOR) * LOG_RING_RECORD_SIZE;
+}
+
+bool LogRing::isValid(const LogRingRecord* r) const {
+  return r->sequence != 0xFFFFFFFF && r->crc == recordCrc(*r);
+}
+
+bool LogRing::isPending(uint32_t slot) const {
+  const LogRingRecord* r = record(slot);
+  return isValid(r) && r->pending == LOG_RING_PENDING;
+}
+
+bool LogRing::isBlank(const LogRingRecord* r) const {
+  const uint32_t* words = reinterpret_cast<const uint32_t*>(r);
+  for (size_t i = 0; i < sizeof(LogRingRecord) / sizeof(uint32_t); i++) {
+    if (words[i] != 0xFFFFFFFF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LogRing::eraseSectorAt(uint32_t slot) {
+  uint32_t first = slot - slot % RECORDS_PER_SECTOR;
+
+  // Oldest records still pending are lost: account for them and move the tail past
+  uint32_t lost = 0;
+  for (uint32_t s = first; s < first + RECORDS_PER_SECTOR; s++) {
+    const LogRingRecord* r = record(s);
+    if (isValid(r) && r->pending == LOG_RING_PENDING) {
+      lost++;
+    }
+  }
+  if (esp_partition_erase_range(_partition, slotOffset(first), SPI_FLASH_SEC_SIZE) != ESP_OK) {
+    return false;
+  }
+  if (lost > 0) {
+    _pending -= lost;
+    _dropped += lost;
+    DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Log ring full — ", lost, " oldest events overwritten");
+  }
+  for (int i = 0; i < _peekCount; i++) {
+    if (_peekSlots[i] >= first && _peekSlots[i] < first + RECORDS_PER_SECTOR) {
+      _peekCount = 0;  // Peeked records are gone: consume() must not clear their successors
+      break;
+    }
+  }
+  if (_pending == 0) {
+    _tail = slot;
+  } else if (_tail >= first && _tail < first + RECORDS_PER_SECTOR) {
+    _tail = (first + RECORDS_PER_SECTOR) % _slots;
+  }
+  return true;
+}
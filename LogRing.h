@@ -0,0 +1,86 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include "Config.h"
+#include <esp_partition.h>
+
+// =============================================================
+// LogRing
+// Append-only circular log of failed log events on its own flash
+// partition. Fixed-size records are written once; sending them only
+// clears bits of their `pending` word (no erase). A sector is erased
+// when the write position enters it, dropping the oldest records if
+// the backlog ever fills the partition.
+//
+// append() is O(1); peek()/consume() drain the oldest pending records
+// in batches, peekPrioritized() access events ahead of door events.
+// Records are consumed one by one, so a door event can stay pending
+// behind newer records that were sent. The head/tail positions are rebuilt from the sequence
+// numbers by one scan in begin(). Each record carries a CRC, so a
+// record torn by a reset is skipped.
+// Single user: the network task.
+// =============================================================
+
+constexpr size_t LOG_RING_RECORD_SIZE = 20;       // 204 records per 4 KB sector
+constexpr uint32_t LOG_RING_PENDING = 0xFFFFFFFF;  // Erased state: clearing it needs no erase
+constexpr int LOG_RING_PEEK_MAX = 32;              // Records per peek (one log batch)
+constexpr uint32_t LOG_RING_PRIORITY_WINDOW = 1024; // Slots from the tail searched for access events
+static_assert(LOG_BATCH_MAX_ENTRIES <= LOG_RING_PEEK_MAX, "a backlog batch is one peek");
+
+struct LogRingRecord {
+  uint32_t sequence;  // Append counter, increases along the ring
+  uint32_t crc;       // crc32Update over sequence and event
+  uint32_t pending;   // LOG_RING_PENDING when written, 0 once sent
+  LogEvent event;
+};
+static_assert(sizeof(LogRingRecord) == LOG_RING_RECORD_SIZE, "LogRingRecord is an on-flash format");
+
+class LogRing {
+  private:
+    const esp_partition_t* _partition = nullptr;
+    const uint8_t* _mapped = nullptr;
+    esp_partition_mmap_handle_t _mapHandle = 0;
+    uint32_t _slots = 0;          // Record slots in the partition
+    uint32_t _head = 0;           // Next slot to write
+    uint32_t _tail = 0;           // First slot that may hold a pending record
+    uint32_t _peekSlots[LOG_RING_PEEK_MAX];  // Slots of the records returned by the last peek
+    int _peekCount = 0;
+    uint32_t _nextSequence = 1;
+    uint32_t _pending = 0;
+    uint32_t _dropped = 0;        // Pending records overwritten since boot
+
+    const LogRingRecord* record(uint32_t slot) const;
+    size_t slotOffset(uint32_t slot) const;
+    bool isValid(const LogRingRecord* record) const;
+    bool isBlank(const LogRingRecord* record) const;
+    bool isPending(uint32_t slot) const;
+    bool eraseSectorAt(uint32_t slot);
+    int peekMatching(LogEvent* events, int count, int maxCount, bool access);
+
+  public:
+    LogRing() = default;
+    ~LogRing();
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // Map the partition and rebuild head/tail. False if the partition is missing.
+    bool begin(const char* label = LOG_RING_PARTITION_LABEL);
+
+    // Store one event. False only on a flash error or missing partition.
+    bool append(const LogEvent& event);
+
+    // Copy up to maxCount (at most LOG_RING_PEEK_MAX) of the oldest pending
+    // events. They stay pending until consume() — call it once they are
+    // safely delivered.
+    int peek(LogEvent* events, int maxCount);
+    // Like peek(), but the access events (scans) among the oldest
+    // LOG_RING_PRIORITY_WINDOW slots come first, door events fill the rest.
+    int peekPrioritized(LogEvent* events, int maxCount);
+    void consume();
+
+    uint32_t pendingCount() const { return _pending; }
+    uint32_t droppedCount() const { return _dropped; }
+    uint32_t capacity() const;  // Pending records that always fit
+};
+
+#endif // LOG_RING_H
@@ -0,0 +1,237 @@
+#include "Metrics.h"
+#include "LatencyTrace.h"
+#include <esp_http_server.h>
+#include <stdarg.h>
+
+static const char* const SCRIPT_ACTION_NAMES[SCRIPT_ACTION_COUNT] = {
+  "read_pa_delta", "write_log_batch",
+};
+
+// =============================================================
+// Recording (network task)
+// =============================================================
+
+void NetworkMetrics::recordRequest(ScriptAction action, int httpCode, bool ok, uint32_t durationMs) {
+  if (action >= SCRIPT_ACTION_COUNT) {
+    return;
+  }
+  RequestStats& stats = _requests[action];
+  int bucket = 0;
+  while (bucket < METRICS_REQUEST_BUCKET_COUNT && durationMs > METRICS_REQUEST_BUCKETS_MS[bucket]) {
+    bucket++;
+  }
+  stats.buckets[bucket]++;
+  stats.count++;
+  stats.sumMs += durationMs;
+
+  if (ok) {
+    return;
+  }
+  for (FailureSlot& slot : _failures) {
+    if (!slot.used) {
+      slot.httpCode = (int16_t)httpCode;
+      slot.action = action;
+      slot.used = true;  // Count stays 0 until the increment: a scrape in between shows 0
+    }
+    if (slot.action == action && slot.httpCode == httpCode) {
+      slot.count++;
+      return;
+    }
+  }
+  _otherFailures[action]++;
+}
+
+void NetworkMetrics::setLogCounts(uint32_t droppedEvents, uint32_t backlogEvents, uint32_t backlogOverwritten) {
+  _droppedEvents = droppedEvents;
+  _backlogEvents = backlogEvents;
+  _backlogOverwritten = backlogOverwritten;
+}
+
+void NetworkMetrics::setDongleTable(uint32_t size, uint32_t version) {
+  _dongleTableSize = size;
+  _dongleTableVersion = version;
+}
+
+void NetworkMetrics::watchTask(const char* name, TaskHandle_t task) {
+  for (WatchedTask& watched : _tasks) {
+    if (watched.handle == nullptr || watched.handle == task) {
+      watched.name = name;
+      watched.handle = task;
+      return;
+    }
+  }
+}
+
+// =============================================================
+// Prometheus Text Format
+// =============================================================
+
+static void printLine(Print& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+static void printLine(Print& out, const char* format, ...) {
+  char line[160];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line) - 1, format, args);
+  va_end(args);
+  if (length < 0) {
+    return;
+  }
+  if ((size_t)length > sizeof(line) - 2) {
+    length = sizeof(line) - 2;  // Truncated; still end the line
+  }
+  line[length++] = '\n';
+  out.write(reinterpret_cast<const uint8_t*>(line), length);
+}
+
+static void printHeader(Print& out, const char* name, const char* type, const char* help) {
+  printLine(out, "# HELP %s %s", name, help);
+  printLine(out, "# TYPE %s %s", name, type);
+}
+
+static void printGauge(Print& out, const char* name, const char* type, const char* help, unsigned long value) {
+  printHeader(out, name, type, help);
+  printLine(out, "%s %lu", name, value);
+}
+
+void NetworkMetrics::print(Print& out) const {
+  // --- Web app requests ---
+  printHeader(out, "rfid_script_request_duration_ms", "histogram",
+              "Apps Script request duration, from sending to the end of the response.");
+  for (int action = 0; action < SCRIPT_ACTION_COUNT; action++) {
+    const RequestStats& stats = _requests[action];
+    const char* name = SCRIPT_ACTION_NAMES[action];
+    unsigned long cumulative = 0;
+    for (int i = 0; i < METRICS_REQUEST_BUCKET_COUNT; i++) {
+      cumulative += stats.buckets[i];
+      printLine(out, "rfid_script_request_duration_ms_bucket{action=\"%s\",le=\"%lu\"} %lu", name,
+                (unsigned long)METRICS_REQUEST_BUCKETS_MS[i], cumulative);
+    }
+    cumulative += stats.buckets[METRICS_REQUEST_BUCKET_COUNT];
+    printLine(out, "rfid_script_request_duration_ms_bucket{action=\"%s\",le=\"+Inf\"} %lu", name, cumulative);
+    printLine(out, "rfid_script_request_duration_ms_sum{action=\"%s\"} %llu", name, (unsigned long long)stats.sumMs);
+    printLine(out, "rfid_script_request_duration_ms_count{action=\"%s\"} %lu", name, (unsigned long)stats.count);
+  }
+
+  printHeader(out, "rfid_script_request_failures_total", "counter",
+              "Failed Apps Script requests by HTTP status (negative: HTTPClient error, 200: rejected response).");
+  for (const FailureSlot& slot : _failures) {
+    if (slot.used) {
+      printLine(out, "rfid_script_request_failures_total{action=\"%s\",code=\"%d\"} %lu",
+                SCRIPT_ACTION_NAMES[slot.action], (int)slot.httpCode, (unsigned long)slot.count);
+    }
+  }
+  for (int action = 0; action < SCRIPT_ACTION_COUNT; action++) {
+    if (_otherFailures[action] > 0) {
+      printLine(out, "rfid_script_request_failures_total{action=\"%s\",code=\"other\"} %lu",
+                SCRIPT_ACTION_NAMES[action], (unsigned long)_otherFailures[action]);
+    }
+  }
+
+  // --- Log pipeline ---
+  printGauge(out, "rfid_log_queue_depth_max", "gauge", "High-water mark of the log event queue.", _logQueueDepthMax);
+  printGauge(out, "rfid_log_queue_capacity", "gauge", "Size of the log event queue.", LOG_QUEUE_SIZE);
+  printGauge(out, "rfid_log_events_dropped_total", "counter", "Log events dropped because the queue was full.", _droppedEvents);
+  printGauge(out, "rfid_log_backlog_events", "gauge", "Unsent log events stored in flash.", _backlogEvents);
+  printGauge(out, "rfid_log_backlog_overwritten_total", "counter",
+             "Unsent log events overwritten because the flash backlog was full.", _backlogOverwritten);
+  printGauge(out, "rfid_link_state", "gauge", "Web app connectivity: 0 = online, 1 = degraded, 2 = offline.",
+             _linkState);
+  printGauge(out, "rfid_boot_ready_ms", "gauge", "Time from boot until the doors and the dongle table were up.",
+             _bootReadyMs);
+
+  // --- Dongle table ---
+  printGauge(out, "rfid_dongle_table_size", "gauge", "Authorized dongle IDs in the published table.", _dongleTableSize);
+  printGauge(out, "rfid_dongle_table_version", "gauge", "googleScript version of the dongle table (0 = never synced).",
+             _dongleTableVersion);
+
+  // --- System ---
+  printGauge(out, "rfid_heap_free_bytes", "gauge", "Free heap.", ESP.getFreeHeap());
+  printGauge(out, "rfid_heap_free_min_bytes", "gauge", "Lowest free heap since boot.", ESP.getMinFreeHeap());
+  printHeader(out, "rfid_task_stack_free_min_bytes", "gauge", "Lowest free stack of a task since it started.");
+  for (const WatchedTask& watched : _tasks) {
+    if (watched.handle != nullptr) {
+      printLine(out, "rfid_task_stack_free_min_bytes{task=\"%s\"} %lu", watched.name,
+                (unsigned long)uxTaskGetStackHighWaterMark(watched.handle));
+    }
+  }
+  printGauge(out, "rfid_uptime_seconds", "counter", "Time since boot.", millis() / 1000);
+
+  // --- Scan latency (Core 1, see LatencyTrace.h) ---
+  printHeader(out, "rfid_scan_latency_us", "histogram", "Scan stage latency since the last Wiegand bit.");
+  for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+    LatencyHistogram histogram;
+    snapshotLatencyHistogram((LatencyStage)stage, &histogram);
+    const char* name = latencyStageName((LatencyStage)stage);
+    unsigned long cumulative = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT - 1; i++) {
+      cumulative += histogram.buckets[i];
+      printLine(out, "rfid_scan_latency_us_bucket{stage=\"%s\",le=\"%lu\"} %lu", name, 1UL << (i + 1), cumulative);
+    }
+    cumulative += histogram.buckets[LATENCY_BUCKET_COUNT - 1];
+    printLine(out, "rfid_scan_latency_us_bucket{stage=\"%s\",le=\"+Inf\"} %lu", name, cumulative);
+    printLine(out, "rfid_scan_latency_us_sum{stage=\"%s\"} %llu", name, (unsigned long long)histogram.sumUs);
+    printLine(out, "rfid_scan_latency_us_count{stage=\"%s\"} %lu", name, (unsigned long)histogram.count);
+  }
+}
+
+// =============================================================
+// HTTP Server (ESP-IDF httpd task)
+// =============================================================
+
+// Sends the scrape in chunks: no buffer for the whole (~6 KB) body
+class ChunkedResponse : public Print {
+  private:
+    httpd_req_t* _req;
+    char _buffer[512];
+    size_t _length = 0;
+    bool _failed = false;
+
+  public:
+    explicit ChunkedResponse(httpd_req_t* req) : _req(req) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t size) override {
+      for (size_t i = 0; i < size; i++) {
+        if (_length == sizeof(_buffer)) {
+          flush();
+        }
+        _buffer[_length++] = (char)data[i];
+      }
+      return size;
+    }
+    void flush() override {
+      if (_length > 0 && !_failed) {
+        _failed = httpd_resp_send_chunk(_req, _buffer, _length) != ESP_OK;  // Client gone: drop the rest
+      }
+      _length = 0;
+    }
+    bool finish() {
+      flush();
+      return !_failed && httpd_resp_send_chunk(_req, nullptr, 0) == ESP_OK;
+    }
+};
+
+static esp_err_t handleMetricsRequest(httpd_req_t* req) {
+  const NetworkMetrics* metrics = static_cast<const NetworkMetrics*>(req->user_ctx);
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+  ChunkedResponse response(req);
+  metrics->print(response);
+  return response.finish() ? ESP_OK : ESP_FAIL;
+}
+
+bool startMetricsServer(const NetworkMetrics* metrics) {
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = METRICS_HTTP_PORT;
+  config.core_id = NETWORK_TASK_CORE;             // Keep scrapes off Core 1 (RFID)
+  config.task_priority = NETWORK_TASK_PRIORITY;   // Scrapes wait behind WiFi/TCP work
+  config.max_open_sockets = 2;
+  config.max_uri_handlers = 1;
+
+  httpd_handle_t server = nullptr;
+  if (httpd_start(&server, &config) != ESP_OK) {
+    return false;
+  }
+  httpd_uri_t uri = { "/metrics", HTTP_GET, handleMetricsRequest, const_cast<NetworkMetrics*>(metrics) };
+  return httpd_register_uri_handler(server, &uri) == ESP_OK;
+}
@@ -0,0 +1,82 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "Config.h"
+
+// =============================================================
+// NetworkMetrics
+// Counters and gauges of the network task, served in Prometheus
+// text format on http://<device>:METRICS_HTTP_PORT/metrics together
+// with heap, stack and scan latency (LatencyTrace) figures.
+//
+// Single writer (network task). The HTTP server task reads the plain
+// 32-bit fields without locking; a scrape may miss a request that is
+// being recorded at the same moment, nothing worse.
+// =============================================================
+
+enum ScriptAction : uint8_t {
+  SCRIPT_ACTION_READ_PA_DELTA,    // Dongle list sync (GET)
+  SCRIPT_ACTION_WRITE_LOG_BATCH,  // Log upload (POST)
+  SCRIPT_ACTION_COUNT,
+};
+
+// Upper bounds (ms) of the request duration buckets; the last one is the HTTP timeout
+constexpr uint32_t METRICS_REQUEST_BUCKETS_MS[] = { 100, 250, 500, 1000, 2000, 5000, 10000, SCRIPT_HTTP_TIMEOUT_MS };
+constexpr int METRICS_REQUEST_BUCKET_COUNT = sizeof(METRICS_REQUEST_BUCKETS_MS) / sizeof(METRICS_REQUEST_BUCKETS_MS[0]);
+constexpr int METRICS_FAILURE_SLOTS = 8;  // Distinct (action, httpCode) pairs; more go to code="other"
+constexpr int METRICS_MAX_TASKS = 2;
+
+class NetworkMetrics {
+  public:
+    // One request to the web app: duration from sending to the end of the response.
+    // ok = false counts a failure under httpCode (200 = answered, but rejected or unreadable).
+    void recordRequest(ScriptAction action, int httpCode, bool ok, uint32_t durationMs);
+
+    void setLogCounts(uint32_t droppedEvents, uint32_t backlogEvents, uint32_t backlogOverwritten);
+    void setDongleTable(uint32_t size, uint32_t version);
+    void setLinkState(uint8_t state) { _linkState = state; }  // LinkState
+    void setBootReadyMs(uint32_t ms) { _bootReadyMs = ms; }  // Doors and dongle table up, millis() since boot
+    void setLogQueueDepthMax(uint32_t depth) { _logQueueDepthMax = depth; }  // Kept by the producer on every event
+
+    // Report the stack high-water mark of a task as rfid_task_stack_free_min_bytes{task=name}.
+    void watchTask(const char* name, TaskHandle_t task);
+
+    // Write the whole scrape (Prometheus text exposition format 0.0.4).
+    void print(Print& out) const;
+
+  private:
+    struct RequestStats {
+      uint32_t buckets[METRICS_REQUEST_BUCKET_COUNT + 1];  // Last: slower than every bound
+      uint32_t count;
+      uint64_t sumMs;
+    };
+    struct FailureSlot {
+      uint32_t count;
+      int16_t httpCode;
+      uint8_t action;
+      bool used;
+    };
+    struct WatchedTask {
+      const char* name;
+      TaskHandle_t handle;
+    };
+
+    RequestStats _requests[SCRIPT_ACTION_COUNT] = {};
+    FailureSlot _failures[METRICS_FAILURE_SLOTS] = {};
+    uint32_t _otherFailures[SCRIPT_ACTION_COUNT] = {};
+    WatchedTask _tasks[METRICS_MAX_TASKS] = {};
+    uint32_t _logQueueDepthMax = 0;
+    uint32_t _droppedEvents = 0;
+    uint32_t _backlogEvents = 0;
+    uint32_t _backlogOverwritten = 0;
+    uint32_t _dongleTableSize = 0;
+    uint32_t _dongleTableVersion = 0;
+    uint32_t _linkState = 0;
+    uint32_t _bootReadyMs = 0;
+};
+
+// Start the ESP-IDF HTTP server (Core 0, low priority) serving GET /metrics.
+// The server runs in its own task; metrics must outlive it.
+bool startMetricsServer(const NetworkMetrics* metrics);
+
+#endif // METRICS_H
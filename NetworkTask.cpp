@@ -1,50 +1,166 @@
 #include "NetworkTask.h"
 #include "DebugService.h"
+#include "DongleTable.h"
+#include "DongleListParser.h"
+#include "DongleStore.h"
+#include "LatencyTrace.h"
+#include "LinkMonitor.h"
+#include "LogClock.h"
+#include "LogRing.h"
+#include "Metrics.h"
+#include "ScriptClient.h"
 #include "Secrets.h"
+#include "SpscRing.h"
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <Preferences.h>
+#include <esp_random.h>
+#include <algorithm>
 #include <atomic>
+#include <climits>
+#include <new>
 
 // =============================================================
 // Encapsulated State (file-scoped — no external access possible)
 // =============================================================
-static SemaphoreHandle_t mutexDongleList = nullptr;
-static JsonDocument ramDonglesDoc;
-static JsonArray ramDonglesArr;
-static QueueHandle_t logQueue = nullptr;
+static PublishedDongleTable ramDongleTable;  // Written by network task only, read lock-free on Core 1
+static DongleStore dongleStore;               // Flash partition the published table is normally mapped from
+static ScriptClient scriptClient;             // Kept-alive HTTPS connections to the web app (network task only)
+static LogRing failedLogRing;                 // Log events that could not be sent yet (network task only)
+static LinkMonitor linkMonitor;               // Online / degraded / offline, request backoff (network task only)
+static LogClock logClock;                     // Uptime stamps -> wall time (network task only)
+static bool wifiConnected = false;            // Link state as of the last WiFi event handled (network task only)
+static bool wifiConnectedSinceBoot = false;   // First association done, initial dongle fetch ran (network task only)
+static Backoff wifiReconnect(WIFI_RECONNECT_MIN_MS, WIFI_RECONNECT_MAX_MS);  // Network task only
+static NetworkMetrics networkMetrics;         // Written by network task, read by the /metrics server
+static bool dongleStoreDirty = false;         // Published table not in flash (migrated or last save failed)
+static uint32_t dongleListVersion = 0;        // googleScript version of ramDongleTable, 0 = full sync needed
 static QueueHandle_t buzzerSignalQueue = nullptr;
 static TaskHandle_t networkTaskHandle = nullptr;
-static std::atomic<int> droppedLogCount{0};  // Atomic: written on Core 1, read on Core 0
-static unsigned long lastDongleRefreshTime = 0;
-static unsigned long lastWifiReconnectCheck = 0;
-static unsigned long lastLogRetryTime = 0;
+static TaskHandle_t buzzerSignalTask = nullptr;  // Woken with MAIN_NOTIFY_BUZZER_SIGNAL (the loop task)
+
+// Log events from Core 1, written in place by enqueueLogEvent() and taken in
+// contiguous runs by the network task. Single producer: loop() on Core 1.
+#ifdef LOG_QUEUE_IN_PSRAM
+EXT_RAM_BSS_ATTR
+#endif
+static SpscRing<LogEvent, LOG_QUEUE_SIZE> logEventRing;
+static std::atomic<int> droppedLogCount{0};            // Overflow: written on Core 1, read on Core 0
+static std::atomic<uint32_t> logEventRingHighWater{0};  // Written on Core 1, read on Core 0
+static int reportedDroppedLogCount = 0;      // Network task only
+
+// Log batching (network task only)
+static LogEvent pendingLogs[LOG_BATCH_MAX_ENTRIES];        // Taken from logEventRing, not yet sent
+static int pendingLogCount = 0;
+static unsigned long pendingLogSince = 0;                  // millis() when the oldest pending entry was taken
+static LogEvent storedLogBatch[LOG_BATCH_MAX_ENTRIES];     // Backlog replay batch
+static char logBatchBody[LOG_BATCH_MAX_BYTES];
+static char logBatchResponse[LOG_BATCH_RESPONSE_MAX_BYTES];  // Start of the write_log_batch answer
+static char serialCommand[32];                             // Line being typed on Serial (network task only)
+static size_t serialCommandLength = 0;
+
+// Wake-up reasons, set as notification bits on the network task
+constexpr uint32_t NOTIFY_LOG_EVENT = 1 << 0;        // enqueueLogEvent()
+constexpr uint32_t NOTIFY_DONGLE_REFRESH = 1 << 1;   // requestDongleRefresh()
+constexpr uint32_t NOTIFY_SERIAL_COMMAND = 1 << 2;   // Bytes received on Serial (onSerialReceive())
+constexpr uint32_t NOTIFY_WIFI_EVENT = 1 << 3;       // WiFi got an IP or lost the link (onWifiEvent())
+
+enum DongleSyncResult : uint8_t {
+  DONGLE_SYNC_OK,
+  DONGLE_SYNC_FAILED,         // HTTP error, invalid response, out of memory
+  DONGLE_SYNC_HASH_MISMATCH,  // Delta applied to a diverged table — full sync required
+};
 
 // =============================================================
 // Forward Declarations (internal)
 // =============================================================
 static void networkTaskLoop(void* param);
+static unsigned long runDueJobs();
+static void receiveLogEvents();
+static void onWifiEvent(arduino_event_id_t event);
+static void handleWifiEvent();
+static unsigned long reconnectWifiIfDue();
+static void onSerialReceive();
+static void readSerialCommands();
+static void printLatencyReport();
+static void updateMetricsGauges();
+static void syncLogClock();
+static uint32_t nextBootId();
 static void fetchAndStoreDongleIds();
-static bool sendLogEntryViaHttp(const LogEntryStruct& entry);
-static bool sendStoredLogEntries();
-static void saveFailedLogEntry(const LogEntryStruct& entry);
-static int urlEncodeToBuffer(const char* src, char* dest, int destSize);
+static DongleSyncResult syncDongleTable(uint32_t sinceVersion);
+static bool sendLogBatchViaHttp(LogEvent* events, int count);
+static void flushPendingLogs();
+static void spillPendingLogs();
+static void sendStoredLogBatch();
+static void saveFailedLogEvent(const LogEvent& event);
+static void recordScriptRequest(ScriptAction action, int httpCode, bool ok, unsigned long requestStart);
+static void migrateLegacyFailedLogs();
+static size_t buildLogBatchBody(const LogEvent* events, int count, char* body, size_t bodySize);
+static bool parseStoredLogCsv(const char* csv, LogEvent* event);
 static void sendBuzzerSignal(BuzzerSignal signal);
-static bool arrayContains(const JsonArray& arr, const JsonVariant& value);
+static bool loadLegacyDongleJsonFromNvs(DongleTable* table);
+static void removeLegacyDongleNvsKeys();
+
+// Adapts DongleListParser to the Stream interface that HTTPClient::writeToStream()
+// writes into (which also decodes chunked transfer encoding).
+class DongleListSink : public Stream {
+  private:
+    DongleListParser& _parser;
+    unsigned long _parseMicros = 0;
+
+  public:
+    explicit DongleListSink(DongleListParser& parser) : _parser(parser) {}
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+      unsigned long start = micros();
+      bool ok = _parser.feed(reinterpret_cast<const char*>(buffer), size);
+      _parseMicros += micros() - start;
+      return ok ? size : 0;  // Short write aborts the download on invalid input
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+    unsigned long parseMicros() const { return _parseMicros; }
+};
+
+// Keeps the start of a response body in a fixed buffer instead of getString()'s
+// heap copy. The rest is read and discarded, so the connection stays reusable.
+class ResponsePrefixSink : public Stream {
+  private:
+    char* _buf;
+    size_t _size;
+    size_t _length = 0;
+
+  public:
+    ResponsePrefixSink(char* buf, size_t size) : _buf(buf), _size(size) { _buf[0] = '\0'; }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+      size_t copied = std::min(size, _size - 1 - _length);
+      memcpy(_buf + _length, buffer, copied);
+      _length += copied;
+      _buf[_length] = '\0';
+      return size;
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
 
 // =============================================================
 // Public API
 // =============================================================
 
 void startNetworkTask() {
-  // Create mutex (must exist before task starts using the dongle list)
-  mutexDongleList = xSemaphoreCreateMutex();
-  configASSERT(mutexDongleList != nullptr);
+  // The doors are up and the dongle table is loaded: the controller can unlock from here on
+  networkMetrics.setBootReadyMs(millis());
+  DBG(DebugFlags::SETUP, "Doors ready ", millis(), " ms after boot");
 
-  logQueue = xQueueCreate(LOG_QUEUE_SIZE, sizeof(LogEntryStruct));
   buzzerSignalQueue = xQueueCreate(1, sizeof(BuzzerSignal));
-  configASSERT(logQueue != nullptr);
   configASSERT(buzzerSignalQueue != nullptr);
+  buzzerSignalTask = xTaskGetCurrentTaskHandle();
 
   xTaskCreatePinnedToCore(
     networkTaskLoop,
@@ -58,78 +174,74 @@ void startNetworkTask() {
 }
 
 void loadDonglesFromPersistentMemory() {
-  // Must be called BEFORE startNetworkTask() — no mutex taken because
-  // the network task does not exist yet.
+  // Must be called BEFORE startNetworkTask() — the network task is the
+  // only writer of ramDongleTable once it runs.
   configASSERT(networkTaskHandle == nullptr);
 
-  Preferences prefs;
-  prefs.begin("dongleStore", true);  // ReadOnly = true
-  char json[2048];
-  json[0] = '\0';
-  size_t len = prefs.getString(PERS_MEM_DONGLE_IDS, json, sizeof(json));
-  prefs.end();
-  if (len == 0 || json[0] == '\0') {
-    strcpy(json, "[]");
-  }
-
-  DeserializationError error = deserializeJson(ramDonglesDoc, json);
-  if (error) {
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Failed to deserialize persisted dongles: ", error.f_str());
-    ramDonglesDoc.clear();
-    deserializeJson(ramDonglesDoc, "[]");
+  // Mapped flash table: no copy, no parsing. Fall back to the read_pa JSON
+  // older firmware kept in NVS; it is moved to flash on the next fetch.
+  DongleTable table;
+  dongleStore.begin();
+  if (dongleStore.load(&table, &dongleListVersion)) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Mapped ", table.size(), " dongles (version ", dongleListVersion, ") from flash");
+  } else if (loadLegacyDongleJsonFromNvs(&table)) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Loaded ", table.size(), " dongles from legacy NVS JSON");
+    dongleStoreDirty = true;
+  } else {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "No persisted dongles");
+    return;  // Table stays empty
   }
-  ramDonglesArr = ramDonglesDoc.as<JsonArray>();
-  DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Loaded ", ramDonglesArr.size(), " dongles from NVS");
+  ramDongleTable.publish(table);
 }
 
-bool enqueueLogEntry(const LogEntryStruct& entry) {
-  if (logQueue == nullptr) {
+bool enqueueLogEvent(LogEventType type, uint32_t dongleId, uint8_t door) {
+  if (networkTaskHandle == nullptr) {
     return false;
   }
-  if (xQueueSend(logQueue, &entry, 0) != pdTRUE) {
+  LogEvent* slot = logEventRing.reserve();
+  if (slot == nullptr) {
     droppedLogCount++;
-    DBG(DebugFlags::NETWORK_TASK, "Log queue full — entry dropped (total: ", droppedLogCount.load(), ")");
+    DBG(DebugFlags::NETWORK_TASK, "Log queue full — event dropped (total: ", droppedLogCount.load(), ")");
     return false;
   }
+  *slot = makeLogEvent(type, dongleId, door);
+  logEventRing.commit();
+
+  uint32_t depth = logEventRing.size();
+  if (depth > logEventRingHighWater.load(std::memory_order_relaxed)) {
+    logEventRingHighWater.store(depth, std::memory_order_relaxed);
+  }
+  xTaskNotify(networkTaskHandle, NOTIFY_LOG_EVENT, eSetBits);  // Wake the task: no polling delay
   return true;
 }
 
 void requestDongleRefresh() {
   if (networkTaskHandle != nullptr) {
-    xTaskNotify(networkTaskHandle, 0, eNoAction);
+    xTaskNotify(networkTaskHandle, NOTIFY_DONGLE_REFRESH, eSetBits);
   }
 }
 
-bool isDongleIdAuthorized(const String& dongleIdStr) {
+bool isDongleIdAuthorized(uint32_t dongleId, uint8_t door) {
   // MasterCard check: triggers async DB refresh without granting access.
-  // No mutex needed — doesn't read the dongle list.
-  if (dongleIdStr.equals(DONGLE_MASTER_CARD_UPDATE_DB)) {
+  // Doesn't read the dongle list.
+  if (dongleId == DONGLE_MASTER_CARD_ID) {
     DBG(DebugFlags::DONGLE_AUTH, "MasterCard scanned — requesting dongle refresh");
     requestDongleRefresh();
     return false;
   }
 
-  if (xSemaphoreTake(mutexDongleList, pdMS_TO_TICKS(100)) == pdTRUE) {
-    bool authorized = false;
-    for (JsonVariant v : ramDonglesArr) {
-      DBG(DebugFlags::DONGLE_AUTH, "Compare: ", dongleIdStr, " vs ", v.as<String>());
-
-      // Special value: if the list contains OPEN_FOR_ALL_DONGLES, grant access to everyone
-      if (v.as<String>() == OPEN_FOR_ALL_DONGLES) {
-        authorized = true;
-        break;
-      }
-      if (dongleIdStr.equals(v.as<String>())) {
-        authorized = true;
-        break;
-      }
-    }
-    xSemaphoreGive(mutexDongleList);
-    return authorized;
+  // Pin the current table (never blocks, even while the network task publishes).
+  // OPEN_FOR_ALL_DONGLES is precomputed into a flag at build time; otherwise
+  // a binary search over the sorted integer IDs (O(log n), no allocation),
+  // a test of the entry's door mask and, for a time-restricted dongle, one
+  // bit of its precompiled week schedule.
+  bool authorized;
+  {
+    PublishedDongleTable::Reader table(ramDongleTable);
+    authorized = table->isOpenForAll() || table->allows(dongleId, door, time(nullptr));
   }
-
-  DBG(DebugFlags::DONGLE_AUTH, "Mutex timeout — returning unauthorized");
-  return false;
+  DBG(DebugFlags::DONGLE_AUTH, "Table lookup: ", authorized ? "match" : "no match");
+  return authorized;
 }
 
 bool receiveBuzzerSignal(BuzzerSignal* outSignal) {
@@ -143,78 +255,303 @@ bool receiveBuzzerSignal(BuzzerSignal* outSignal) {
 // Network Task Loop (runs on Core 0)
 // =============================================================
 
+// Periodic jobs of the network task. Add new ones here: the loop sleeps
+// until the earliest one is due and wakes early only for notifications.
+struct PeriodicJob {
+  void (*run)();
+  unsigned long intervalMs;
+  unsigned long lastRunMs;  // millis() of the last run (or of task start)
+};
+
+enum PeriodicJobId : uint8_t {
+  JOB_DONGLE_REFRESH,
+#ifdef DEBUG_MODE
+  JOB_MONITOR,
+#endif
+  JOB_COUNT,
+};
+
+#ifdef DEBUG_MODE
+static void logTaskMonitor() {
+  DBG(DebugFlags::NETWORK_TASK, "NetworkTask free stack: ", uxTaskGetStackHighWaterMark(nullptr), " words");
+  DBG(DebugFlags::NETWORK_TASK, "Free heap: ", ESP.getFreeHeap(), " min: ", ESP.getMinFreeHeap());
+  printLatencyReport();
+}
+#endif
+
+static PeriodicJob periodicJobs[JOB_COUNT] = {
+  { fetchAndStoreDongleIds, DONGLE_REFRESH_INTERVAL_MS, 0 },  // JOB_DONGLE_REFRESH
+#ifdef DEBUG_MODE
+  { logTaskMonitor, 60000, 0 },                             // JOB_MONITOR
+#endif
+};
+
 static void networkTaskLoop(void* param) {
   (void)param;
 
-  // Initial dongle fetch from Google Sheets
-  fetchAndStoreDongleIds();
-  lastDongleRefreshTime = millis();
+  // WiFi and NTP come up here, in the background: setup() never waits for them.
+  // Link changes wake the task (no polling).
+  WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+  WiFi.begin(SSID, WIFI_PASSWORD);
+  configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, TIME_SERVER_1, TIME_SERVER_2, TIME_SERVER_3);
+  logClock.begin(nextBootId());
+
+  // Failed-log backlog survives reboots in its own flash partition
+  if (failedLogRing.begin()) {
+    migrateLegacyFailedLogs();
+  }
 
-  for (;;) {
-    // --- WiFi reconnect ---
-    if (millis() - lastWifiReconnectCheck > WIFI_RECONNECT_INTERVAL_MS) {
-      lastWifiReconnectCheck = millis();
-      if (WiFi.status() != WL_CONNECTED) {
-        DBG(DebugFlags::WIFI_LOGGING, "WiFi disconnected, reconnecting...");
-        WiFi.disconnect();
-        WiFi.begin(SSID, WIFI_PASSWORD);
-      }
-    }
+  // Prometheus endpoint; the server binds to any address, so it works once WiFi is up
+  networkMetrics.watchTask("network", networkTaskHandle);
+  networkMetrics.watchTask("loop", buzzerSignalTask);
+  if (!startMetricsServer(&networkMetrics)) {
+    DBG(DebugFlags::NETWORK_TASK, "Metrics server failed to start");
+  }
 
-    // --- Dongle refresh: periodic timer ---
-    if (millis() - lastDongleRefreshTime > DONGLE_REFRESH_INTERVAL_MS) {
-      lastDongleRefreshTime = millis();
-      fetchAndStoreDongleIds();
+  // Serial commands wake the task when bytes arrive (no polling)
+  Serial.onReceive(onSerialReceive);
+
+  for (PeriodicJob& job : periodicJobs) {
+    job.lastRunMs = millis();
+  }
+
+  for (;;) {
+    // --- Run due jobs; sleep until the next deadline or a notification ---
+    syncLogClock();
+    unsigned long waitMs = runDueJobs();
+    uint32_t notifications = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &notifications, pdMS_TO_TICKS(waitMs));
+
+    // --- WiFi up or down; the first association runs the initial dongle fetch ---
+    if (notifications & NOTIFY_WIFI_EVENT) {
+      handleWifiEvent();
     }
 
-    // --- Dongle refresh: on-demand via xTaskNotify (MasterCard scan) ---
-    uint32_t notifyValue;
-    if (xTaskNotifyWait(0, UINT32_MAX, &notifyValue, 0) == pdTRUE) {
+    // --- Dongle refresh: on-demand (MasterCard scan) ---
+    if (notifications & NOTIFY_DONGLE_REFRESH) {
+      PeriodicJob& refresh = periodicJobs[JOB_DONGLE_REFRESH];
       // Debounce: ignore requests within DONGLE_REFRESH_DEBOUNCE_MS of last refresh
-      if (millis() - lastDongleRefreshTime > DONGLE_REFRESH_DEBOUNCE_MS) {
+      if (millis() - refresh.lastRunMs > DONGLE_REFRESH_DEBOUNCE_MS) {
         DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "MasterCard triggered dongle refresh");
         fetchAndStoreDongleIds();
-        lastDongleRefreshTime = millis();
+        refresh.lastRunMs = millis();
       } else {
         DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Refresh debounced (30s cooldown)");
       }
     }
 
-    // --- Retry stored (failed) log entries with backoff ---
-    if (millis() - lastLogRetryTime > LOG_RETRY_BACKOFF_MS) {
-      lastLogRetryTime = millis();
-      sendStoredLogEntries();
+    // --- Serial commands: read on Core 0, printing never delays a scan ---
+    if (notifications & NOTIFY_SERIAL_COMMAND) {
+      readSerialCommands();
+    }
+
+    // --- Log events: taken from the queue as soon as they arrive ---
+    // Drained on every wake-up, the notification bit only ends the sleep.
+    receiveLogEvents();
+    updateMetricsGauges();
+  }
+}
+
+static unsigned long runDueJobs() {
+  // Returns the time until the next job (or the pending log batch) is due
+  unsigned long waitMs = ULONG_MAX;
+  for (PeriodicJob& job : periodicJobs) {
+    if (millis() - job.lastRunMs >= job.intervalMs) {
+      job.lastRunMs = millis();
+      job.run();
+    }
+    unsigned long elapsed = millis() - job.lastRunMs;
+    waitMs = std::min(waitMs, elapsed >= job.intervalMs ? 0 : job.intervalMs - elapsed);
+  }
+
+  // WiFi down: the association is restarted at the backoff's pace
+  if (!wifiConnected) {
+    waitMs = std::min(waitMs, reconnectWifiIfDue());
+  }
+
+  // Backlog: drained one batch per pass while online (new events are taken
+  // in between), one probe batch per backoff step otherwise
+  if (failedLogRing.pendingCount() > 0 && linkMonitor.requestDue(millis())) {
+    sendStoredLogBatch();
+  }
+  if (failedLogRing.pendingCount() > 0) {
+    waitMs = std::min(waitMs, linkMonitor.msUntilRequestDue(millis()));
+  }
+
+  // A partial log batch is sent once its oldest event is LOG_BATCH_MAX_AGE_MS old
+  // (and, without a backlog partition to spill to, the link's backoff allows)
+  if (pendingLogCount > 0) {
+    unsigned long age = millis() - pendingLogSince;
+    if (age >= LOG_BATCH_MAX_AGE_MS && linkMonitor.requestDue(millis())) {
+      flushPendingLogs();
+    } else {
+      waitMs = std::min(waitMs, std::max(age >= LOG_BATCH_MAX_AGE_MS ? 0 : LOG_BATCH_MAX_AGE_MS - age,
+                                         linkMonitor.msUntilRequestDue(millis())));
     }
+  }
+  return waitMs;
+}
 
-    // --- Process queued log entries ---
-    LogEntryStruct entry;
-    while (xQueueReceive(logQueue, &entry, 0) == pdTRUE) {
-      if (!sendLogEntryViaHttp(entry)) {
-        saveFailedLogEntry(entry);
-        sendBuzzerSignal(BUZZER_SOS);
-        break;  // Stop processing queue — likely no connectivity
+static void receiveLogEvents() {
+  const LogEvent* events;
+  uint32_t count;
+
+  // Link not online, or a backlog still being sent: events go straight to the
+  // backlog (no RAM batch waiting for a link that is down, no ring filling
+  // up behind it), where scans are sent ahead of door events
+  if (failedLogRing.capacity() > 0 && (!linkMonitor.isOnline() || failedLogRing.pendingCount() > 0)) {
+    spillPendingLogs();
+    while ((count = logEventRing.peek(&events)) > 0) {
+      for (uint32_t i = 0; i < count; i++) {
+        LogEvent event = events[i];
+        event.epoch = logClock.fromUptime(event.epoch);
+        saveFailedLogEvent(event);
       }
+      logEventRing.release(count);
+    }
+  }
+
+  // Online: collect queued events into the pending batch; send as soon as it is full
+  while ((count = logEventRing.peek(&events)) > 0) {
+    if (pendingLogCount == 0) {
+      pendingLogSince = millis();
+    }
+    count = std::min(count, (uint32_t)(LOG_BATCH_MAX_ENTRIES - pendingLogCount));
+    for (uint32_t i = 0; i < count; i++) {
+      pendingLogs[pendingLogCount + i] = events[i];
+      pendingLogs[pendingLogCount + i].epoch = logClock.fromUptime(events[i].epoch);
     }
+    logEventRing.release(count);
+    pendingLogCount += count;
+    if (pendingLogCount == LOG_BATCH_MAX_ENTRIES) {
+      flushPendingLogs();
+    }
+  }
+
+  int dropped = droppedLogCount.load();
+  if (dropped != reportedDroppedLogCount) {
+    reportedDroppedLogCount = dropped;
+    DBG(DebugFlags::NETWORK_TASK, "WARNING: ", dropped, " log events dropped since startup");
+  }
+}
+
+static void updateMetricsGauges() {
+  // Cheap snapshots of network-task state for the /metrics server task
+  networkMetrics.setLogCounts(droppedLogCount.load(), failedLogRing.pendingCount(), failedLogRing.droppedCount());
+  networkMetrics.setLogQueueDepthMax(logEventRingHighWater.load(std::memory_order_relaxed));
+  networkMetrics.setLinkState(linkMonitor.state());
+  PublishedDongleTable::Reader table(ramDongleTable);
+  networkMetrics.setDongleTable(table->size(), dongleListVersion);
+}
+
+static void syncLogClock() {
+  // NTP sets the clock in the background; checked on every wake-up, which also follows its corrections
+  bool wasSet = logClock.isSet();
+  logClock.sync((uint32_t)time(nullptr), uptimeSeconds());
+  if (!wasSet && logClock.isSet()) {
+    DBG(DebugFlags::NETWORK_TASK, "Clock set ", millis(), " ms after boot — log times back-filled from here on");
+  }
+}
+
+static uint32_t nextBootId() {
+  // Tags this boot's boot-relative log times (one NVS write per boot)
+  Preferences prefs;
+  prefs.begin(PERS_MEM_LOG_CLOCK, false);
+  uint32_t bootId = LogClock::nextBootId(prefs.getUInt(PERS_MEM_BOOT_ID, 0));
+  prefs.putUInt(PERS_MEM_BOOT_ID, bootId);
+  prefs.end();
+  return bootId;
+}
+
+static void onWifiEvent(arduino_event_id_t event) {
+  // Runs in the WiFi event task: only wakes the network task, which reads the link state
+  (void)event;
+  xTaskNotify(networkTaskHandle, NOTIFY_WIFI_EVENT, eSetBits);
+}
 
-    // --- Dropped log warning ---
-    int dropped = droppedLogCount.load();
-    if (dropped > 0) {
-      DBG(DebugFlags::NETWORK_TASK, "WARNING: ", dropped, " log entries dropped since startup");
+static void handleWifiEvent() {
+  // Events may pile up between wake-ups: the current status is what counts
+  bool connected = WiFi.status() == WL_CONNECTED;
+  if (connected == wifiConnected) {
+    return;
+  }
+  wifiConnected = connected;
+  linkMonitor.onWifi(connected);
+  if (connected) {
+    wifiReconnect.reset();
+    if (!wifiConnectedSinceBoot) {
+      // Initial dongle fetch from Google Sheets: as soon as WiFi is associated
+      wifiConnectedSinceBoot = true;
+      DBG(DebugFlags::WIFI_LOGGING, "WiFi connected ", millis(), " ms after boot, IP: ", WiFi.localIP());
+      fetchAndStoreDongleIds();
+      periodicJobs[JOB_DONGLE_REFRESH].lastRunMs = millis();
     }
+    return;
+  }
+  // Just lost: the driver tries to reassociate on its own first
+  DBG(DebugFlags::WIFI_LOGGING, "WiFi disconnected");
+  scriptClient.disconnect();  // Sockets of the old link are dead
+  wifiReconnect.fail(millis(), esp_random());
+}
+
+static unsigned long reconnectWifiIfDue() {
+  // Returns the time until the next attempt
+  if (!wifiConnectedSinceBoot && millis() < WIFI_CONNECT_TIMEOUT_MS) {
+    return WIFI_CONNECT_TIMEOUT_MS - millis();  // First association since boot still in progress
+  }
+  if (!wifiReconnect.due(millis())) {
+    return wifiReconnect.msUntilDue(millis());
+  }
+  // Restarting the association interrupts one in progress: only at the backoff's pace
+  DBG(DebugFlags::WIFI_LOGGING, "WiFi still disconnected, reconnecting...");
+  WiFi.disconnect();
+  WiFi.begin(SSID, WIFI_PASSWORD);
+  wifiReconnect.fail(millis(), esp_random());
+  return wifiReconnect.msUntilDue(millis());
+}
+
+// =============================================================
+// Serial Commands (Core 0: printing never delays a scan on Core 1)
+//   latency        print the scan latency histograms
+//   latency reset  clear them
+// =============================================================
+
+static void onSerialReceive() {
+  // Runs in the UART driver's event task: only wakes the network task, which reads the bytes
+  xTaskNotify(networkTaskHandle, NOTIFY_SERIAL_COMMAND, eSetBits);
+}
 
-    // --- Debug monitoring (stack + heap) ---
-    #ifdef DEBUG_MODE
-    {
-      static unsigned long lastMonitorCheck = 0;
-      if (millis() - lastMonitorCheck > 60000) {
-        lastMonitorCheck = millis();
-        DBG(DebugFlags::NETWORK_TASK, "NetworkTask free stack: ", uxTaskGetStackHighWaterMark(nullptr), " words");
-        DBG(DebugFlags::NETWORK_TASK, "Free heap: ", ESP.getFreeHeap(), " min: ", ESP.getMinFreeHeap());
+static void readSerialCommands() {
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    if (c != '\r' && c != '\n') {
+      if (serialCommandLength < sizeof(serialCommand) - 1) {
+        serialCommand[serialCommandLength++] = (char)c;
       }
+      continue;
+    }
+    serialCommand[serialCommandLength] = '\0';
+    serialCommandLength = 0;
+
+    if (strcmp(serialCommand, "latency") == 0) {
+      printLatencyReport();
+    } else if (strcmp(serialCommand, "latency reset") == 0) {
+      requestLatencyTraceReset();
+      Serial.println("Latency trace reset");
+    } else if (serialCommand[0] != '\0') {
+      Serial.print("Unknown command: ");
+      Serial.println(serialCommand);
     }
-    #endif
+  }
+}
 
-    vTaskDelay(pdMS_TO_TICKS(NETWORK_TASK_LOOP_DELAY_MS));
+static void printLatencyReport() {
+  char line[LATENCY_REPORT_LINE_MAX];
+  Serial.println("Scan latency since last Wiegand bit (buckets <us:count):");
+  for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+    formatLatencyHistogram((LatencyStage)stage, line, sizeof(line));
+    Serial.println(line);
   }
 }
 
@@ -225,309 +562,392 @@ static void networkTaskLoop(void* param) {
 static void fetchAndStoreDongleIds() {
   DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Begin fetchAndStoreDongleIds()");
 
-  // --- Step 1: Read persisted dongles from NVS into stack buffer ---
-  Preferences prefs;
-  prefs.begin("dongleStore", true);  // ReadOnly = true
-  char persJson[2048];
-  persJson[0] = '\0';
-  size_t persLen = prefs.getString(PERS_MEM_DONGLE_IDS, persJson, sizeof(persJson));
-  prefs.end();
-  if (persLen == 0 || persJson[0] == '\0') {
-    strcpy(persJson, "[]");
+  // Ask only for the changes since our version; version 0 returns the full list
+  DongleSyncResult result = syncDongleTable(dongleListVersion);
+  if (result == DONGLE_SYNC_HASH_MISMATCH && dongleListVersion != 0) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Delta result differs from server list — full sync");
+    result = syncDongleTable(0);
+  }
+  if (result != DONGLE_SYNC_OK) {
+    sendBuzzerSignal(BUZZER_SOS);
   }
 
-  // --- Step 2: Fetch from Google Sheets (outside mutex!) ---
-  HTTPClient http;
-  http.setTimeout(20000);
-  http.begin(WEB_APP_URL_READ);
-  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-  int httpCode = http.GET();
+  DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "End fetchAndStoreDongleIds()");
+}
+
+static DongleSyncResult syncDongleTable(uint32_t sinceVersion) {
+  // --- Step 1: Fetch the delta from Google Sheets (kept-alive connection) ---
+  char query[64];
+  snprintf(query, sizeof(query), "action=read_pa_delta&since=%lu", (unsigned long)sinceVersion);
+  unsigned long requestStart = millis();
+  scriptClient.setTimeout(linkMonitor.requestTimeoutMs());
+  int httpCode = scriptClient.get(query);
 
   if (httpCode != 200) {
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "HTTP error: ", httpCode, " - ", http.errorToString(httpCode));
-    http.end();
-    sendBuzzerSignal(BUZZER_SOS);
-    return;
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "HTTP error: ", httpCode, " - ", HTTPClient::errorToString(httpCode));
+    scriptClient.end();
+    recordScriptRequest(SCRIPT_ACTION_READ_PA_DELTA, httpCode, false, requestStart);
+    return DONGLE_SYNC_FAILED;
   }
 
-  // --- Step 3: Read response into stack buffer via stream (zero heap allocation) ---
-  char payload[2048];
-  WiFiClient* stream = http.getStreamPtr();
-  if (stream == nullptr) {
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "No stream available");
-    http.end();
-    sendBuzzerSignal(BUZZER_SOS);
-    return;
+  // --- Step 2: Stream-parse the body straight into integer tables ---
+  // Single pass, no payload buffer: memory is the tables themselves (4 bytes per ID)
+  // regardless of list size. Invalid input aborts the download early.
+  DongleListParser parser;
+  DongleListSink sink(parser);
+  int written = scriptClient.response().writeToStream(&sink);
+  if (written < 0) {
+    scriptClient.disconnect();  // Unread rest of the body would corrupt the next response
+  } else {
+    scriptClient.end();
   }
-  size_t bytesRead = stream->readBytes(payload, sizeof(payload) - 1);
-  payload[bytesRead] = '\0';
-  http.end();
+  recordScriptRequest(SCRIPT_ACTION_READ_PA_DELTA, httpCode, written >= 0, requestStart);
 
-  if (bytesRead == 0) {
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Empty response");
-    sendBuzzerSignal(BUZZER_SOS);
-    return;
+  DongleTable added;
+  DongleTable removed;
+  if (written < 0 || !parser.finish(&added, &removed)) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Dongle list rejected: ", parser.statusString(), " (stream result ", written, ")");
+    return DONGLE_SYNC_FAILED;
   }
-
-  // --- Step 4: Validate response by parsing (still outside mutex) ---
-  JsonDocument validationDoc;
-  DeserializationError error = deserializeJson(validationDoc, payload);
-  if (error) {
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Failed to deserialize online dongles: ", error.f_str());
-    sendBuzzerSignal(BUZZER_SOS);
-    return;
+  if (parser.isDelta() && parser.version() == 0) {
+    // Versions start at 1 — this is an error object (e.g. script without read_pa_delta)
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Dongle delta rejected: no version");
+    return DONGLE_SYNC_FAILED;
   }
+  DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Version ", sinceVersion, " -> ", parser.version(),
+      parser.isReset() ? " (full): +" : ": +", added.size(), " -", removed.size(), " (", parser.skippedCount(),
+      " skipped) in ", sink.parseMicros(), " us");
 
   #ifdef DEBUG_MODE
   if (DebugFlags::FETCH_AND_STORE_DONGLE_IDS_DETAIL) {
-    JsonArray debugArr = validationDoc.as<JsonArray>();
-    for (JsonVariant v : debugArr) {
-      DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS_DETAIL, "  online: ", v.as<String>());
+    char idStr[CharArrayDongleIdSize];
+    for (size_t i = 0; i < added.size(); i++) {
+      formatDongleId(added.ids()[i], idStr);
+      DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS_DETAIL, "  added: ", idStr);
+    }
+    for (size_t i = 0; i < removed.size(); i++) {
+      formatDongleId(removed.ids()[i], idStr);
+      DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS_DETAIL, "  removed: ", idStr);
     }
   }
   #endif
 
-  // --- Step 5: Compare online vs. persisted ---
-  // Simple string comparison of raw JSON payloads. The Google Script returns
-  // deterministic JSON, and persJson is the raw payload from the previous fetch.
-  bool isDifferent = (strcmp(payload, persJson) != 0);
-  if (isDifferent) {
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Online data differs from persisted");
+  // --- Step 3: Build the new table and compare with the one in RAM ---
+  // A reset (or a plain list) replaces the table; a delta is merged into it.
+  // Core 1 keeps reading the published table meanwhile.
+  DongleTable newTable;
+  bool isDifferent;
+  {
+    PublishedDongleTable::Reader current(ramDongleTable);
+    if (!parser.isDelta() || parser.isReset()) {
+      newTable.swap(added);
+    } else if (!newTable.assignDelta(*current, added, removed)) {
+      DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Out of memory (or schedules) applying dongle delta");
+      return DONGLE_SYNC_FAILED;
+    }
+    isDifferent = !newTable.equals(*current);
   }
 
-  // --- Step 6: Update NVS if different (NVS confined to this task — no concurrent access) ---
-  if (isDifferent) {
-    Preferences prefsWrite;
-    prefsWrite.begin("dongleStore", false);
-    prefsWrite.putString(PERS_MEM_DONGLE_IDS, payload);  // Overwrite directly, no clear() needed
-    prefsWrite.end();
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "NVS updated with new dongle list");
-  }
-
-  // --- Step 7: Pre-parse JSON outside mutex, then swap inside (brief critical section) ---
-  JsonDocument newDoc;
-  deserializeJson(newDoc, isDifferent ? payload : persJson);
-
-  if (xSemaphoreTake(mutexDongleList, pdMS_TO_TICKS(100)) == pdTRUE) {
-    ramDonglesDoc = std::move(newDoc);
-    ramDonglesArr = ramDonglesDoc.as<JsonArray>();
-    int newSize = ramDonglesArr.size();  // Capture inside mutex before releasing
-    xSemaphoreGive(mutexDongleList);
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "RAM updated: ", newSize, " dongles");
-  } else {
-    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Mutex timeout during RAM update!");
+  // Self-check: a lost flash write or a skipped server version would otherwise persist silently
+  uint32_t newVersion = parser.version();
+  if (parser.isDelta() && newTable.hash() != parser.hash()) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Dongle hash mismatch (local ", newTable.hash(), ", server ", parser.hash(), ")");
+    return DONGLE_SYNC_HASH_MISMATCH;
   }
 
+  bool versionChanged = newVersion != dongleListVersion;
+  if (!isDifferent && !versionChanged && !dongleStoreDirty) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Dongle list unchanged");
+    return DONGLE_SYNC_OK;  // Common case: no flash write, no publish
+  }
+
+  // --- Step 4: Persist into the inactive flash slot (single writer: this task) ---
+  // On success the heap copy is replaced by a view of the new slot. It must be
+  // published even if the IDs are unchanged: the next save overwrites the slot
+  // the currently published view points into.
+  bool saved = dongleStore.save(newTable, newVersion);
+  if (saved) {
+    if (dongleStoreDirty) {
+      removeLegacyDongleNvsKeys();
+    }
+    uint32_t storedVersion;
+    dongleStore.load(&newTable, &storedVersion);
+  } else {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Flash write failed — RAM table only, retry on next fetch");
+  }
+  dongleStoreDirty = !saved;
+  dongleListVersion = newVersion;
+
+  // --- Step 5: Publish with a single atomic swap ---
+  if (isDifferent || saved) {
+    DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Published ", newTable.size(), " dongles", saved ? " (flash)" : " (RAM)");
+    ramDongleTable.publish(newTable);
+    // newTable now holds the retired table (no reader left) and frees it on return
+  }
   if (isDifferent) {
     sendBuzzerSignal(BUZZER_OK);
   }
-
-  DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "End fetchAndStoreDongleIds()");
+  return DONGLE_SYNC_OK;
 }
 
-static bool sendLogEntryViaHttp(const LogEntryStruct& entry) {
-  // Build URL in stack buffer — zero heap allocation
-  char url[384];
-  int pos = snprintf(url, sizeof(url), "%s?action=write_log_pa&date=", WEB_APP_URL);
-  pos += urlEncodeToBuffer(entry.date, url + pos, sizeof(url) - pos);
-  pos += snprintf(url + pos, sizeof(url) - pos, "&time=");
-  pos += urlEncodeToBuffer(entry.time, url + pos, sizeof(url) - pos);
-  pos += snprintf(url + pos, sizeof(url) - pos, "&access=");
-  pos += urlEncodeToBuffer(entry.access, url + pos, sizeof(url) - pos);
-  pos += snprintf(url + pos, sizeof(url) - pos, "&dongle_id=");
-  pos += urlEncodeToBuffer(entry.dongle_id, url + pos, sizeof(url) - pos);
+static bool sendLogBatchViaHttp(LogEvent* events, int count) {
+  // One POST for the whole batch; body built in a static buffer — zero heap allocation.
+  // Events stamped before the clock was set get their wall time now, if it is set.
+  for (int i = 0; i < count; i++) {
+    events[i].epoch = logClock.backfill(events[i].epoch);
+  }
+  size_t length = buildLogBatchBody(events, count, logBatchBody, sizeof(logBatchBody));
+  unsigned long requestStart = millis();
+  scriptClient.setTimeout(linkMonitor.requestTimeoutMs());
+  int httpCode = scriptClient.post("action=write_log_batch", reinterpret_cast<const uint8_t*>(logBatchBody),
+                                   length, "application/json");
+
+  // Script errors also come back as 200 — only "success":true means the rows were written
+  bool ok = false;
+  if (httpCode == 200) {
+    ResponsePrefixSink sink(logBatchResponse, sizeof(logBatchResponse));
+    scriptClient.response().writeToStream(&sink);
+    ok = strstr(logBatchResponse, "\"success\":true") != nullptr;
+  }
+  scriptClient.end();
+  recordScriptRequest(SCRIPT_ACTION_WRITE_LOG_BATCH, httpCode, ok, requestStart);
 
-  HTTPClient http;
-  http.begin(url);
-  http.setTimeout(20000);
-  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-  int httpCode = http.GET();
-  http.end();
+  // Accepted with the 302 but the result could not be fetched: the script has run,
+  // so the rows are (almost certainly) written. Sending the batch again would
+  // write them twice; only a script error in the lost result drops the batch.
+  bool delivered = ok || (httpCode != 200 && scriptClient.scriptRan());
 
-  return httpCode == 200;
+  DBG(DebugFlags::NETWORK_TASK, "Log batch of ", count, " (", length, " bytes): ",
+      ok ? "sent" : delivered ? "sent, result lost" : "FAILED", " (HTTP ", httpCode, ")");
+  return delivered;
 }
 
-static bool sendStoredLogEntries() {
-  DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Start sendStoredLogEntries()");
+static void flushPendingLogs() {
+  if (sendLogBatchViaHttp(pendingLogs, pendingLogCount)) {
+    pendingLogCount = 0;
+  } else {
+    spillPendingLogs();
+    sendBuzzerSignal(BUZZER_SOS);
+  }
+}
 
-  Preferences prefsLog;
-  prefsLog.begin(PERS_MEM_FAILED_LOGS, false);
+static void recordScriptRequest(ScriptAction action, int httpCode, bool ok, unsigned long requestStart) {
+  // Every request to the web app: metrics, and the link state that paces the next ones
+  networkMetrics.recordRequest(action, httpCode, ok, millis() - requestStart);
+  linkMonitor.onRequest(ok, millis(), esp_random());
+}
 
-  // Read keyArray from NVS into stack buffer
-  JsonDocument doc;
-  char keyArrayBuf[1024];
-  keyArrayBuf[0] = '\0';
-  size_t keyBufLen = prefsLog.getString("keyArray", keyArrayBuf, sizeof(keyArrayBuf));
-  if (keyBufLen == 0 || keyArrayBuf[0] == '\0') {
-    strcpy(keyArrayBuf, "[]");
-  }
-  DeserializationError error = deserializeJson(doc, keyArrayBuf);
-  if (error) {
-    DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Failed to deserialize keyArray: ", error.f_str());
-    prefsLog.clear();
-    prefsLog.end();
-    return true;  // Corrupted data cleared — treat as empty
+static void spillPendingLogs() {
+  // The link went down while a batch was being collected
+  for (int i = 0; i < pendingLogCount; i++) {
+    pendingLogs[i].epoch = logClock.backfill(pendingLogs[i].epoch);
+    saveFailedLogEvent(pendingLogs[i]);
   }
-  JsonArray keyArray = doc.as<JsonArray>();
+  pendingLogCount = 0;
+}
 
-  if (keyArray.size() == 0) {
-    prefsLog.end();
-    return true;  // Nothing stored
+static void sendStoredLogBatch() {
+  // Scans first, then door events; entries are marked sent only after the POST succeeded.
+  // A failure is retried once the link monitor's backoff allows.
+  int count = failedLogRing.peekPrioritized(storedLogBatch, LOG_BATCH_MAX_ENTRIES);
+  if (count == 0) {
+    return;
   }
-
-  int originalKeyCount = keyArray.size();
-  int i = 0;
-  while (i < (int)keyArray.size()) {
-    // Read CSV log entry into stack buffer
-    const char* key = keyArray[i].as<const char*>();
-    char csv[128];  // Max: date(10)+time(8)+access(14)+dongle(26)+3commas+null = 62
-    csv[0] = '\0';
-    size_t csvLen = prefsLog.getString(key, csv, sizeof(csv));
-
-    if (csvLen > 0 && csv[0] != '\0') {
-      int c1 = -1, c2 = -1, c3 = -1;
-      for (int j = 0; csv[j] != '\0'; j++) {
-        if (csv[j] == ',') {
-          if (c1 < 0) c1 = j;
-          else if (c2 < 0) c2 = j;
-          else if (c3 < 0) { c3 = j; break; }
-        }
-      }
-
-      // Validate CSV structure — malformed entries are removed
-      if (c1 < 0 || c2 < 0 || c3 < 0) {
-        DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Malformed CSV entry removed: ", key);
-        prefsLog.remove(key);
-        keyArray.remove(i);
-        continue;
-      }
-
-      // Parse CSV fields directly from the stack buffer
-      LogEntryStruct entry;
-      csv[c1] = '\0';  // Terminate date
-      csv[c2] = '\0';  // Terminate time
-      csv[c3] = '\0';  // Terminate access
-      safeCopyStringToChar(csv, entry.date, CharArrayDateSize);
-      safeCopyStringToChar(csv + c1 + 1, entry.time, CharArrayTimeSize);
-      safeCopyStringToChar(csv + c2 + 1, entry.access, CharArrayAccessSize);
-      safeCopyStringToChar(csv + c3 + 1, entry.dongle_id, CharArrayDongleIdSize);
-
-      if (sendLogEntryViaHttp(entry)) {
-        prefsLog.remove(key);
-        keyArray.remove(i);
-        // No i++ needed — array shifted left
-      } else {
-        break;  // No connectivity — stop trying
-      }
-    } else {
-      // Empty entry — remove orphaned key to prevent accumulation
-      prefsLog.remove(key);
-      keyArray.remove(i);
-    }
-
-    vTaskDelay(1);  // Yield between HTTP calls
+  DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Sending stored log batch of ", count, " (", failedLogRing.pendingCount(), " pending)");
+  if (sendLogBatchViaHttp(storedLogBatch, count)) {
+    failedLogRing.consume();
   }
+}
 
-  if (keyArray.size() == 0) {
-    prefsLog.remove("keyArray");
-    prefsLog.end();
-    return true;
-  } else if ((int)keyArray.size() != originalKeyCount) {
-    // Partial success — serialize to stack buffer and update NVS
-    char updatedBuf[1024];
-    serializeJson(doc, updatedBuf, sizeof(updatedBuf));
-    prefsLog.putString("keyArray", updatedBuf);
-    prefsLog.end();
-    return false;
-  } else {
-    prefsLog.end();
-    return false;
+static void saveFailedLogEvent(const LogEvent& event) {
+  // O(1) append; when the ring is full the oldest sector of events is overwritten
+  if (!failedLogRing.append(event)) {
+    DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Failed to store log event — lost");
   }
 }
 
-static void saveFailedLogEntry(const LogEntryStruct& entry) {
+static void migrateLegacyFailedLogs() {
+  // One-time migration: firmware before the log ring kept one NVS key per entry,
+  // listed in the JSON array "keyArray" (["log1","log2",...])
   Preferences prefsLog;
   prefsLog.begin(PERS_MEM_FAILED_LOGS, false);
-
-  // Read keyArray from NVS into stack buffer
-  JsonDocument doc;
   char keyArrayBuf[1024];
   keyArrayBuf[0] = '\0';
-  size_t keyBufLen = prefsLog.getString("keyArray", keyArrayBuf, sizeof(keyArrayBuf));
-  if (keyBufLen == 0 || keyArrayBuf[0] == '\0') {
-    strcpy(keyArrayBuf, "[]");
-  }
-  DeserializationError error = deserializeJson(doc, keyArrayBuf);
-  if (error) {
-    doc.clear();
-    deserializeJson(doc, "[]");
-  }
-  JsonArray keyArray = doc.as<JsonArray>();
-
-  // Enforce maximum stored log count to prevent NVS partition exhaustion.
-  // Oldest entries are discarded first (FIFO).
-  while ((int)keyArray.size() >= MAX_FAILED_LOGS) {
-    const char* oldestKey = keyArray[0].as<const char*>();
-    DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "NVS full — discarded oldest log: ", oldestKey);
-    prefsLog.remove(oldestKey);
-    keyArray.remove(0);
-  }
-
-  // Generate unique key using monotonic counter (avoids O(n^2) search)
-  int nextIndex = prefsLog.getInt("nextIdx", 1);
-  char newKey[16];
-  snprintf(newKey, sizeof(newKey), "log%d", nextIndex);
-  prefsLog.putInt("nextIdx", nextIndex + 1);
-
-  // Build CSV in stack buffer
-  char csv[128];
-  snprintf(csv, sizeof(csv), "%s,%s,%s,%s", entry.date, entry.time, entry.access, entry.dongle_id);
-  prefsLog.putString(newKey, csv);
-
-  keyArray.add(newKey);
-
-  // Serialize updated keyArray to stack buffer
-  char updatedBuf[1024];
-  serializeJson(doc, updatedBuf, sizeof(updatedBuf));
-  prefsLog.putString("keyArray", updatedBuf);
+  if (prefsLog.getString("keyArray", keyArrayBuf, sizeof(keyArrayBuf)) == 0 || keyArrayBuf[0] == '\0') {
+    prefsLog.end();
+    return;
+  }
+
+  int migrated = 0;
+  char* key = strchr(keyArrayBuf, '"');
+  while (key != nullptr) {
+    char* keyEnd = strchr(key + 1, '"');
+    if (keyEnd == nullptr) {
+      break;
+    }
+    *keyEnd = '\0';
+    char csv[128];
+    csv[0] = '\0';
+    LogEvent event{};
+    if (prefsLog.getString(key + 1, csv, sizeof(csv)) > 0 && parseStoredLogCsv(csv, &event) &&
+        failedLogRing.append(event)) {
+      migrated++;
+    }
+    key = strchr(keyEnd + 1, '"');
+  }
+  prefsLog.clear();  // Namespace only ever held the failed logs
   prefsLog.end();
+  DBG(DebugFlags::SEND_STORED_LOG_ENTRIES, "Migrated ", migrated, " failed log entries from NVS");
 }
 
 // =============================================================
 // Utility Functions (internal)
 // =============================================================
 
-static int urlEncodeToBuffer(const char* src, char* dest, int destSize) {
-  // URL-encode src directly into dest buffer (RFC 3986, zero heap allocation).
-  // Returns number of bytes written (excluding null terminator).
-  int pos = 0;
-  for (int i = 0; src[i] != '\0' && pos < destSize - 4; i++) {
+// Sheet strings of LogEventType
+static const char* const LOG_EVENT_ACCESS[LOG_EVENT_TYPE_COUNT] = {
+  "authorised", "denied", "door_is_closed", "door_is_open",
+};
+static const char LOG_DOOR_DONGLE_ID[] = "doorstate";  // dongle_id column of door events
+
+// Longest entry: 5 fields at full length, 10 quotes, 4 commas, 2 brackets and the separator
+static_assert(LOG_BATCH_MAX_ENTRIES * (CharArrayDateSize + CharArrayTimeSize + CharArrayAccessSize + CharArrayDongleIdSize + DOOR_NAME_MAX + 12) + 2 < LOG_BATCH_MAX_BYTES,
+              "A full log batch must fit into LOG_BATCH_MAX_BYTES");
+
+static size_t appendJsonString(char* dest, size_t destSize, size_t pos, const char* src) {
+  // Append src as a JSON string. Log fields are dates, times, fixed access words
+  // and binary IDs; quotes, backslashes and control characters are dropped.
+  if (pos < destSize) dest[pos++] = '"';
+  for (int i = 0; src[i] != '\0' && pos < destSize; i++) {
     char c = src[i];
-    if (isAlphaNumeric(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+    if (c != '"' && c != '\\' && (unsigned char)c >= 0x20) {
       dest[pos++] = c;
-    } else {
-      pos += snprintf(dest + pos, destSize - pos, "%%%02X", (unsigned char)c);
     }
   }
-  if (pos < destSize) {
-    dest[pos] = '\0';
+  if (pos < destSize) dest[pos++] = '"';
+  return pos;
+}
+
+static size_t buildLogBatchBody(const LogEvent* events, int count, char* body, size_t bodySize) {
+  // [["date","time","access","dongle_id","door"], ...] — the write_log_batch format of googleScript.
+  // The only place events are turned into text (local time, binary ID strings).
+  // LOG_BATCH_MAX_ENTRIES is sized so that a full batch always fits bodySize.
+  size_t pos = 0;
+  body[pos++] = '[';
+  for (int i = 0; i < count; i++) {
+    const LogEvent& event = events[i];
+    char date[CharArrayDateSize];
+    char time[CharArrayTimeSize];
+    time_t epoch = event.epoch;
+    struct tm timeinfo;
+    if (event.epoch >= LOG_EVENT_MIN_VALID_EPOCH && localtime_r(&epoch, &timeinfo) != nullptr) {
+      strftime(date, sizeof(date), "%d.%m.%Y", &timeinfo);
+      strftime(time, sizeof(time), "%H:%M:%S", &timeinfo);
+    } else {
+      strcpy(date, "Date Error");  // Event before the first NTP sync
+      strcpy(time, "Date Err");
+    }
+    bool isDoorEvent = event.type == LOG_EVENT_DOOR_CLOSED || event.type == LOG_EVENT_DOOR_OPEN;
+    char dongleId[CharArrayDongleIdSize];
+    if (isDoorEvent) {
+      strcpy(dongleId, LOG_DOOR_DONGLE_ID);
+    } else {
+      formatDongleId(event.dongleId, dongleId);
+    }
+
+    if (i > 0) body[pos++] = ',';
+    body[pos++] = '[';
+    pos = appendJsonString(body, bodySize, pos, date);
+    body[pos++] = ',';
+    pos = appendJsonString(body, bodySize, pos, time);
+    body[pos++] = ',';
+    pos = appendJsonString(body, bodySize, pos, event.type < LOG_EVENT_TYPE_COUNT ? LOG_EVENT_ACCESS[event.type] : "");
+    body[pos++] = ',';
+    pos = appendJsonString(body, bodySize, pos, dongleId);
+    body[pos++] = ',';
+    pos = appendJsonString(body, bodySize, pos, event.door < DOOR_COUNT ? DOORS[event.door].name : "");
+    body[pos++] = ']';
   }
+  body[pos++] = ']';
+  body[pos] = '\0';
   return pos;
 }
 
+static bool parseStoredLogCsv(const char* csv, LogEvent* event) {
+  // Convert a legacy NVS entry "DD.MM.YYYY,HH:MM:SS,access,dongle_id" back into an event.
+  // "Date Error" timestamps become epoch 0. Returns false if any field is malformed.
+  char date[CharArrayDateSize];
+  char time[CharArrayTimeSize];
+  char access[CharArrayAccessSize];
+  char dongleId[CharArrayDongleIdSize];
+  if (sscanf(csv, "%10[^,],%8[^,],%14[^,],%26s", date, time, access, dongleId) != 4) {
+    return false;
+  }
+
+  int type = 0;
+  while (type < LOG_EVENT_TYPE_COUNT && strcmp(access, LOG_EVENT_ACCESS[type]) != 0) {
+    type++;
+  }
+  if (type == LOG_EVENT_TYPE_COUNT) {
+    return false;
+  }
+  bool isDoorEvent = type == LOG_EVENT_DOOR_CLOSED || type == LOG_EVENT_DOOR_OPEN;
+  uint32_t id = isDoorEvent ? 0 : decodeDongleId(dongleId);
+  if (id == INVALID_DONGLE_ID) {
+    return false;
+  }
+
+  struct tm timeinfo;
+  memset(&timeinfo, 0, sizeof(timeinfo));
+  uint32_t epoch = 0;
+  if (sscanf(date, "%d.%d.%d", &timeinfo.tm_mday, &timeinfo.tm_mon, &timeinfo.tm_year) == 3 &&
+      sscanf(time, "%d:%d:%d", &timeinfo.tm_hour, &timeinfo.tm_min, &timeinfo.tm_sec) == 3) {
+    timeinfo.tm_mon -= 1;
+    timeinfo.tm_year -= 1900;
+    timeinfo.tm_isdst = -1;
+    time_t local = mktime(&timeinfo);
+    epoch = local > 0 ? (uint32_t)local : 0;
+  }
+
+  event->epoch = epoch;
+  event->dongleId = id;
+  event->type = type;
+  event->door = 0;  // Legacy logs only ever came from the first (single) door
+  return true;
+}
+
 static void sendBuzzerSignal(BuzzerSignal signal) {
   // Send buzzer signal to main loop via queue (depth 1, overwrite semantics).
   // Network task cannot call buzzer directly — not thread-safe.
   if (buzzerSignalQueue != nullptr) {
     xQueueOverwrite(buzzerSignalQueue, &signal);
+    xTaskNotify(buzzerSignalTask, MAIN_NOTIFY_BUZZER_SIGNAL, eSetBits);
   }
 }
 
-static bool arrayContains(const JsonArray& arr, const JsonVariant& value) {
-  for (const auto& v : arr) {
-    if (v == value) {
-      return true;
-    }
+// =============================================================
+// Legacy Dongle Persistence (NVS migration, network task / setup only)
+// =============================================================
+
+static bool loadLegacyDongleJsonFromNvs(DongleTable* table) {
+  // One-time migration path: firmware before the "dongles" partition stored the raw read_pa JSON
+  Preferences prefs;
+  prefs.begin("dongleStore", true);  // ReadOnly = true
+  String json = prefs.getString(PERS_MEM_DONGLE_IDS);
+  prefs.end();
+  if (json.length() == 0) {
+    return false;
   }
-  return false;
+
+  DongleListParser parser;
+  parser.feed(json.c_str(), json.length());
+  return parser.finish(table);
+}
+
+static void removeLegacyDongleNvsKeys() {
+  Preferences prefs;
+  prefs.begin("dongleStore", false);
+  prefs.clear();  // Namespace only ever held the dongle list
+  prefs.end();
+  DBG(DebugFlags::FETCH_AND_STORE_DONGLE_IDS, "Legacy NVS dongle store removed");
 }
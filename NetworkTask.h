@@ -5,30 +5,36 @@
 
 // =============================================================
 // Public API
-// All internal state (mutex, dongle list, queues) is encapsulated
+// All internal state (dongle table, queues) is encapsulated
 // in NetworkTask.cpp — no extern globals exposed.
 // =============================================================
 
-// Start the network task on Core 0. Creates mutex, queues, and task internally.
-// Call once from setup() after WiFi.begin() and loadDonglesFromPersistentMemory().
+// Start the network task on Core 0. Creates queues and task internally; the
+// task connects WiFi, starts NTP and fetches the dongle list in the background.
+// Call once from setup() after the doors and loadDonglesFromPersistentMemory().
+// Buzzer signals wake the calling task with MAIN_NOTIFY_BUZZER_SIGNAL.
 void startNetworkTask();
 
 // Load dongle IDs from NVS into RAM (fast, no HTTP).
 // Must be called from setup() BEFORE startNetworkTask().
 void loadDonglesFromPersistentMemory();
 
-// Queue a log entry for async sending by the network task.
-// Non-blocking: returns false if queue is full (entry dropped, counter incremented).
-bool enqueueLogEntry(const LogEntryStruct& entry);
+// Timestamp a log event and queue it for async sending by the network task.
+// The event is written in place into the log event ring; call from Core 1 only
+// (single producer). Non-blocking: returns false if the ring is full (event
+// dropped, counter incremented) or the network task is not started yet.
+bool enqueueLogEvent(LogEventType type, uint32_t dongleId = 0, uint8_t door = 0);
 
 // Signal the network task to refresh dongle IDs from Google Sheets.
 // Uses xTaskNotify — safe from any core/context. Debounced (30s cooldown).
 void requestDongleRefresh();
 
-// Check if a dongle ID is authorized against the RAM dongle list.
-// Handles MasterCard (triggers async refresh, returns false) and
-// OPEN_FOR_ALL_DONGLES (grants access to all). Thread-safe (mutex protected).
-bool isDongleIdAuthorized(const String& dongleId);
+// Check if a 26-bit dongle ID (raw Wiegand value) may open door (index into DOORS)
+// now according to the RAM table (door mask and access schedule). Handles MasterCard (triggers async refresh, returns
+// false on every door) and OPEN_FOR_ALL_DONGLES (grants access to all).
+// O(log n), zero allocation.
+// Thread-safe and lock-free: never blocks on a concurrent dongle refresh.
+bool isDongleIdAuthorized(uint32_t dongleId, uint8_t door);
 
 // Check if the network task sent a buzzer signal. Non-blocking.
 // Returns true if a signal was received, with the signal stored in *outSignal.
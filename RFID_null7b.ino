@@ -13,232 +13,96 @@ durch die Steckerverbinder aendern sich die Kabelfarben am Board wie folgt:
   rot/schwarz = NO Kontakt (ist das Schloss offen, gibt es kein Durchgang)
 
 Architecture:
-  Core 1 (this file): RFID scanning via ISR, door monitoring, buzzer, unlock relay
-  Core 0 (NetworkTask): All HTTP operations, WiFi reconnect, dongle sync, log sending
-  Communication: FreeRTOS queues (logs, buzzer signals), mutex (dongle list), xTaskNotify (refresh)
+  Core 1 (this file, DoorChannel): per door RFID scanning via ISR, door monitoring, buzzer, unlock relay
+  Core 0 (NetworkTask): WiFi and NTP, all HTTP operations, dongle sync, log sending
+  Communication: SPSC ring (logs), FreeRTOS queue (buzzer signals), RCU-published dongle table, xTaskNotify (refresh)
+  Boot: the doors come up first; WiFi, NTP and the first dongle fetch follow in the network task
+  Core 1 is event-driven: loop() sleeps until an ISR, a timer or the network task sets a MAIN_NOTIFY_* bit
 */
 
 #include "Config.h"
 #include "DebugService.h"
 #include "NetworkTask.h"
-#include "Secrets.h"
-#include <WiFi.h>
-#include "ArduinoBuzzerSoundsRG.h"
-
-// =============================================================
-// ISR-shared variables (volatile, modified in ISR context)
-// =============================================================
-volatile int bitCount = 0;
-volatile unsigned long dongleValue = 0;
-volatile unsigned long lastBitTime = 0;
+#include "DongleTable.h"
+#include "DoorChannel.h"
 
 // =============================================================
 // Main loop state
 // =============================================================
-int doorStateMemory = 2;  // Initial = 2 (neither open nor closed), in use: 0 or 1
-
-BuzzerSoundsRgNonRtos* buzzerSounds;
+TaskHandle_t mainTaskHandle = nullptr;  // Loop task (setup() and loop()), woken by MAIN_NOTIFY_* bits
+DoorChannel doors[DOOR_COUNT];          // One per DOORS entry: reader, door contact, relay, buzzer
 
 // =============================================================
 // Forward Declarations
 // =============================================================
-void IRAM_ATTR ISRreceiveData0();
-void IRAM_ATTR ISRreceiveData1();
-void trackDoorStateChange();
-void handleRFIDScanResult();
 void checkPendingBuzzerSignals();
-void unlock();
 
 // =============================================================
 // Setup
 // =============================================================
 void setup() {
-  #ifdef DEBUG_MODE
+  // Serial is always on: it also carries the latency trace command (see NetworkTask)
   Serial.begin(115200);
-  // Countdown for serial monitor connection
-  for (int i = 5; i > 0; i--) {
-    DBG(DebugFlags::SETUP, i, " seconds", (i == 1 ? "." : "..."));
-    delay(1000);
-  }
+
+  #ifdef DEBUG_MODE
+  DebugService::getInstance()->begin();  // DBG() only queues; this task writes the messages to Serial
   DBG(DebugFlags::SETUP, "Start!");
   #endif
 
-  // Connect to WiFi (blocking, max 10 seconds — then continue without internet)
-  WiFi.begin(SSID, WIFI_PASSWORD);
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 10) {
-    DBG(DebugFlags::WIFI_LOGGING, "Connecting to WiFi ", SSID, " ... ", attempts, "s");
-    attempts++;
-    delay(1000);
-  }
+  // Nothing here waits for the network: after a power cut the doors work within
+  // milliseconds. WiFi, NTP and the first dongle fetch run in the network task.
 
-  if (WiFi.status() == WL_CONNECTED) {
-    DBG(DebugFlags::WIFI_LOGGING, "WiFi connected, IP: ", WiFi.localIP());
-  } else {
-    DBG(DebugFlags::WIFI_LOGGING, "WiFi not connected — will retry in background");
+  // Event sources of loop(): the ISRs and timers of every door notify this task
+  mainTaskHandle = xTaskGetCurrentTaskHandle();
+  for (uint8_t door = 0; door < DOOR_COUNT; door++) {
+    doors[door].begin(door, mainTaskHandle);
   }
 
-  // NTP time sync
-  configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, TIME_SERVER_1, TIME_SERVER_2, TIME_SERVER_3);
-
-  // Pin setup
-  pinMode(UNLOCKPIN, OUTPUT);
-  pinMode(DOOR_STATE_PIN, INPUT_PULLUP);
-
-  // Wiegand ISR setup
-  pinMode(INTERRUPT_IO_PIN_1, INPUT_PULLUP);
-  pinMode(INTERRUPT_IO_PIN_2, INPUT_PULLUP);
-  attachInterrupt(digitalPinToInterrupt(INTERRUPT_IO_PIN_1), ISRreceiveData0, FALLING);
-  attachInterrupt(digitalPinToInterrupt(INTERRUPT_IO_PIN_2), ISRreceiveData1, FALLING);
-
   // Load dongles from NVS for immediate RFID availability (no HTTP needed)
   loadDonglesFromPersistentMemory();
 
-  // Start network task on Core 0 (creates mutex + queues internally, then starts task)
+  // Start network task on Core 0 (creates queues internally, then starts task; it brings up WiFi and NTP)
   startNetworkTask();
 
-  // Buzzer
-  buzzerSounds = new BuzzerSoundsRgNonRtos(BUZZERPIN);
+  // Log the initial door states (later changes arrive via the door contact ISRs)
+  for (DoorChannel& door : doors) {
+    door.trackDoorStateChange();
+  }
 }
 
 // =============================================================
 // Main Loop (Core 1)
 // =============================================================
 void loop() {
-  trackDoorStateChange();
-  handleRFIDScanResult();
-  checkPendingBuzzerSignals();
-
-  // Reset partial RFID reads that timed out.
-  // Design: The Wiegand protocol transmits all 26 bits within ~52ms (2ms per bit).
-  // If interference or a partial read leaves bitCount between 1-25, no further scans
-  // can succeed because bitCount never reaches 26. A 200ms timeout is chosen to be
-  // well above the maximum valid transmission time while still recovering quickly.
-  noInterrupts();
-  int snapBitCount = bitCount;
-  unsigned long snapLastBitTime = lastBitTime;
-  interrupts();
-  if (snapBitCount > 0 && snapBitCount < 26 && millis() - snapLastBitTime > WIEGAND_TIMEOUT_MS) {
-    noInterrupts();
-    bitCount = 0;
-    dongleValue = 0;
-    interrupts();
-  }
-
-  // Yield to RTOS scheduler and reduce CPU load.
-  // RFID bits are captured by hardware interrupts (ISR) and are never missed by this delay.
-  // Door state changes occur in the seconds range; 10ms = 100 checks/s is more than sufficient.
-  delay(10);
-}
-
-// =============================================================
-// ISR Handlers
-// =============================================================
-
-// IRAM_ATTR: On ESP32, ISR code must reside in Internal RAM (IRAM), not in Flash.
-// During Flash operations (e.g., Preferences writes), Flash is temporarily unavailable.
-// Without IRAM_ATTR, an interrupt during a Flash operation would try to execute code
-// from unavailable Flash memory, causing a "Guru Meditation Error" (crash).
-
-void IRAM_ATTR ISRreceiveData0() {
-  // ISR for Data0 (bit '0') in the Wiegand protocol.
-  if (bitCount < 26) {
-    dongleValue <<= 1;
-    bitCount++;
-    lastBitTime = millis();  // millis() is ISR-safe on ESP32 (reads hardware timer)
-  }
-}
-
-void IRAM_ATTR ISRreceiveData1() {
-  // ISR for Data1 (bit '1') in the Wiegand protocol.
-  if (bitCount < 26) {
-    dongleValue <<= 1;
-    dongleValue |= 1;
-    bitCount++;
-    lastBitTime = millis();
-  }
-}
-
-// =============================================================
-// Door State Monitoring
-// =============================================================
-
-void trackDoorStateChange() {
-  // Read pin once to avoid inconsistency between comparison and assignment
-  int currentDoorState = digitalRead(DOOR_STATE_PIN);
-
-  if (doorStateMemory != currentDoorState) {
-    doorStateMemory = currentDoorState;
-
-    LogEntryStruct logEntry;
-    getCurrentDateTime(logEntry.date, logEntry.time);
-
-    if (doorStateMemory == DOOR_IS_CLOSED) {
-      DBG(DebugFlags::DOOR_STATE, "Door closed — logging");
-      safeCopyStringToChar("door_is_closed", logEntry.access, CharArrayAccessSize);
-      safeCopyStringToChar("doorstate", logEntry.dongle_id, CharArrayDongleIdSize);
-      enqueueLogEntry(logEntry);
-    } else if (doorStateMemory == DOOR_IS_OPEN) {
-      DBG(DebugFlags::DOOR_STATE, "Door opened — logging");
-      safeCopyStringToChar("door_is_open", logEntry.access, CharArrayAccessSize);
-      safeCopyStringToChar("doorstate", logEntry.dongle_id, CharArrayDongleIdSize);
-      enqueueLogEntry(logEntry);
-    } else {
-      // Shouldn't happen — pin reads only 0 or 1
+  // Sleep until something happens: no polling, no periodic wake-ups.
+  // A completed Wiegand frame is handled within microseconds of its last bit.
+  uint32_t notifications = 0;
+  xTaskNotifyWait(0, UINT32_MAX, &notifications, portMAX_DELAY);
+
+  // The bits are shared by all doors: every door checks whether the event is its own.
+  // Actuator steps first: a pattern started below must not see this pass's expiry
+  for (DoorChannel& door : doors) {
+    if (notifications & MAIN_NOTIFY_RELAY_TIMER) {
+      door.onRelayTimer();
+    }
+    if (notifications & MAIN_NOTIFY_BUZZER_TIMER) {
+      door.onBuzzerTimer();
     }
   }
-}
-
-// =============================================================
-// RFID Scan Processing
-// =============================================================
-
-void handleRFIDScanResult() {
-  // Snapshot ISR variables with interrupts disabled
-  noInterrupts();
-  unsigned long readDongleValue = dongleValue;
-  int countedBits = bitCount;
-  interrupts();
-
-  if (countedBits != 26) {
-    return;
-  }
-
-  // Convert 26-bit value to binary string
-  String dongleIdStr;
-  dongleIdStr.reserve(27);
-  for (int i = 25; i >= 0; i--) {
-    dongleIdStr += ((readDongleValue >> i) & 1) ? '1' : '0';
+  for (DoorChannel& door : doors) {
+    if (notifications & MAIN_NOTIFY_WIEGAND_FRAME) {
+      door.handleWiegandFrames();
+    }
+    if (notifications & MAIN_NOTIFY_WIEGAND_TIMEOUT) {
+      door.resetStalledWiegandFrame();
+    }
+    if (notifications & MAIN_NOTIFY_DOOR_SETTLED) {
+      door.trackDoorStateChange();
+    }
   }
-
-  DBG(DebugFlags::DONGLE_SCAN, "Scanned dongle: ", dongleIdStr);
-
-  LogEntryStruct logEntry;
-  getCurrentDateTime(logEntry.date, logEntry.time);
-
-  if (isDongleIdAuthorized(dongleIdStr)) {
-    DBG(DebugFlags::DONGLE_SCAN, "Access granted");
-    buzzerSounds->playSound(BuzzerSoundsRgBase::SoundType::AuthOk);
-    unlock();
-    safeCopyStringToChar("authorised", logEntry.access, CharArrayAccessSize);
-    safeCopyStringToChar(dongleIdStr, logEntry.dongle_id, CharArrayDongleIdSize);
-    enqueueLogEntry(logEntry);
-  } else {
-    DBG(DebugFlags::DONGLE_SCAN, "Access denied");
-    buzzerSounds->playSound(BuzzerSoundsRgBase::SoundType::NoAuth);
-    safeCopyStringToChar("denied", logEntry.access, CharArrayAccessSize);
-    safeCopyStringToChar(dongleIdStr, logEntry.dongle_id, CharArrayDongleIdSize);
-    enqueueLogEntry(logEntry);
+  if (notifications & MAIN_NOTIFY_BUZZER_SIGNAL) {
+    checkPendingBuzzerSignals();
   }
-
-  // Clear ISR state for next scan.
-  // Note: if a new scan begins between our snapshot (above) and this reset,
-  // the new scan's bits are discarded. This is acceptable because human
-  // badge scans are seconds apart — the narrow race window (~ms) is benign.
-  noInterrupts();
-  bitCount = 0;
-  dongleValue = 0;
-  interrupts();
 }
 
 // =============================================================
@@ -246,28 +110,21 @@ void handleRFIDScanResult() {
 // =============================================================
 
 void checkPendingBuzzerSignals() {
-  // Check if the network task sent a buzzer signal (non-blocking)
+  // Check if the network task sent a buzzer signal (non-blocking).
+  // Controller-wide news (list updated, network trouble): heard at every door.
   BuzzerSignal signal;
   if (receiveBuzzerSignal(&signal)) {
-    switch (signal) {
-      case BUZZER_OK:
-        buzzerSounds->playSound(BuzzerSoundsRgBase::SoundType::OK);
-        break;
-      case BUZZER_SOS:
-        buzzerSounds->playSound(BuzzerSoundsRgBase::SoundType::SOS);
-        break;
-      default:
-        break;
+    for (DoorChannel& door : doors) {
+      switch (signal) {
+        case BUZZER_OK:
+          door.play(BuzzerSound::OK);
+          break;
+        case BUZZER_SOS:
+          door.play(BuzzerSound::SOS);
+          break;
+        default:
+          break;
+      }
     }
   }
 }
-
-// =============================================================
-// Unlock
-// =============================================================
-
-void unlock() {
-  digitalWrite(UNLOCKPIN, HIGH);
-  delay(SWITCHDURATION_MS);
-  digitalWrite(UNLOCKPIN, LOW);
-}
@@ -0,0 +1,106 @@
+#include "ScriptClient.h"
+#include "DebugService.h"
+#include "Secrets.h"
+
+ScriptClient::ScriptClient() {
+  // Same trust as HTTPClient::begin(url) before: no certificate pinning.
+  // Use setCACert() here to verify the Google certificate chain.
+  _scriptTls.setInsecure();
+  _contentTls.setInsecure();
+  _response = &_scriptHttp;
+}
+
+int ScriptClient::send(const char* query, const uint8_t* body, size_t length, const char* contentType) {
+  char url[256];
+  snprintf(url, sizeof(url), "%s?%s", WEB_APP_URL, query);
+
+  bool reused = _scriptTls.connected();
+  int httpCode = sendOnce(url, body, length, contentType);
+
+  // A kept-alive connection the server closed while idle fails on first use.
+  // Retry once on a fresh one — for a POST only if the request never went out
+  // (and not if only the result fetch failed), so a batch cannot be written twice.
+  bool notSent = httpCode == HTTPC_ERROR_CONNECTION_REFUSED || httpCode == HTTPC_ERROR_SEND_HEADER_FAILED ||
+                 httpCode == HTTPC_ERROR_SEND_PAYLOAD_FAILED || httpCode == HTTPC_ERROR_NOT_CONNECTED;
+  if (httpCode < 0 && reused && (body == nullptr || (notSent && !_scriptRan))) {
+    DBG(DebugFlags::NETWORK_TASK, "Kept-alive connection lost (", httpCode, ") — reconnecting");
+    disconnect();
+    httpCode = sendOnce(url, body, length, contentType);
+  }
+  if (httpCode < 0) {
+    disconnect();
+  }
+  return httpCode;
+}
+
+int ScriptClient::sendOnce(const char* url, const uint8_t* body, size_t length, const char* contentType) {
+  _scriptHttp.begin(_scriptTls, url);
+  _scriptHttp.setReuse(true);
+  _scriptHttp.setTimeout(_timeoutMs);
+  _scriptHttp.setFollowRedirects(HTTPC_DISABLE_FOLLOW_REDIRECTS);
+  _response = &_scriptHttp;
+  _scriptRan = false;
+
+  int httpCode;
+  if (body != nullptr) {
+    _scriptHttp.addHeader("Content-Type", contentType);
+    httpCode = _scriptHttp.POST(const_cast<uint8_t*>(body), length);
+  } else {
+    httpCode = _scriptHttp.GET();
+  }
+
+  if (httpCode == 301 || httpCode == 302 || httpCode == 303 || httpCode == 307 || httpCode == 308) {
+    String location = _scriptHttp.getLocation();
+    _scriptHttp.end();  // Drains the small redirect body, keeps the connection
+    _scriptRan = strstr(location.c_str(), "user_content_key=") != nullptr;  // Not a sign-in redirect
+    return followRedirect(location.c_str());
+  }
+  return httpCode;
+}
+
+int ScriptClient::followRedirect(const char* location) {
+  // Apps Script always sends the result to the same content host. Should it ever
+  // change, the old connection must not be used for the new host.
+  const char* hostStart = strstr(location, "://");
+  hostStart = hostStart != nullptr ? hostStart + 3 : location;
+  size_t hostLength = strcspn(hostStart, ":/?");
+  if (hostLength >= sizeof(_contentHost) ||
+      strncmp(_contentHost, hostStart, hostLength) != 0 || _contentHost[hostLength] != '\0') {
+    _contentHttp.end();
+    _contentTls.stop();
+    hostLength = hostLength < sizeof(_contentHost) ? hostLength : sizeof(_contentHost) - 1;
+    memcpy(_contentHost, hostStart, hostLength);
+    _contentHost[hostLength] = '\0';
+  }
+
+  // The script has already run; the result is fetched with GET (also after a POST).
+  // GET is idempotent, so a stale content connection gets one fresh attempt.
+  int httpCode = HTTPC_ERROR_NOT_CONNECTED;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = _contentTls.connected();
+    _contentHttp.begin(_contentTls, location);
+    _contentHttp.setReuse(true);
+    _contentHttp.setTimeout(_timeoutMs);
+    _contentHttp.setFollowRedirects(HTTPC_DISABLE_FOLLOW_REDIRECTS);
+    httpCode = _contentHttp.GET();
+    if (httpCode >= 0 || !reused) {
+      break;
+    }
+    _contentHttp.end();
+    _contentTls.stop();
+  }
+  _response = &_contentHttp;
+  return httpCode;
+}
+
+void ScriptClient::end() {
+  _response->end();
+}
+
+void ScriptClient::disconnect() {
+  _scriptHttp.end();
+  _contentHttp.end();
+  _scriptTls.stop();
+  _contentTls.stop();
+  _contentHost[0] = '\0';
+}
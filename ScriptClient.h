@@ -0,0 +1,66 @@
+#ifndef SCRIPT_CLIENT_H
+#define SCRIPT_CLIENT_H
+
+#include "Config.h"
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+// =============================================================
+// ScriptClient
+// Long-lived HTTPS access to the googleScript web app, owned by the
+// network task. Apps Script answers every request with a redirect to
+// script.googleusercontent.com, so two keep-alive connections are kept:
+// one per host. The redirect is followed by hand so each connection
+// stays on its host and the TLS handshake is paid once per connection,
+// not per request. Connections are dropped only after an error (or
+// when the server closes them) and re-established on the next request.
+//
+// WiFiClientSecure does not expose TLS session resumption, so keeping
+// the connection open is what avoids the handshake.
+// =============================================================
+class ScriptClient {
+  private:
+    WiFiClientSecure _scriptTls;   // script.google.com
+    WiFiClientSecure _contentTls;  // Redirect target (script.googleusercontent.com)
+    HTTPClient _scriptHttp;
+    HTTPClient _contentHttp;
+    HTTPClient* _response = nullptr;
+    char _contentHost[64] = "";
+    uint16_t _timeoutMs = SCRIPT_HTTP_TIMEOUT_MS;
+    bool _scriptRan = false;
+
+    int send(const char* query, const uint8_t* body, size_t length, const char* contentType);
+    int sendOnce(const char* url, const uint8_t* body, size_t length, const char* contentType);
+    int followRedirect(const char* location);
+
+  public:
+    ScriptClient();
+    ScriptClient(const ScriptClient&) = delete;
+    ScriptClient& operator=(const ScriptClient&) = delete;
+
+    // Request WEB_APP_URL?<query>, following the redirect to the result.
+    // Returns the final HTTP status or a negative HTTPC_ERROR_* code.
+    // Every call must be paired with end() or disconnect().
+    int get(const char* query) { return send(query, nullptr, 0, nullptr); }
+    int post(const char* query, const uint8_t* body, size_t length, const char* contentType) {
+      return send(query, body, length, contentType);
+    }
+
+    // The script host answered the last request with the redirect to its result:
+    // the script has run, even if fetching the result then failed. A POST must
+    // not be sent again then, or its rows are written twice.
+    bool scriptRan() const { return _scriptRan; }
+
+    // Response timeout of the following requests (each hop)
+    void setTimeout(uint16_t timeoutMs) { _timeoutMs = timeoutMs; }
+
+    // The client holding the response of the last request (body via writeToStream/getString).
+    HTTPClient& response() { return *_response; }
+
+    // Response fully read: keep the connections for the next request.
+    void end();
+    // Response abandoned or network changed: close both connections.
+    void disconnect();
+};
+
+#endif // SCRIPT_CLIENT_H
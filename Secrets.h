@@ -14,6 +14,5 @@ constexpr char WIFI_PASSWORD[] = "YOUR WIFI PW";
 
 // Google Apps Script Web-App URL
 constexpr char WEB_APP_URL[] =      "https://script.google.com/macros/s/67890123456789012345678901234567890123456789012345678901234567890123456789/exec";
-constexpr char WEB_APP_URL_READ[] = "https://script.google.com/macros/s/67890123456789012345678901234567890123456789012345678901234567890123456789/exec?action=read_pa";
                                                                       
 #endif // SECRETS_H
@@ -0,0 +1,89 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Largest data cache line of the targets (ESP32-S3 PSRAM cache, x86 host)
+constexpr uint32_t SPSC_CACHE_LINE = 64;
+
+// =============================================================
+// SpscRing
+// Lock-free ring for exactly one producer and one consumer, e.g. an
+// ISR handing data to a task. Head and tail are free-running counters
+// written by one side each, on cache lines of their own so producer and
+// consumer on different cores do not invalidate each other's line.
+// A full ring rejects the new item instead of overwriting unread ones.
+// Size must be a power of two.
+//
+// Items can be copied (push/pop) or used in place: the producer fills
+// the slot reserve() returns and publishes it with commit(); the consumer
+// reads a contiguous run through peek() and frees it with release().
+// =============================================================
+template<typename T, uint32_t Size>
+class SpscRing {
+  static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "SpscRing size must be a power of two");
+
+  private:
+    alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> _head{0};  // Next slot to write (producer only)
+    alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> _tail{0};  // Next slot to read (consumer only)
+    alignas(SPSC_CACHE_LINE) T _items[Size];
+
+  public:
+    // Producer side. Always inlined so an IRAM_ATTR ISR never calls into flash.
+    // reserve() returns the next free slot (nullptr if the ring is full); it
+    // belongs to the producer until commit() hands it to the consumer.
+    inline __attribute__((always_inline)) T* reserve() {
+      uint32_t head = _head.load(std::memory_order_relaxed);
+      if (head - _tail.load(std::memory_order_acquire) == Size) {
+        return nullptr;
+      }
+      return &_items[head & (Size - 1)];
+    }
+
+    inline __attribute__((always_inline)) void commit() {
+      _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    inline __attribute__((always_inline)) bool push(const T& item) {
+      T* slot = reserve();
+      if (slot == nullptr) {
+        return false;
+      }
+      *slot = item;
+      commit();
+      return true;
+    }
+
+    // Consumer side.
+    bool pop(T* item) {
+      uint32_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _head.load(std::memory_order_acquire)) {
+        return false;
+      }
+      *item = _items[tail & (Size - 1)];
+      _tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Committed items from the oldest on, up to the end of the buffer: *items
+    // points at the first, the return value is the count (0 if empty). They
+    // stay valid until release(); a wrapped ring takes a second peek().
+    uint32_t peek(const T** items) const {
+      uint32_t tail = _tail.load(std::memory_order_relaxed);
+      uint32_t available = _head.load(std::memory_order_acquire) - tail;
+      uint32_t toEnd = Size - (tail & (Size - 1));
+      *items = &_items[tail & (Size - 1)];
+      return available < toEnd ? available : toEnd;
+    }
+
+    // Free the first count items of the last peek() for the producer.
+    void release(uint32_t count) {
+      _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    uint32_t size() const { return _head.load() - _tail.load(); }
+    static constexpr uint32_t capacity() { return Size; }
+};
+
+#endif // SPSC_RING_H
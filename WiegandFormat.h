@@ -0,0 +1,78 @@
+#ifndef WIEGAND_FORMAT_H
+#define WIEGAND_FORMAT_H
+
+#include <stdint.h>
+#include <type_traits>
+
+// =============================================================
+// Wiegand Frame Formats
+// A frame is shifted in MSB first: the first transmitted bit (bit 1
+// in the format specs) ends up as the highest bit. Every format has a
+// leading even parity bit over the first half and a trailing odd parity
+// bit over the second half; the masks below cover the parity bit and
+// the bits it protects and are computed at compile time, so checking a
+// frame costs two ANDs and two popcounts.
+// =============================================================
+
+// Mask of bit positions first..last (1-based, in transmission order) of a frame
+constexpr uint64_t wiegandSpanMask(int bits, int first, int last) {
+  return first > last ? 0 : (1ULL << (bits - first)) | wiegandSpanMask(bits, first + 1, last);
+}
+
+constexpr int wiegandPopcount(uint32_t value) { return __builtin_popcount(value); }
+constexpr int wiegandPopcount(uint64_t value) { return __builtin_popcountll(value); }
+
+// Bits: frame length. Leading even parity covers bits 1..EvenLast,
+// trailing odd parity covers bits OddFirst..Bits.
+template<uint8_t Bits, uint8_t EvenLast, uint8_t OddFirst>
+struct WiegandFormat {
+  static_assert(Bits >= 4 && Bits <= 64, "Wiegand frame length out of range");
+  static_assert(EvenLast < Bits && OddFirst > 1 && OddFirst <= EvenLast + 1, "parity spans must cover the frame");
+
+  // Smallest register that holds a frame: 26-bit readers stay on 32-bit arithmetic
+  typedef typename std::conditional<(Bits <= 32), uint32_t, uint64_t>::type Frame;
+
+  static constexpr uint8_t BITS = Bits;
+  static constexpr Frame EVEN_MASK = (Frame)wiegandSpanMask(Bits, 1, EvenLast);
+  static constexpr Frame ODD_MASK = (Frame)wiegandSpanMask(Bits, OddFirst, Bits);
+  static constexpr Frame DATA_MASK = (Frame)wiegandSpanMask(Bits, 2, Bits - 1);
+
+  static constexpr bool hasValidParity(Frame frame) {
+    return (wiegandPopcount(frame & EVEN_MASK) & 1) == 0 && (wiegandPopcount(frame & ODD_MASK) & 1) == 1;
+  }
+
+  // Payload between the parity bits (card number, facility code, ...)
+  static constexpr Frame data(Frame frame) { return (frame & DATA_MASK) >> 1; }
+
+  // Frame for a payload, with both parity bits set (tests, Secrets.h constants)
+  static constexpr Frame encode(Frame payload) { return withParity((Frame)((payload << 1) & DATA_MASK)); }
+
+  private:
+    static constexpr Frame withParity(Frame body) {
+      return body | ((wiegandPopcount(body & EVEN_MASK) & 1) ? (Frame)1 << (Bits - 1) : 0)
+                  | ((wiegandPopcount(body & ODD_MASK) & 1) ? 0 : 1);
+    }
+};
+
+typedef WiegandFormat<26, 13, 14> Wiegand26;  // HID H10301: 8-bit facility + 16-bit card
+typedef WiegandFormat<34, 17, 18> Wiegand34;  // HID H10306: 16-bit facility + 16-bit card
+typedef WiegandFormat<37, 19, 19> Wiegand37;  // HID H10304: parity spans share bit 19
+
+static_assert(Wiegand26::EVEN_MASK == 0x3FFE000 && Wiegand26::ODD_MASK == 0x1FFF, "H10301 parity masks");
+static_assert(Wiegand34::EVEN_MASK == 0x3FFFE0000ULL && Wiegand34::ODD_MASK == 0x1FFFF, "H10306 parity masks");
+static_assert(Wiegand37::EVEN_MASK == 0x1FFFFC0000ULL && Wiegand37::ODD_MASK == 0x7FFFF, "H10304 parity masks");
+static_assert(Wiegand26::hasValidParity(Wiegand26::encode(0x0253B1)), "encode() sets valid parity");
+static_assert(!Wiegand26::hasValidParity(Wiegand26::encode(0x0253B1) ^ 0x10), "single bit error is detected");
+
+// The reader wired to the door. Dongle tables and log records hold
+// DONGLE_ID_BITS-bit IDs (the raw frame), so a longer format also
+// needs those widened.
+typedef Wiegand26 DoorReaderFormat;
+
+// A completed frame as handed from the ISR to loop()
+struct WiegandFrame {
+  DoorReaderFormat::Frame bits;
+  uint32_t endCycles;  // CPU cycle count at the last bit (LatencyTrace)
+};
+
+#endif // WIEGAND_FORMAT_H
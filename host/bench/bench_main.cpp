@@ -0,0 +1,190 @@
+// =============================================================
+// Host microbenchmarks for the firmware hot paths.
+// Usage: rfid_bench [substring-filter]
+// Numbers are host numbers: use them to compare changes, not to
+// predict absolute ESP32-S3 timings.
+// =============================================================
+
+#include "NetworkTask.cpp"  // Unity include: reaches file-static helpers
+#include "DoorChannel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Sketch globals (RFID_null7b.ino)
+extern DoorChannel doors[DOOR_COUNT];
+
+static volatile uint32_t benchSink = 0;  // Defeats dead-code elimination
+static const char* benchFilter = nullptr;
+
+// Median ns/op over several timed rounds of at least ~20 ms each.
+template<typename Fn>
+static double measureNsPerOp(Fn fn) {
+  typedef std::chrono::steady_clock Clock;
+  uint64_t iterations = 1;
+  for (;;) {
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) fn();
+    double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (elapsedMs >= 20.0 || iterations >= (1ull << 30)) break;
+    iterations *= 2;
+  }
+  std::vector<double> rounds;
+  for (int r = 0; r < 5; r++) {
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) fn();
+    rounds.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations);
+  }
+  std::sort(rounds.begin(), rounds.end());
+  return rounds[rounds.size() / 2];
+}
+
+template<typename Fn>
+static void bench(const std::string& name, Fn fn) {
+  if (benchFilter != nullptr && name.find(benchFilter) == std::string::npos) return;
+  printf("%-32s %12.1f ns/op\n", name.c_str(), measureNsPerOp(fn));
+  fflush(stdout);
+}
+
+// Deterministic 26-bit IDs
+static std::vector<uint32_t> makeDongleIds(size_t count, uint32_t seed) {
+  std::vector<uint32_t> ids;
+  uint32_t state = seed;
+  for (size_t i = 0; i < count; i++) {
+    state = state * 1664525u + 1013904223u;
+    ids.push_back(state & ((1u << DONGLE_ID_BITS) - 1));
+  }
+  return ids;
+}
+
+// Dongle list as googleScript returns it: one single-element array per sheet row
+static std::string makeDongleJson(const std::vector<uint32_t>& ids) {
+  std::string json = "[";
+  char idStr[CharArrayDongleIdSize];
+  for (size_t i = 0; i < ids.size(); i++) {
+    formatDongleId(ids[i], idStr);
+    json += (i > 0 ? ",[\"" : "[\"");
+    json += idStr;
+    json += "\"]";
+  }
+  return json + "]";
+}
+
+static void publishIds(const std::vector<uint32_t>& ids) {
+  uint32_t* copy = new uint32_t[ids.size() > 0 ? ids.size() : 1];
+  std::copy(ids.begin(), ids.end(), copy);
+  DongleTable table;
+  table.adopt(copy, ids.size(), false);
+  ramDongleTable.publish(table);
+}
+
+static void benchAuthorization() {
+  const size_t sizes[] = { 10, 1000, 10000 };
+  for (size_t n : sizes) {
+    std::vector<uint32_t> ids = makeDongleIds(n, 1);
+    std::vector<uint32_t> misses = makeDongleIds(256, 2);
+    publishIds(ids);
+    size_t i = 0;
+    bench("isDongleIdAuthorized/hit/" + std::to_string(n), [&]() {
+      benchSink += isDongleIdAuthorized(ids[i++ % ids.size()], 0);
+    });
+    bench("isDongleIdAuthorized/miss/" + std::to_string(n), [&]() {
+      benchSink += isDongleIdAuthorized(misses[i++ & 255], 0);
+    });
+  }
+}
+
+static void benchDongleListLoad() {
+  const size_t sizes[] = { 10, 1000, 10000 };
+  for (size_t n : sizes) {
+    // read_pa body fed in TCP-segment sized chunks, as writeToStream() delivers it
+    std::string json = makeDongleJson(makeDongleIds(n, 3));
+    bench("dongleListLoad/stream/" + std::to_string(n), [&]() {
+      DongleListParser parser;
+      for (size_t pos = 0; pos < json.size(); pos += 1460) {
+        parser.feed(json.data() + pos, std::min<size_t>(1460, json.size() - pos));
+      }
+      DongleTable table;
+      parser.finish(&table);
+      benchSink += table.size();
+    });
+
+    // Boot path: table mapped from the flash partition, no copy, no parsing
+    DongleTable table;
+    DongleListParser parser;
+    parser.feed(json.data(), json.size());
+    parser.finish(&table);
+    HostFlash::reset();
+    dongleStore.begin();
+    dongleStore.save(table, 1);
+    bench("dongleListLoad/flash/" + std::to_string(n), [&]() {
+      loadDonglesFromPersistentMemory();
+    });
+
+    // read_pa_delta with a handful of changes merged into the current table
+    std::vector<uint32_t> changed = makeDongleIds(8, 11);
+    DongleTableBuilder addedBuilder, removedBuilder;
+    for (size_t i = 0; i < changed.size(); i++) {
+      (i % 2 == 0 ? addedBuilder : removedBuilder).add(changed[i]);
+    }
+    removedBuilder.add(table.ids()[n / 2]);
+    DongleTable added, removed;
+    addedBuilder.build(&added);
+    removedBuilder.build(&removed);
+    bench("dongleListLoad/delta/" + std::to_string(n), [&]() {
+      DongleTable merged;
+      merged.assignDelta(table, added, removed);
+      benchSink += merged.hash();
+    });
+  }
+}
+
+static void benchLogHelpers() {
+  LogEvent batch[LOG_BATCH_MAX_ENTRIES];
+  for (int i = 0; i < LOG_BATCH_MAX_ENTRIES; i++) {
+    batch[i].epoch = 1709753664 + i;  // 06.03.2024 20:34:24 CET
+    batch[i].dongleId = 0x0253B1 + i;
+    batch[i].type = i % 2 == 0 ? LOG_EVENT_AUTHORISED : LOG_EVENT_DOOR_CLOSED;
+  }
+  bench("buildLogBatchBody/fullBatch", [&]() {
+    char body[LOG_BATCH_MAX_BYTES];
+    benchSink += buildLogBatchBody(batch, LOG_BATCH_MAX_ENTRIES, body, sizeof(body));
+  });
+
+  bench("makeLogEvent", [&]() {
+    LogEvent event = makeLogEvent(LOG_EVENT_DENIED, 0x0253B1);
+    benchSink += event.epoch;
+  });
+}
+
+static void benchWiegandScan() {
+  // Full Core 1 path for a denied scan: 26 edges on the reader pins of door 1 +
+  // handleWiegandFrames() (parity, decision, timestamp, log entry; network task
+  // absent so nothing is queued)
+  DoorChannel& door = doors[0];
+  door.begin(0, nullptr);
+  publishIds(makeDongleIds(1000, 4));
+  uint32_t frameBits = DoorReaderFormat::encode(makeDongleIds(1, 5)[0] >> 1);
+  bench("wiegandFrame+handleRFIDScanResult", [&]() {
+    for (int bit = DoorReaderFormat::BITS - 1; bit >= 0; bit--) {
+      uint8_t pin = ((frameBits >> bit) & 1) ? DOORS[0].data1Pin : DOORS[0].data0Pin;
+      HostGpio::setLevel(pin, LOW);
+      HostGpio::setLevel(pin, HIGH);
+    }
+    door.handleWiegandFrames();
+  });
+  bench("WiegandFormat::hasValidParity", [&]() {
+    benchSink += DoorReaderFormat::hasValidParity(frameBits ^ (benchSink & 1));
+  });
+}
+
+int main(int argc, char** argv) {
+  benchFilter = argc > 1 ? argv[1] : nullptr;
+  benchAuthorization();
+  benchDongleListLoad();
+  benchLogHelpers();
+  benchWiegandScan();
+  return benchSink == 0xFFFFFFFF ? 1 : 0;
+}
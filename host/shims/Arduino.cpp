@@ -0,0 +1,160 @@
+#include "Arduino.h"
+#include "esp_cpu.h"
+#include "esp_memory_utils.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+HostSerial Serial;
+HostEsp ESP;
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - bootTime).count();
+}
+
+int64_t esp_timer_get_time() {
+  return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - bootTime).count();
+}
+
+// Linker symbols: read-only data lies between the end of the code and the start of .data
+extern "C" char etext, __data_start;
+
+bool esp_ptr_in_drom(const void* p) {
+  return p >= (const void*)&etext && p < (const void*)&__data_start;
+}
+
+uint32_t esp_random() {
+  static std::mutex mutex;
+  static uint32_t state = 2463534242u;
+  std::lock_guard<std::mutex> lock(mutex);
+  state ^= state << 13;  // xorshift32
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count() {
+  uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - bootTime).count();
+  return (esp_cpu_cycle_count_t)(ns * getCpuFrequencyMhz() / 1000);
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// =============================================================
+// GPIO and interrupts
+// "Interrupts disabled" is modelled as holding one global lock;
+// emulated ISRs run while holding it as well.
+// =============================================================
+struct HostPin {
+  uint8_t level = HIGH;
+  int mode = 0;
+  void (*isr)() = nullptr;
+  void (*isrArg)(void*) = nullptr;
+  void* arg = nullptr;
+};
+
+static HostPin pins[HostGpio::PIN_COUNT];
+static std::recursive_mutex interruptLock;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin < HostGpio::PIN_COUNT) pins[pin].level = level;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < HostGpio::PIN_COUNT ? pins[pin].level : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  std::lock_guard<std::recursive_mutex> lock(interruptLock);
+  pins[pin].isr = isr;
+  pins[pin].isrArg = nullptr;
+  pins[pin].mode = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+  std::lock_guard<std::recursive_mutex> lock(interruptLock);
+  pins[pin].isr = nullptr;
+  pins[pin].isrArg = isr;
+  pins[pin].arg = arg;
+  pins[pin].mode = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> lock(interruptLock);
+  pins[pin].isr = nullptr;
+  pins[pin].isrArg = nullptr;
+}
+
+void noInterrupts() {
+  interruptLock.lock();
+}
+
+void interrupts() {
+  interruptLock.unlock();
+}
+
+namespace HostGpio {
+
+void setLevel(uint8_t pin, uint8_t level) {
+  std::lock_guard<std::recursive_mutex> lock(interruptLock);
+  HostPin& p = pins[pin];
+  uint8_t previous = p.level;
+  p.level = level;
+  bool fire = (p.mode == CHANGE && previous != level) ||
+              (p.mode == FALLING && previous == HIGH && level == LOW) ||
+              (p.mode == RISING && previous == LOW && level == HIGH);
+  if (fire && p.isr != nullptr) p.isr();
+  if (fire && p.isrArg != nullptr) p.isrArg(p.arg);
+}
+
+uint8_t level(uint8_t pin) {
+  return pins[pin].level;
+}
+
+void reset() {
+  std::lock_guard<std::recursive_mutex> lock(interruptLock);
+  for (HostPin& p : pins) p = HostPin();
+}
+
+} // namespace HostGpio
+
+// =============================================================
+// Time (host clock stands in for NTP)
+// =============================================================
+bool getLocalTime(struct tm* info, uint32_t ms) {
+  (void)ms;
+  time_t now = time(nullptr);
+  return localtime_r(&now, info) != nullptr;
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2, const char* server3) {
+  (void)gmtOffsetSec;
+  (void)daylightOffsetSec;
+  (void)server1;
+  (void)server2;
+  (void)server3;
+}
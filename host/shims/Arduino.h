@@ -0,0 +1,183 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// =============================================================
+// Host shim for the subset of the Arduino-ESP32 core used by the
+// firmware. Only compiled by the CMake host build (see CMakeLists.txt),
+// never by the Arduino IDE.
+// =============================================================
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <string>
+
+#define IRAM_ATTR
+
+constexpr uint8_t LOW = 0;
+constexpr uint8_t HIGH = 1;
+constexpr uint8_t INPUT = 0x01;
+constexpr uint8_t OUTPUT = 0x03;
+constexpr uint8_t INPUT_PULLUP = 0x05;
+constexpr int RISING = 0x01;
+constexpr int FALLING = 0x02;
+constexpr int CHANGE = 0x03;
+
+// =============================================================
+// String (backed by std::string)
+// =============================================================
+class String {
+  private:
+    std::string _str;
+
+  public:
+    String() = default;
+    String(const char* str) : _str(str != nullptr ? str : "") {}
+    String(const std::string& str) : _str(str) {}
+    explicit String(int value) : _str(std::to_string(value)) {}
+
+    size_t length() const { return _str.length(); }
+    const char* c_str() const { return _str.c_str(); }
+    bool reserve(size_t size) { _str.reserve(size); return true; }
+    bool equals(const String& other) const { return _str == other._str; }
+    bool equals(const char* other) const { return _str == (other != nullptr ? other : ""); }
+    void toCharArray(char* buf, size_t bufsize) const {
+      if (buf == nullptr || bufsize == 0) return;
+      size_t n = _str.copy(buf, bufsize - 1);
+      buf[n] = '\0';
+    }
+    String& operator+=(char c) { _str += c; return *this; }
+    String& operator+=(const char* str) { _str += str; return *this; }
+    String& operator+=(const String& str) { _str += str._str; return *this; }
+    bool operator==(const String& other) const { return _str == other._str; }
+    bool operator==(const char* other) const { return equals(other); }
+    bool operator!=(const String& other) const { return _str != other._str; }
+};
+
+// =============================================================
+// IPAddress (IPv4 only, first octet in the low byte as on the ESP32)
+// =============================================================
+class IPAddress {
+  private:
+    uint32_t _address = 0;
+
+  public:
+    IPAddress() = default;
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : _address(a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+    operator uint32_t() const { return _address; }
+    String toString() const {
+      char text[16];
+      snprintf(text, sizeof(text), "%u.%u.%u.%u", _address & 0xFF, (_address >> 8) & 0xFF,
+               (_address >> 16) & 0xFF, _address >> 24);
+      return String(text);
+    }
+};
+
+// =============================================================
+// Print / Stream (byte sink and source, as in the Arduino core)
+// =============================================================
+class Print {
+  public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while (n < size && write(buffer[n]) == 1) n++;
+      return n;
+    }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(char* buffer, size_t length) {
+      size_t count = 0;
+      while (count < length) {
+        int c = read();
+        if (c < 0) break;
+        buffer[count++] = (char)c;
+      }
+      return count;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    void setTimeout(unsigned long timeoutMs) { (void)timeoutMs; }
+};
+
+// =============================================================
+// Timing
+// =============================================================
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline uint32_t getCpuFrequencyMhz() { return 240; }
+
+// =============================================================
+// GPIO and interrupts
+// Pin levels live in RAM; HostGpio::setLevel() drives an input and
+// fires an attached interrupt on the matching edge.
+// =============================================================
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+void noInterrupts();
+void interrupts();
+
+namespace HostGpio {
+  constexpr int PIN_COUNT = 64;
+  void setLevel(uint8_t pin, uint8_t level);
+  uint8_t level(uint8_t pin);
+  void reset();
+}
+
+// =============================================================
+// Misc core helpers
+// =============================================================
+inline bool isAlphaNumeric(int c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+class HostSerial : public Print {
+  public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    void print(const char* v) { fputs(v, stdout); }
+    void print(const String& v) { fputs(v.c_str(), stdout); }
+    void print(char v) { fputc(v, stdout); }
+    void print(int v) { printf("%d", v); }
+    void print(unsigned int v) { printf("%u", v); }
+    void print(long v) { printf("%ld", v); }
+    void print(unsigned long v) { printf("%lu", v); }
+    void print(double v) { printf("%.2f", v); }
+    void println() { fputc('\n', stdout); }
+    template<typename T> void println(T v) { print(v); println(); }
+    int available() { return 0; }
+    int read() { return -1; }
+    void onReceive(std::function<void()> callback) { receiveCallback = callback; }
+
+    std::function<void()> receiveCallback;  // Set by onReceive(); never called (no input on the host)
+};
+extern HostSerial Serial;
+
+class HostEsp {
+  public:
+    uint32_t getFreeHeap() { return 256 * 1024; }
+    uint32_t getMinFreeHeap() { return 256 * 1024; }
+};
+extern HostEsp ESP;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,152 @@
+#include "esp_partition.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <string.h>
+#include <vector>
+
+struct HostPartition {
+  esp_partition_t info;
+  std::vector<uint8_t> bytes;
+};
+
+static std::map<std::string, HostPartition> partitions;
+static std::recursive_mutex flashMutex;
+static size_t erasedSectors = 0;
+static long writeBudget = -1;
+static bool defaultsAdded = false;
+
+static void addDefaultPartitions() {
+  // Mirrors partitions.csv of the sketch
+  if (!defaultsAdded) {
+    defaultsAdded = true;
+    HostFlash::addPartition("dongles", 0x40, 0x20000);
+    HostFlash::addPartition("logring", 0x41, 0x40000);
+  }
+}
+
+static HostPartition* lookup(const esp_partition_t* partition) {
+  if (partition == nullptr) {
+    return nullptr;
+  }
+  auto it = partitions.find(partition->label);
+  return it != partitions.end() && &it->second.info == partition ? &it->second : nullptr;
+}
+
+namespace HostFlash {
+
+void addPartition(const char* label, esp_partition_subtype_t subtype, uint32_t size) {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  HostPartition& p = partitions[label];
+  memset(&p.info, 0, sizeof(p.info));
+  p.info.type = ESP_PARTITION_TYPE_DATA;
+  p.info.subtype = subtype;
+  p.info.address = 0x610000 + 0x100000 * (uint32_t)(partitions.size() - 1);
+  p.info.size = size;
+  p.info.erase_size = SPI_FLASH_SEC_SIZE;
+  strncpy(p.info.label, label, sizeof(p.info.label) - 1);
+  p.bytes.assign(size, 0xFF);
+}
+
+void reset() {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  addDefaultPartitions();
+  for (auto& entry : partitions) {
+    entry.second.bytes.assign(entry.second.info.size, 0xFF);
+  }
+  erasedSectors = 0;
+  writeBudget = -1;
+}
+
+uint8_t* data(const char* label) {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  addDefaultPartitions();
+  auto it = partitions.find(label);
+  return it != partitions.end() ? it->second.bytes.data() : nullptr;
+}
+
+size_t eraseCount() {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  return erasedSectors;
+}
+
+void failWritesAfter(long bytes) {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  writeBudget = bytes;
+}
+
+} // namespace HostFlash
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  addDefaultPartitions();
+  for (auto& entry : partitions) {
+    const esp_partition_t& info = entry.second.info;
+    if (info.type == type && (subtype == ESP_PARTITION_SUBTYPE_ANY || info.subtype == subtype) &&
+        (label == nullptr || strcmp(info.label, label) == 0)) {
+      return &info;
+    }
+  }
+  return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size) {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  HostPartition* p = lookup(partition);
+  if (p == nullptr || srcOffset + size > p->bytes.size()) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memcpy(dst, p->bytes.data() + srcOffset, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size) {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  HostPartition* p = lookup(partition);
+  if (p == nullptr || dstOffset + size > p->bytes.size()) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(src);
+  for (size_t i = 0; i < size; i++) {
+    if (writeBudget == 0) {
+      return ESP_FAIL;  // "Power lost" mid-write
+    }
+    if (writeBudget > 0) {
+      writeBudget--;
+    }
+    p->bytes[dstOffset + i] &= bytes[i];  // NOR flash: program clears bits only
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  HostPartition* p = lookup(partition);
+  if (p == nullptr || offset + size > p->bytes.size()) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memset(p->bytes.data() + offset, 0xFF, size);
+  erasedSectors += size / SPI_FLASH_SEC_SIZE;
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** outPtr,
+                             esp_partition_mmap_handle_t* outHandle) {
+  (void)memory;
+  std::lock_guard<std::recursive_mutex> lock(flashMutex);
+  HostPartition* p = lookup(partition);
+  if (p == nullptr || offset + size > p->bytes.size()) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *outPtr = p->bytes.data() + offset;
+  *outHandle = 1;
+  return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+  (void)handle;
+}
@@ -0,0 +1,398 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Wait on cv until pred() holds or ticks (ms) elapse. portMAX_DELAY waits forever.
+template<typename Pred>
+static bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Pred pred) {
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+}
+
+// =============================================================
+// Tasks and direct-to-task notifications
+// =============================================================
+struct HostTask {
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint32_t value = 0;
+  bool pending = false;
+};
+
+static thread_local HostTask* currentTask = nullptr;
+static thread_local BaseType_t currentCore = 1;
+static std::recursive_mutex coreInterruptLocks[portNUM_PROCESSORS];
+
+BaseType_t xPortGetCoreID() {
+  return currentCore;
+}
+
+UBaseType_t hostSetInterruptMask() {
+  coreInterruptLocks[currentCore].lock();
+  return (UBaseType_t)currentCore;
+}
+
+void hostClearInterruptMask(UBaseType_t state) {
+  coreInterruptLocks[state].unlock();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (currentTask == nullptr) {
+    currentTask = new HostTask();  // Lazily adopt foreign threads (e.g. main), never freed
+  }
+  return currentTask;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t priority, TaskHandle_t* outHandle,
+                                   BaseType_t coreId) {
+  (void)name;
+  (void)stackDepth;
+  (void)priority;
+  HostTask* task = new HostTask();
+  if (outHandle != nullptr) {
+    *outHandle = task;
+  }
+  std::thread([fn, param, task, coreId]() {
+    currentTask = task;
+    currentCore = coreId >= 0 && coreId < portNUM_PROCESSORS ? coreId : 0;
+    fn(param);
+  }).detach();
+  return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount() {
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  (void)task;
+  return 0;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+  if (task == nullptr) {
+    return pdFAIL;
+  }
+  std::lock_guard<std::mutex> lock(task->mutex);
+  switch (action) {
+    case eSetBits: task->value |= value; break;
+    case eIncrement: task->value++; break;
+    case eSetValueWithOverwrite: task->value = value; break;
+    case eSetValueWithoutOverwrite:
+      if (task->pending) return pdFAIL;
+      task->value = value;
+      break;
+    case eNoAction: break;
+  }
+  task->pending = true;
+  task->cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              BaseType_t* higherPriorityTaskWoken) {
+  if (higherPriorityTaskWoken != nullptr) {
+    *higherPriorityTaskWoken = pdFALSE;
+  }
+  return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* outValue,
+                           TickType_t ticks) {
+  HostTask* task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  if (!task->pending) {
+    task->value &= ~clearOnEntry;
+  }
+  if (!waitFor(task->cv, lock, ticks, [task]() { return task->pending; })) {
+    return pdFALSE;
+  }
+  if (outValue != nullptr) {
+    *outValue = task->value;
+  }
+  task->value &= ~clearOnExit;
+  task->pending = false;
+  return pdTRUE;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+  xTaskNotifyFromISR(task, 0, eIncrement, higherPriorityTaskWoken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  HostTask* task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  if (!waitFor(task->cv, lock, ticks, [task]() { return task->value != 0; })) {
+    return 0;
+  }
+  uint32_t value = task->value;
+  task->value = clearOnExit ? 0 : value - 1;
+  task->pending = task->value != 0;
+  return value;
+}
+
+// =============================================================
+// Queues
+// =============================================================
+struct HostQueue {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  HostQueue* queue = new HostQueue();
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!waitFor(queue->cv, lock, ticks, [queue]() { return queue->items.size() < queue->length; })) {
+    return pdFALSE;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(item);
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  queue->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken) {
+  if (higherPriorityTaskWoken != nullptr) {
+    *higherPriorityTaskWoken = pdFALSE;
+  }
+  return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  const uint8_t* bytes = static_cast<const uint8_t*>(item);
+  queue->items.clear();
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  queue->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!waitFor(queue->cv, lock, ticks, [queue]() { return !queue->items.empty(); })) {
+    return pdFALSE;
+  }
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  queue->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!waitFor(queue->cv, lock, ticks, [queue]() { return !queue->items.empty(); })) {
+    return pdFALSE;
+  }
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return (UBaseType_t)queue->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return queue->length - (UBaseType_t)queue->items.size();
+}
+
+// =============================================================
+// Semaphores (mutex and binary share one implementation)
+// =============================================================
+struct HostSemaphore {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool available;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  HostSemaphore* sem = new HostSemaphore();
+  sem->available = true;
+  return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  HostSemaphore* sem = new HostSemaphore();
+  sem->available = false;
+  return sem;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+  delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(sem->mutex);
+  if (!waitFor(sem->cv, lock, ticks, [sem]() { return sem->available; })) {
+    return pdFALSE;
+  }
+  sem->available = false;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  std::lock_guard<std::mutex> lock(sem->mutex);
+  sem->available = true;
+  sem->cv.notify_one();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* higherPriorityTaskWoken) {
+  if (higherPriorityTaskWoken != nullptr) {
+    *higherPriorityTaskWoken = pdFALSE;
+  }
+  return xSemaphoreGive(sem);
+}
+
+// =============================================================
+// Software timers (one service thread, 1 tick = 1 ms)
+// =============================================================
+struct HostTimer {
+  TickType_t period;
+  bool autoReload;
+  void* id;
+  TimerCallbackFunction_t callback;
+  bool active = false;
+  std::chrono::steady_clock::time_point expiry;
+};
+
+// Never destroyed: the detached service thread may still run during exit
+static std::mutex& timerMutex = *new std::mutex();
+static std::condition_variable& timerCv = *new std::condition_variable();
+static std::vector<HostTimer*>& timers = *new std::vector<HostTimer*>();
+
+static void timerServiceLoop() {
+  std::unique_lock<std::mutex> lock(timerMutex);
+  for (;;) {
+    HostTimer* next = nullptr;
+    for (HostTimer* timer : timers) {
+      if (timer->active && (next == nullptr || timer->expiry < next->expiry)) {
+        next = timer;
+      }
+    }
+    if (next == nullptr) {
+      timerCv.wait(lock);
+      continue;
+    }
+    if (std::chrono::steady_clock::now() < next->expiry) {
+      timerCv.wait_until(lock, next->expiry);
+      continue;  // Timers may have changed meanwhile
+    }
+    if (next->autoReload) {
+      next->expiry += std::chrono::milliseconds(next->period);
+    } else {
+      next->active = false;
+    }
+    lock.unlock();
+    next->callback(next);  // Without the lock: callbacks may restart timers
+    lock.lock();
+  }
+}
+
+static BaseType_t startTimer(TimerHandle_t timer) {
+  if (timer == nullptr) {
+    return pdFAIL;
+  }
+  std::lock_guard<std::mutex> lock(timerMutex);
+  timer->active = true;
+  timer->expiry = std::chrono::steady_clock::now() + std::chrono::milliseconds(timer->period);
+  timerCv.notify_all();
+  return pdPASS;
+}
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload, void* id,
+                           TimerCallbackFunction_t callback) {
+  (void)name;
+  static std::once_flag serviceStarted;
+  std::call_once(serviceStarted, []() { std::thread(timerServiceLoop).detach(); });
+  HostTimer* timer = new HostTimer();
+  timer->period = period;
+  timer->autoReload = autoReload != 0;
+  timer->id = id;
+  timer->callback = callback;
+  std::lock_guard<std::mutex> lock(timerMutex);
+  timers.push_back(timer);
+  return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait) {
+  (void)ticksToWait;
+  return startTimer(timer);
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait) {
+  (void)ticksToWait;
+  if (timer == nullptr) {
+    return pdFAIL;
+  }
+  std::lock_guard<std::mutex> lock(timerMutex);
+  timer->active = false;
+  timerCv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticksToWait) {
+  (void)ticksToWait;
+  return startTimer(timer);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticksToWait) {
+  (void)ticksToWait;
+  if (timer == nullptr) {
+    return pdFAIL;
+  }
+  {
+    std::lock_guard<std::mutex> lock(timerMutex);
+    timer->period = period;
+  }
+  return startTimer(timer);  // As in FreeRTOS: changing the period starts the timer
+}
+
+BaseType_t xTimerResetFromISR(TimerHandle_t timer, BaseType_t* higherPriorityTaskWoken) {
+  if (higherPriorityTaskWoken != nullptr) {
+    *higherPriorityTaskWoken = pdFALSE;
+  }
+  return startTimer(timer);
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) {
+  std::lock_guard<std::mutex> lock(timerMutex);
+  return timer != nullptr && timer->active ? pdTRUE : pdFALSE;
+}
+
+void* pvTimerGetTimerID(TimerHandle_t timer) {
+  return timer != nullptr ? timer->id : nullptr;
+}
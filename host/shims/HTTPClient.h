@@ -0,0 +1,98 @@
+#ifndef HOST_HTTPCLIENT_H
+#define HOST_HTTPCLIENT_H
+
+// =============================================================
+// Host shim for HTTPClient. Requests are answered in-process by the
+// handler installed with HostHttp::setHandler(); without a handler
+// every request fails with HTTPC_ERROR_CONNECTION_REFUSED.
+// Connections are modelled for begin(client, url) with setReuse(true):
+// a request reuses the client's open connection to the same host,
+// anything else counts as a new (TLS) handshake.
+// =============================================================
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include <functional>
+#include <string>
+
+constexpr int HTTPC_ERROR_CONNECTION_REFUSED = -1;
+constexpr int HTTPC_ERROR_SEND_HEADER_FAILED = -2;
+constexpr int HTTPC_ERROR_SEND_PAYLOAD_FAILED = -3;
+constexpr int HTTPC_ERROR_NOT_CONNECTED = -4;
+constexpr int HTTPC_ERROR_CONNECTION_LOST = -5;
+constexpr int HTTPC_ERROR_NO_STREAM = -6;
+constexpr int HTTPC_ERROR_STREAM_WRITE = -10;
+constexpr int HTTPC_ERROR_READ_TIMEOUT = -11;
+
+enum followRedirects_t {
+  HTTPC_DISABLE_FOLLOW_REDIRECTS,
+  HTTPC_STRICT_FOLLOW_REDIRECTS,
+  HTTPC_FORCE_FOLLOW_REDIRECTS,
+};
+
+namespace HostHttp {
+  struct Request {
+    std::string method;
+    std::string url;
+    std::string body;
+    uint32_t timeoutMs;
+  };
+  struct Response {
+    int code;
+    std::string body;
+    std::string location;  // Location header (redirects)
+  };
+  typedef std::function<Response(const Request&)> Handler;
+
+  void setHandler(Handler handler);
+  void setChunkSize(size_t bytes);  // Split response bodies into reads of at most this size
+  Response dispatch(const Request& request);
+  size_t chunkSize();
+
+  size_t handshakeCount();  // New connections opened since the last reset
+  void resetHandshakeCount();
+  void dropConnections();   // Server closes all idle connections: the next request on each fails once
+  uint32_t connectionEpoch();
+}
+
+class HTTPClient {
+  private:
+    std::string _url;
+    std::string _body;
+    uint32_t _timeoutMs = 5000;
+    bool _hasResponse = false;
+    bool _reuse = true;
+    WiFiClient _stream;
+    WiFiClient* _transport = nullptr;  // Caller-owned connection (begin(client, url)), else one per request
+    std::string _location;
+
+    int send(const char* method, const std::string& payload);
+
+  public:
+    bool begin(const char* url) { _url = url; _hasResponse = false; _transport = nullptr; return true; }
+    bool begin(const String& url) { return begin(url.c_str()); }
+    bool begin(WiFiClient& client, const char* url) { begin(url); _transport = &client; return true; }
+    bool begin(WiFiClient& client, const String& url) { return begin(client, url.c_str()); }
+    void end();
+    void setTimeout(uint16_t timeoutMs) { _timeoutMs = timeoutMs; }
+    void setConnectTimeout(int32_t timeoutMs) { (void)timeoutMs; }
+    void setFollowRedirects(followRedirects_t follow) { (void)follow; }
+    void setReuse(bool reuse) { _reuse = reuse; }
+    String getLocation() { return String(_location); }
+    void addHeader(const String& name, const String& value) { (void)name; (void)value; }
+
+    int GET() { return send("GET", std::string()); }
+    int POST(const String& payload) { return send("POST", payload.c_str()); }
+    int POST(const uint8_t* payload, size_t size) { return send("POST", std::string((const char*)payload, size)); }
+
+    // Body is delivered in HostHttp::chunkSize() pieces (default 1460, one TCP segment)
+    int writeToStream(Stream* stream);
+    WiFiClient* getStreamPtr() { return _hasResponse ? &_stream : nullptr; }
+    WiFiClient& getStream() { return _stream; }
+    int getSize() { return _hasResponse ? (int)_body.size() : -1; }
+    String getString() { return String(_body); }
+
+    static String errorToString(int error);
+};
+
+#endif // HOST_HTTPCLIENT_H
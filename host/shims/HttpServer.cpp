@@ -0,0 +1,82 @@
+#include "esp_http_server.h"
+#include <cstring>
+#include <vector>
+
+static bool running = false;
+static uint16_t serverPort = 0;
+static std::vector<httpd_uri_t> handlers;
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config) {
+  if (handle == nullptr || config == nullptr) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (running) {
+    return ESP_ERR_INVALID_STATE;  // One server per host process is enough here
+  }
+  running = true;
+  serverPort = config->server_port;
+  *handle = &running;
+  return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+  (void)handle;
+  HostHttpd::reset();
+  return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri) {
+  if (handle == nullptr || uri == nullptr || !running) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  handlers.push_back(*uri);
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t* req, const char* type) {
+  if (req->hostContentType != nullptr) {
+    *req->hostContentType = type;
+  }
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t* req, const char* buf, ssize_t length) {
+  req->hostBody->clear();
+  return httpd_resp_send_chunk(req, buf, length);
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* req, const char* buf, ssize_t length) {
+  if (buf == nullptr) {
+    return ESP_OK;  // Last chunk
+  }
+  req->hostBody->append(buf, length == HTTPD_RESP_USE_STRLEN ? strlen(buf) : (size_t)length);
+  return ESP_OK;
+}
+
+namespace HostHttpd {
+
+bool get(const char* uri, std::string* body, std::string* contentType) {
+  if (!running) {
+    return false;
+  }
+  for (const httpd_uri_t& handler : handlers) {
+    if (handler.method == HTTP_GET && strcmp(handler.uri, uri) == 0) {
+      httpd_req_t req = { HTTP_GET, uri, handler.user_ctx, body, contentType };
+      body->clear();
+      return handler.handler(&req) == ESP_OK;
+    }
+  }
+  return false;
+}
+
+uint16_t port() {
+  return running ? serverPort : 0;
+}
+
+void reset() {
+  running = false;
+  serverPort = 0;
+  handlers.clear();
+}
+
+} // namespace HostHttpd
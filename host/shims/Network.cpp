@@ -0,0 +1,126 @@
+#include "HTTPClient.h"
+#include "WiFi.h"
+
+HostWiFiClass WiFi;
+
+static HostHttp::Handler httpHandler;
+static size_t httpChunkSize = 0;  // 0 = one read for the whole body
+static size_t handshakes = 0;
+static uint32_t epoch = 1;
+
+namespace HostHttp {
+
+void setHandler(Handler handler) {
+  httpHandler = handler;
+}
+
+void setChunkSize(size_t bytes) {
+  httpChunkSize = bytes;
+}
+
+size_t chunkSize() {
+  return httpChunkSize;
+}
+
+size_t handshakeCount() {
+  return handshakes;
+}
+
+void resetHandshakeCount() {
+  handshakes = 0;
+}
+
+void dropConnections() {
+  epoch++;
+}
+
+uint32_t connectionEpoch() {
+  return epoch;
+}
+
+Response dispatch(const Request& request) {
+  if (!httpHandler || WiFi.status() != WL_CONNECTED) {
+    Response refused = { HTTPC_ERROR_CONNECTION_REFUSED, std::string() };
+    return refused;
+  }
+  return httpHandler(request);
+}
+
+} // namespace HostHttp
+
+static std::string urlHost(const std::string& url) {
+  size_t start = url.find("://");
+  start = start == std::string::npos ? 0 : start + 3;
+  size_t end = url.find_first_of(":/?", start);
+  return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+int HTTPClient::send(const char* method, const std::string& payload) {
+  _hasResponse = false;
+  _location.clear();
+  std::string host = urlHost(_url);
+  if (_transport != nullptr && _transport->connected()) {
+    if (_transport->connectionEpoch() != HostHttp::connectionEpoch()) {
+      _transport->stop();  // Closed by the server while idle: the write fails
+      return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+    if (_transport->connectedHost() != host) {
+      _transport->stop();
+    }
+  }
+  if (_transport == nullptr || !_transport->connected()) {
+    if (WiFi.status() == WL_CONNECTED) {
+      handshakes++;
+    }
+    if (_transport != nullptr) {
+      _transport->markConnected(host, HostHttp::connectionEpoch());
+    }
+  }
+
+  HostHttp::Request request = { method, _url, payload, _timeoutMs };
+  HostHttp::Response response = HostHttp::dispatch(request);
+  if (response.code <= 0 && _transport != nullptr) {
+    _transport->stop();
+  }
+  _hasResponse = response.code > 0;
+  _body = response.body;
+  _location = response.location;
+  _stream.load(_body, HostHttp::chunkSize());
+  return response.code;
+}
+
+void HTTPClient::end() {
+  _hasResponse = false;
+  _stream.stop();
+  if (_transport != nullptr && !_reuse) {
+    _transport->stop();
+  }
+}
+
+int HTTPClient::writeToStream(Stream* stream) {
+  if (stream == nullptr) return HTTPC_ERROR_NO_STREAM;
+  if (!_hasResponse) return HTTPC_ERROR_NOT_CONNECTED;
+  size_t chunk = HostHttp::chunkSize() > 0 ? HostHttp::chunkSize() : 1460;
+  size_t written = 0;
+  while (written < _body.size()) {
+    size_t n = _body.size() - written < chunk ? _body.size() - written : chunk;
+    if (stream->write(reinterpret_cast<const uint8_t*>(_body.data()) + written, n) != n) {
+      return HTTPC_ERROR_STREAM_WRITE;
+    }
+    written += n;
+  }
+  return (int)written;
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_REFUSED: return String("connection refused");
+    case HTTPC_ERROR_SEND_HEADER_FAILED: return String("send header failed");
+    case HTTPC_ERROR_NOT_CONNECTED: return String("not connected");
+    case HTTPC_ERROR_CONNECTION_LOST: return String("connection lost");
+    case HTTPC_ERROR_NO_STREAM: return String("no stream");
+    case HTTPC_ERROR_STREAM_WRITE: return String("Stream write error");
+    case HTTPC_ERROR_READ_TIMEOUT: return String("read Timeout");
+    default: return String();
+  }
+}
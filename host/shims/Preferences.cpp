@@ -0,0 +1,122 @@
+#include "Preferences.h"
+#include <map>
+#include <mutex>
+#include <vector>
+
+static const size_t NVS_MAX_STRING_SIZE = 4000;  // Including null terminator
+
+typedef std::map<std::string, std::vector<uint8_t>> HostNamespace;
+static std::map<std::string, HostNamespace> store;
+static std::mutex storeMutex;
+static size_t writes = 0;
+
+namespace HostPreferences {
+
+void reset() {
+  std::lock_guard<std::mutex> lock(storeMutex);
+  store.clear();
+  writes = 0;
+}
+
+size_t writeCount() {
+  std::lock_guard<std::mutex> lock(storeMutex);
+  return writes;
+}
+
+} // namespace HostPreferences
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+  (void)partitionLabel;
+  _namespace = name;
+  _readOnly = readOnly;
+  _open = true;
+  return true;
+}
+
+void Preferences::end() {
+  _open = false;
+}
+
+bool Preferences::clear() {
+  if (!_open || _readOnly) return false;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  store[_namespace].clear();
+  writes++;
+  return true;
+}
+
+bool Preferences::remove(const char* key) {
+  if (!_open || _readOnly) return false;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  writes++;
+  return store[_namespace].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+  std::lock_guard<std::mutex> lock(storeMutex);
+  return _open && store[_namespace].count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (!_open || _readOnly || key == nullptr) return 0;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  const uint8_t* bytes = static_cast<const uint8_t*>(value);
+  store[_namespace][key].assign(bytes, bytes + len);
+  writes++;
+  return len;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!_open) return 0;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  HostNamespace& ns = store[_namespace];
+  HostNamespace::const_iterator it = ns.find(key);
+  return it == ns.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  if (!_open) return 0;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  HostNamespace& ns = store[_namespace];
+  HostNamespace::const_iterator it = ns.find(key);
+  if (it == ns.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+  size_t len = strlen(value) + 1;
+  if (len > NVS_MAX_STRING_SIZE) return 0;
+  return putBytes(key, value, len) > 0 ? len - 1 : 0;
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLen) {
+  // Like nvs_get_str(): returns length including the terminator, 0 if missing or too long
+  return getBytes(key, value, maxLen);
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+  size_t len = getBytesLength(key);
+  if (len == 0) return defaultValue;
+  std::vector<char> buf(len);
+  getBytes(key, buf.data(), len);
+  return String(buf.data());
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+  return putBytes(key, &value, sizeof(value));
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+  int32_t value = defaultValue;
+  return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+  return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+  uint32_t value = defaultValue;
+  return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
@@ -0,0 +1,46 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+// =============================================================
+// Host shim for Preferences (NVS). All namespaces live in one
+// process-wide in-memory store; HostPreferences::reset() wipes it.
+// Mirrors NVS limits that matter to the firmware: strings up to
+// 4000 bytes, getString() fails if the buffer is too small.
+// =============================================================
+
+#include "Arduino.h"
+
+class Preferences {
+  private:
+    std::string _namespace;
+    bool _open = false;
+    bool _readOnly = true;
+
+  public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+    size_t getString(const char* key, char* value, size_t maxLen);
+    String getString(const char* key, const String& defaultValue = String());
+
+    size_t putInt(const char* key, int32_t value);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    size_t putUInt(const char* key, uint32_t value);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+    size_t getBytesLength(const char* key);
+};
+
+namespace HostPreferences {
+  void reset();
+  size_t writeCount();  // Number of successful put*/remove operations (flash wear proxy)
+}
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,118 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+// =============================================================
+// Host shim for WiFi / WiFiClient. The link state is controlled by
+// HostWiFi::setLinkUp(); WiFiClient serves an in-memory body.
+// Event handlers run synchronously on the thread that changed the link
+// (on the device: the WiFi event task).
+// =============================================================
+
+#include "Arduino.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+enum wl_status_t {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6,
+};
+
+// The subset of the Arduino-ESP32 events the shim raises
+enum arduino_event_id_t {
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+  ARDUINO_EVENT_MAX = 46,
+};
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+
+class WiFiClient : public Stream {
+  private:
+    std::string _data;
+    size_t _pos = 0;
+    size_t _chunk = 0;  // Max bytes per readBytes() call (0 = unlimited), mimics TCP segments
+    std::string _host;      // Host of the open connection (empty = closed)
+    uint32_t _epoch = 0;    // HostHttp connection epoch at connect time
+
+  public:
+    // Connection state used by the HTTPClient shim (see HostHttp::dropConnections)
+    const std::string& connectedHost() const { return _host; }
+    uint32_t connectionEpoch() const { return _epoch; }
+    void markConnected(const std::string& host, uint32_t epoch) { _host = host; _epoch = epoch; }
+
+    void load(const std::string& data, size_t chunk = 0) {
+      _data = data;
+      _pos = 0;
+      _chunk = chunk;
+    }
+    int available() override { return (int)(_data.size() - _pos); }
+    int read() override { return _pos < _data.size() ? (uint8_t)_data[_pos++] : -1; }
+    int peek() override { return _pos < _data.size() ? (uint8_t)_data[_pos] : -1; }
+    size_t readBytes(char* buffer, size_t length) override {
+      size_t n = _data.size() - _pos;
+      if (n > length) n = length;
+      if (_chunk > 0 && n > _chunk) n = _chunk;
+      memcpy(buffer, _data.data() + _pos, n);
+      _pos += n;
+      return n;
+    }
+    size_t write(uint8_t c) override { (void)c; return 1; }
+    bool connected() { return !_host.empty(); }
+    void stop() { _data.clear(); _pos = 0; _host.clear(); }
+};
+
+class HostWiFiClass {
+  private:
+    bool _linkUp = true;
+    bool _started = false;
+    std::vector<std::pair<WiFiEventCb, arduino_event_id_t>> _handlers;
+
+    // Raise GOT_IP / DISCONNECTED if the change to the link state altered status()
+    void setState(bool started, bool linkUp) {
+      bool wasConnected = status() == WL_CONNECTED;
+      _started = started;
+      _linkUp = linkUp;
+      bool connected = status() == WL_CONNECTED;
+      if (connected == wasConnected) {
+        return;
+      }
+      arduino_event_id_t event = connected ? ARDUINO_EVENT_WIFI_STA_GOT_IP : ARDUINO_EVENT_WIFI_STA_DISCONNECTED;
+      for (const auto& handler : _handlers) {
+        if (handler.second == event || handler.second == ARDUINO_EVENT_MAX) {
+          handler.first(event);
+        }
+      }
+    }
+
+  public:
+    wl_status_t begin(const char* ssid, const char* password) {
+      (void)ssid;
+      (void)password;
+      setState(true, _linkUp);
+      return status();
+    }
+    bool disconnect() { setState(false, _linkUp); return true; }
+    wl_status_t status() const { return (_started && _linkUp) ? WL_CONNECTED : WL_DISCONNECTED; }
+    IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+    bool setAutoReconnect(bool) { return true; }
+    bool mode(int) { return true; }
+    // event ARDUINO_EVENT_MAX: every event
+    int onEvent(WiFiEventCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX) {
+      _handlers.push_back({ callback, event });
+      return (int)_handlers.size();
+    }
+
+    void setLinkUp(bool up) { setState(_started, up); }
+};
+extern HostWiFiClass WiFi;
+
+namespace HostWiFi {
+  // Simulate the access point going away / coming back
+  inline void setLinkUp(bool up) { WiFi.setLinkUp(up); }
+}
+
+#endif // HOST_WIFI_H
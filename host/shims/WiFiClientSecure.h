@@ -0,0 +1,18 @@
+#ifndef HOST_WIFICLIENTSECURE_H
+#define HOST_WIFICLIENTSECURE_H
+
+// =============================================================
+// Host shim for WiFiClientSecure: a WiFiClient whose connects count
+// as TLS handshakes (HostHttp::handshakeCount()).
+// =============================================================
+
+#include "WiFi.h"
+
+class WiFiClientSecure : public WiFiClient {
+  public:
+    void setInsecure() {}
+    void setCACert(const char* rootCA) { (void)rootCA; }
+    void setHandshakeTimeout(unsigned long seconds) { (void)seconds; }
+};
+
+#endif // HOST_WIFICLIENTSECURE_H
@@ -0,0 +1,16 @@
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+// =============================================================
+// Host shim for the ESP-IDF CPU cycle counter (IDF 5 esp_cpu.h).
+// Counts at getCpuFrequencyMhz() cycles per microsecond of the
+// host's steady clock, wrapping at 32 bits like CCOUNT.
+// =============================================================
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count();
+
+#endif // HOST_ESP_CPU_H
@@ -0,0 +1,64 @@
+#ifndef HOST_ESP_HTTP_SERVER_H
+#define HOST_ESP_HTTP_SERVER_H
+
+// =============================================================
+// Host shim for the ESP-IDF HTTP server (esp_http_server.h), GET only.
+// No sockets: HostHttpd::get() runs the registered handler of a URI
+// in the calling thread and collects the response.
+// =============================================================
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+
+typedef void* httpd_handle_t;
+
+enum http_method {
+  HTTP_GET = 1,
+};
+
+struct httpd_req_t {
+  int method;
+  const char* uri;
+  void* user_ctx;
+  std::string* hostBody;         // Shim only: collected response
+  std::string* hostContentType;  // Shim only
+};
+
+struct httpd_uri_t {
+  const char* uri;
+  http_method method;
+  esp_err_t (*handler)(httpd_req_t* req);
+  void* user_ctx;
+};
+
+struct httpd_config_t {
+  unsigned task_priority;
+  size_t stack_size;
+  int core_id;
+  uint16_t server_port;
+  uint16_t ctrl_port;
+  uint16_t max_open_sockets;
+  uint16_t max_uri_handlers;
+};
+
+#define HTTPD_DEFAULT_CONFIG() httpd_config_t{ 5, 4096, 0x7FFFFFFF, 80, 32768, 7, 8 }
+#define HTTPD_RESP_USE_STRLEN -1
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config);
+esp_err_t httpd_stop(httpd_handle_t handle);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri);
+esp_err_t httpd_resp_set_type(httpd_req_t* req, const char* type);
+esp_err_t httpd_resp_send(httpd_req_t* req, const char* buf, ssize_t length);
+esp_err_t httpd_resp_send_chunk(httpd_req_t* req, const char* buf, ssize_t length);
+
+namespace HostHttpd {
+  // GET uri on the running server. Returns false if no server or handler matches.
+  bool get(const char* uri, std::string* body, std::string* contentType = nullptr);
+  uint16_t port();  // Port of the running server (0 = none)
+  void reset();     // Stop the server and forget all handlers
+}
+
+#endif // HOST_ESP_HTTP_SERVER_H
@@ -0,0 +1,12 @@
+#ifndef HOST_ESP_MEMORY_UTILS_H
+#define HOST_ESP_MEMORY_UTILS_H
+
+// =============================================================
+// Host shim for the ESP-IDF address classification helpers (IDF 5
+// esp_memory_utils.h). "DROM" is the executable's read-only data:
+// string literals and const tables, never stack or heap.
+// =============================================================
+
+bool esp_ptr_in_drom(const void* p);
+
+#endif // HOST_ESP_MEMORY_UTILS_H
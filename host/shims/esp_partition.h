@@ -0,0 +1,62 @@
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+// =============================================================
+// Host shim for the ESP-IDF partition API (IDF 5 signatures).
+// Partitions are erased RAM buffers registered by label; writes
+// behave like NOR flash (can only clear bits), erases must be
+// sector aligned, mmap returns the buffer itself.
+// =============================================================
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum {
+  ESP_PARTITION_TYPE_APP = 0x00,
+  ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+#define ESP_PARTITION_SUBTYPE_ANY 0xff
+
+typedef enum {
+  ESP_PARTITION_MMAP_DATA,
+  ESP_PARTITION_MMAP_INST,
+} esp_partition_mmap_memory_t;
+
+typedef uint32_t esp_partition_mmap_handle_t;
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef struct {
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  uint32_t erase_size;
+  char label[17];
+  bool encrypted;
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** outPtr,
+                             esp_partition_mmap_handle_t* outHandle);
+void esp_partition_munmap(esp_partition_mmap_handle_t handle);
+
+namespace HostFlash {
+  // Register (or re-create, erased) a data partition. The firmware's partitions.csv
+  // entries are registered on first use of esp_partition_find_first().
+  void addPartition(const char* label, esp_partition_subtype_t subtype, uint32_t size);
+  void reset();                        // Erase all partitions, zero the counters
+  uint8_t* data(const char* label);    // Raw contents for tests (corruption, inspection)
+  size_t eraseCount();                 // Sectors erased since reset (wear proxy)
+  void failWritesAfter(long bytes);    // Simulate power loss: later writes are dropped (-1 = off)
+}
+
+#endif // HOST_ESP_PARTITION_H
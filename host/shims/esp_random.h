@@ -0,0 +1,13 @@
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+
+// =============================================================
+// Host shim for esp_random() (IDF 5 esp_random.h): a fixed-seed
+// pseudo-random sequence, so host runs are repeatable.
+// =============================================================
+
+#include <stdint.h>
+
+uint32_t esp_random();
+
+#endif // HOST_ESP_RANDOM_H
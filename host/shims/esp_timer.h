@@ -0,0 +1,13 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+// =============================================================
+// Host shim for esp_timer_get_time(): microseconds since the
+// process started (the same origin as millis()).
+// =============================================================
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
+
+#endif // HOST_ESP_TIMER_H
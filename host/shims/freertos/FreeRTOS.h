@@ -0,0 +1,40 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// =============================================================
+// Host shim for the FreeRTOS API subset used by the firmware.
+// Tasks are std::threads, 1 tick = 1 ms.
+// =============================================================
+
+#include <cassert>
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+constexpr BaseType_t pdFALSE = 0;
+constexpr BaseType_t pdTRUE = 1;
+constexpr BaseType_t pdPASS = pdTRUE;
+constexpr BaseType_t pdFAIL = pdFALSE;
+constexpr TickType_t portMAX_DELAY = UINT32_MAX;
+constexpr TickType_t portTICK_PERIOD_MS = 1;
+constexpr UBaseType_t tskIDLE_PRIORITY = 0;
+#define portNUM_PROCESSORS 2
+
+// Core of the calling task: the coreId it was created with, 1 for threads
+// that are not tasks (main runs setup()/loop(), which live on Core 1).
+BaseType_t xPortGetCoreID();
+
+// Masking interrupts keeps the other tasks of the calling core out (one
+// recursive lock per core); returns the state for the matching clear.
+UBaseType_t hostSetInterruptMask();
+void hostClearInterruptMask(UBaseType_t state);
+#define portSET_INTERRUPT_MASK_FROM_ISR() hostSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(state) hostClearInterruptMask(state)
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configASSERT(x) assert(x)
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,23 @@
+#ifndef HOST_FREERTOS_TIMERS_H
+#define HOST_FREERTOS_TIMERS_H
+
+#include "freertos/FreeRTOS.h"
+
+// Software timers: callbacks run on one shared service thread, like the
+// FreeRTOS timer task. A nullptr handle fails instead of asserting, so the
+// benchmarks can drive the ISRs without setup().
+struct HostTimer;
+typedef HostTimer* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload, void* id,
+                           TimerCallbackFunction_t callback);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticksToWait);
+BaseType_t xTimerResetFromISR(TimerHandle_t timer, BaseType_t* higherPriorityTaskWoken);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+void* pvTimerGetTimerID(TimerHandle_t timer);
+
+#endif // HOST_FREERTOS_TIMERS_H
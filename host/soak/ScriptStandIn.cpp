@@ -0,0 +1,276 @@
+#include "ScriptStandIn.h"
+#include "DongleListParser.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+static const char CONTENT_HOST[] = "script.googleusercontent.com";
+
+static void sleepMs(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static std::string urlHost(const std::string& url) {
+  size_t start = url.find("://");
+  start = start == std::string::npos ? 0 : start + 3;
+  size_t end = url.find_first_of(":/?", start);
+  return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+static std::string urlQuery(const std::string& url) {
+  size_t start = url.find('?');
+  return start == std::string::npos ? std::string() : url.substr(start + 1);
+}
+
+// Value of name in an application/x-www-form-urlencoded query, "" if absent
+static std::string queryParam(const std::string& query, const char* name) {
+  std::string key = std::string(name) + "=";
+  for (size_t start = 0; start <= query.size();) {
+    size_t end = query.find('&', start);
+    if (end == std::string::npos) end = query.size();
+    if (query.compare(start, key.size(), key) == 0) {
+      std::string value;
+      for (size_t i = start + key.size(); i < end; i++) {
+        if (query[i] == '%' && i + 2 < end) {
+          value += (char)strtol(query.substr(i + 1, 2).c_str(), nullptr, 16);
+          i += 2;
+        } else {
+          value += query[i] == '+' ? ' ' : query[i];
+        }
+      }
+      return value;
+    }
+    start = end + 1;
+  }
+  return std::string();
+}
+
+static HostHttp::Response makeResponse(int code, const std::string& body) {
+  HostHttp::Response response = { code, body, std::string() };
+  return response;
+}
+
+static std::string jsonStringArray(const std::vector<std::string>& values) {
+  std::string json = "[";
+  for (size_t i = 0; i < values.size(); i++) {
+    json += (i > 0 ? ",\"" : "\"") + values[i] + "\"";
+  }
+  return json + "]";
+}
+
+// =============================================================
+// Setup
+// =============================================================
+
+ScriptStandIn::ScriptStandIn(const ScriptStandInConfig& config) : _config(config), _random(config.seed) {
+  setDongleList(std::vector<std::string>());
+}
+
+void ScriptStandIn::install() {
+  HostHttp::setHandler([this](const HostHttp::Request& request) { return handle(request); });
+}
+
+void ScriptStandIn::setConfig(const ScriptStandInConfig& config) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _config = config;
+  _random.seed(config.seed);
+}
+
+void ScriptStandIn::setOutage(StandInOutage outage) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (outage != StandInOutage::NONE && _outage == StandInOutage::NONE) {
+    HostHttp::dropConnections();
+  }
+  _outage = outage;
+}
+
+void ScriptStandIn::setDongleList(const std::vector<std::string>& entries) {
+  // Same hash as googleScript: the firmware's own, over the parsed list
+  std::string json = "[";
+  for (size_t i = 0; i < entries.size(); i++) {
+    json += (i > 0 ? ",[\"" : "[\"") + entries[i] + "\"]";
+  }
+  json += "]";
+  DongleListParser parser;
+  DongleTable table;
+  parser.feed(json.data(), json.size());
+  parser.finish(&table);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_dongles.empty() || !entries.empty()) {
+    _listVersion++;
+  }
+  _dongles = entries;
+  _listHash = table.hash();
+}
+
+std::vector<StandInRow> ScriptStandIn::takeRows() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<StandInRow> rows;
+  rows.swap(_rows);
+  return rows;
+}
+
+StandInCounters ScriptStandIn::counters() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _counters;
+}
+
+bool ScriptStandIn::chance(double rate) {
+  return rate > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(_random) < rate;
+}
+
+// =============================================================
+// Requests (network task, via the HTTPClient shim)
+// =============================================================
+
+HostHttp::Response ScriptStandIn::handle(const HostHttp::Request& request) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_outage != StandInOutage::NONE) {
+    _counters.outageRejects++;
+    StandInOutage outage = _outage;
+    lock.unlock();
+    if (outage == StandInOutage::REFUSED) {
+      return makeResponse(HTTPC_ERROR_CONNECTION_REFUSED, std::string());
+    }
+    if (outage == StandInOutage::HTTP_503) {
+      return makeResponse(503, "<html><body>Service Unavailable</body></html>");
+    }
+    sleepMs(request.timeoutMs);
+    return makeResponse(HTTPC_ERROR_READ_TIMEOUT, std::string());
+  }
+
+  std::string query = urlQuery(request.url);
+  if (urlHost(request.url) == CONTENT_HOST) {
+    _counters.redirects++;
+    if (chance(_config.resultErrorRate)) {
+      _counters.resultErrors++;
+      return makeResponse(500, "<html><body>Internal Server Error</body></html>");
+    }
+    return fetchResult(query);
+  }
+
+  _counters.requests++;
+  uint32_t latencyMs = _config.latencyMs;
+  if (_config.latencyJitterMs > 0) {
+    latencyMs += std::uniform_int_distribution<uint32_t>(0, _config.latencyJitterMs)(_random);
+  }
+  bool httpError = chance(_config.errorRate);
+  bool scriptError = !httpError && chance(_config.scriptErrorRate);
+  bool redirect = _config.redirect;
+  lock.unlock();
+
+  sleepMs(std::min(latencyMs, request.timeoutMs));
+
+  lock.lock();
+  if (httpError) {
+    _counters.httpErrors++;
+    return makeResponse(500, "<html><body>Internal Server Error</body></html>");
+  }
+  HostHttp::Response response;
+  if (scriptError) {
+    _counters.scriptErrors++;
+    response = makeResponse(200, "{\"success\":false,\"message\":\"Fehler: Service Spreadsheets timed out\"}");
+  } else {
+    response = runScript(request, query);
+  }
+  if (latencyMs >= request.timeoutMs) {
+    _counters.lateTimeouts++;  // The script has run (rows written), the client gave up
+    return makeResponse(HTTPC_ERROR_READ_TIMEOUT, std::string());
+  }
+  if (!redirect) {
+    return response;
+  }
+  uint32_t key = _nextResultKey++;
+  _results[key] = response.body;
+  HostHttp::Response found = makeResponse(302, "<HTML>Moved Temporarily</HTML>");
+  found.location = std::string("https://") + CONTENT_HOST + "/macros/echo?user_content_key=" + std::to_string(key);
+  return found;
+}
+
+HostHttp::Response ScriptStandIn::fetchResult(const std::string& query) {
+  std::map<uint32_t, std::string>::iterator result =
+    _results.find((uint32_t)strtoul(queryParam(query, "user_content_key").c_str(), nullptr, 10));
+  if (result == _results.end()) {
+    return makeResponse(404, "<html><body>Not Found</body></html>");
+  }
+  HostHttp::Response response = makeResponse(200, result->second);
+  _results.erase(result);
+  return response;
+}
+
+HostHttp::Response ScriptStandIn::runScript(const HostHttp::Request& request, const std::string& query) {
+  std::string action = queryParam(query, "action");
+  if (action == "read_pa" && request.method == "GET") {
+    return makeResponse(200, readDongleList());
+  }
+  if (action == "read_pa_delta" && request.method == "GET") {
+    return makeResponse(200, readDongleDelta((uint32_t)strtoul(queryParam(query, "since").c_str(), nullptr, 10)));
+  }
+  if (action == "write_log_pa" && request.method == "GET") {
+    StandInRow row = { queryParam(query, "date"), queryParam(query, "time"), queryParam(query, "access"),
+                       queryParam(query, "dongle_id"), std::string(), millis() };
+    _rows.push_back(row);
+    _counters.rowsWritten++;
+    return makeResponse(200, "{\"success\":true,\"message\":\"Log-Eintrag erfolgreich hinzugefügt.\"}");
+  }
+  if (action == "write_log_batch" && request.method == "POST") {
+    size_t before = _counters.rowsWritten;
+    if (!writeLogBatch(request.body, millis())) {
+      return makeResponse(200, "{\"success\":false,\"message\":\"Keine Log-Einträge.\"}");
+    }
+    return makeResponse(200, "{\"success\":true,\"count\":" + std::to_string(_counters.rowsWritten - before) + "}");
+  }
+  return makeResponse(200, "{\"success\":false,\"message\":\"Ungültiger oder fehlender Action-Parameter.\"}");
+}
+
+std::string ScriptStandIn::readDongleList() const {
+  std::string json = "[";
+  for (size_t i = 0; i < _dongles.size(); i++) {
+    json += (i > 0 ? ",[\"" : "[\"") + _dongles[i] + "\"]";
+  }
+  return json + "]";
+}
+
+std::string ScriptStandIn::readDongleDelta(uint32_t since) const {
+  // Only the current version is kept: an up-to-date device gets an empty
+  // delta, every other one the full list (like a trimmed changelog)
+  bool reset = since != _listVersion;
+  return "{\"version\":" + std::to_string(_listVersion) + ",\"hash\":" + std::to_string(_listHash) +
+         ",\"reset\":" + (reset ? "true" : "false") +
+         ",\"added\":" + jsonStringArray(reset ? _dongles : std::vector<std::string>()) + ",\"removed\":[]}";
+}
+
+bool ScriptStandIn::writeLogBatch(const std::string& body, unsigned long receivedMs) {
+  // [[date, time, access, dongle_id, door?], ...] — the firmware sends plain
+  // strings without escapes, so the fields are the quoted runs of each entry
+  std::vector<StandInRow> rows;
+  std::vector<std::string> fields;
+  int depth = 0;
+  for (size_t i = 0; i < body.size(); i++) {
+    char c = body[i];
+    if (c == '[') {
+      depth++;
+      fields.clear();
+    } else if (c == ']') {
+      if (depth == 2) {
+        if (fields.size() < 4) return false;
+        StandInRow row = { fields[0], fields[1], fields[2], fields[3], fields.size() > 4 ? fields[4] : std::string(),
+                           receivedMs };
+        rows.push_back(row);
+      }
+      depth--;
+    } else if (c == '"') {
+      size_t end = body.find('"', i + 1);
+      if (end == std::string::npos || depth != 2) return false;
+      fields.push_back(body.substr(i + 1, end - i - 1));
+      i = end;
+    }
+  }
+  if (depth != 0 || rows.empty()) {
+    return false;
+  }
+  _rows.insert(_rows.end(), rows.begin(), rows.end());
+  _counters.rowsWritten += rows.size();
+  return true;
+}
@@ -0,0 +1,98 @@
+#ifndef HOST_SCRIPT_STAND_IN_H
+#define HOST_SCRIPT_STAND_IN_H
+
+// =============================================================
+// ScriptStandIn
+// Local stand-in for the googleScript web app at WEB_APP_URL, served
+// through the HTTPClient shim (HostHttp::setHandler), so the firmware's
+// unmodified ScriptClient talks to it. Implements read_pa, read_pa_delta,
+// write_log_pa and write_log_batch with the same responses as the
+// script, including the 302 to script.googleusercontent.com that every
+// Apps Script request gets. Latency, error rates and outages are
+// configurable at any time; every row written is recorded with the
+// millis() it arrived at.
+// =============================================================
+
+#include "HTTPClient.h"
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+struct ScriptStandInConfig {
+  uint32_t latencyMs = 0;        // Script run time per request (before the redirect)
+  uint32_t latencyJitterMs = 0;  // Plus a uniform 0..jitter
+  double errorRate = 0;          // Fraction answered with HTTP 500, script not run
+  double scriptErrorRate = 0;    // Fraction answered 200 {"success":false}, script not run
+  double resultErrorRate = 0;    // Fraction of result fetches answered with HTTP 500, script has run
+  bool redirect = true;          // Answer through a 302 to the content host, as Apps Script does
+  uint32_t seed = 1;
+};
+
+enum class StandInOutage : uint8_t {
+  NONE,
+  REFUSED,   // Connection refused at once
+  HTTP_503,  // Server reachable, answers 503
+  TIMEOUT,   // Request hangs until the client's timeout
+};
+
+struct StandInRow {
+  std::string date;
+  std::string time;
+  std::string access;
+  std::string dongleId;
+  std::string door;         // Empty for write_log_pa
+  unsigned long receivedMs;
+};
+
+struct StandInCounters {
+  uint32_t requests;        // Script requests (first hop)
+  uint32_t redirects;       // Content fetches (second hop)
+  uint32_t httpErrors;      // errorRate hits
+  uint32_t scriptErrors;    // scriptErrorRate hits
+  uint32_t resultErrors;    // resultErrorRate hits
+  uint32_t outageRejects;   // Requests refused, 503 or timed out by an outage
+  uint32_t lateTimeouts;    // Latency beyond the client timeout: script ran, client saw a timeout
+  uint32_t rowsWritten;
+};
+
+class ScriptStandIn {
+  private:
+    mutable std::mutex _mutex;
+    ScriptStandInConfig _config;
+    StandInOutage _outage = StandInOutage::NONE;
+    std::mt19937 _random;
+    std::vector<std::string> _dongles;         // Entries as googleScript sends them
+    uint32_t _listVersion = 1;
+    uint32_t _listHash = 0;
+    std::map<uint32_t, std::string> _results;  // Content bodies by user_content_key, until fetched
+    uint32_t _nextResultKey = 1;
+    std::vector<StandInRow> _rows;             // Written since the last takeRows()
+    StandInCounters _counters = {};
+
+    HostHttp::Response runScript(const HostHttp::Request& request, const std::string& query);
+    HostHttp::Response fetchResult(const std::string& query);
+    std::string readDongleList() const;
+    std::string readDongleDelta(uint32_t since) const;
+    bool writeLogBatch(const std::string& body, unsigned long receivedMs);
+    bool chance(double rate);
+
+  public:
+    explicit ScriptStandIn(const ScriptStandInConfig& config = ScriptStandInConfig());
+
+    // Become the HTTPClient shim's server (replaces any previous handler).
+    void install();
+    HostHttp::Response handle(const HostHttp::Request& request);
+
+    void setConfig(const ScriptStandInConfig& config);
+    // Starting an outage also closes all kept-alive connections.
+    void setOutage(StandInOutage outage);
+    // New dongle list: a new version, devices get it as a full list (reset).
+    void setDongleList(const std::vector<std::string>& entries);
+
+    std::vector<StandInRow> takeRows();
+    StandInCounters counters() const;
+};
+
+#endif // HOST_SCRIPT_STAND_IN_H
@@ -0,0 +1,368 @@
+// =============================================================
+// Host end-to-end load/soak harness for the log pipeline.
+// The unmodified sketch (setup() and loop()), network task and
+// ScriptClient run against ScriptStandIn in place of the web app. A load
+// task plays the hardware: Wiegand frames on the reader pins and door
+// contact changes, at fixed rates spread over all doors, with an optional
+// outage in between. Every scan carries a unique ID, so each row the
+// stand-in receives is matched to its scan.
+// Usage: rfid_soak [--name=value ...]   (rfid_soak --help)
+// Runs in real time: the firmware's intervals (batch age, retry backoff,
+// WiFi reconnect) apply unchanged, so outages need minutes to play out.
+// =============================================================
+
+#include "NetworkTask.cpp"  // Unity include: reaches logEventRing, droppedLogCount, failedLogRing
+#include "DoorChannel.h"
+#include "ScriptStandIn.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Sketch (RFID_null7b.ino)
+void setup();
+void loop();
+
+struct SoakOptions {
+  unsigned long durationMs = 120000;   // Load phase
+  double scanRate = 2.0;               // Scans per second, all doors together
+  double doorRate = 0.2;               // Door contact changes per second, all doors together
+  uint32_t latencyMs = 1500;           // Stand-in script run time per request
+  uint32_t jitterMs = 1000;
+  double errorRate = 0.01;
+  double scriptErrorRate = 0.01;
+  double resultErrorRate = 0.01;
+  bool redirect = true;
+  unsigned long outageAtMs = 30000;    // Outage start within the load phase
+  unsigned long outageForMs = 0;       // 0 = no outage
+  std::string outageMode = "refused";  // refused | http503 | timeout | wifi
+  unsigned long drainTimeoutMs = 180000;  // Max wait after the load phase for the backlog to clear
+  uint32_t seed = 1;
+};
+
+static SoakOptions options;
+static ScriptStandIn standIn;
+
+static const uint32_t AUTHORISED_EVERY = 4;  // Every 4th scan ID is on the dongle list
+static const uint32_t LISTED_SCANS = 4096;
+
+// =============================================================
+// Options
+// =============================================================
+
+static void printUsage() {
+  printf("Usage: rfid_soak [--name=value ...]\n"
+         "  --duration=S          load phase in seconds (120)\n"
+         "  --scan-rate=N         scans per second (2)\n"
+         "  --door-rate=N         door contact changes per second (0.2)\n"
+         "  --latency=MS          stand-in script time per request (1500)\n"
+         "  --jitter=MS           plus uniform 0..jitter (1000)\n"
+         "  --error-rate=F        fraction answered HTTP 500 (0.01)\n"
+         "  --script-error-rate=F fraction answered success:false (0.01)\n"
+         "  --result-error-rate=F fraction of result fetches answered HTTP 500 (0.01)\n"
+         "  --no-redirect         answer directly instead of through the 302\n"
+         "  --outage-at=S         outage start within the load phase (30)\n"
+         "  --outage-for=S        outage length, 0 = none (0)\n"
+         "  --outage-mode=M       refused | http503 | timeout | wifi (refused)\n"
+         "  --drain-timeout=S     max wait for the backlog after the load (180)\n"
+         "  --seed=N              stand-in error/latency seed (1)\n");
+}
+
+static bool parseOption(const std::string& arg) {
+  size_t eq = arg.find('=');
+  std::string name = arg.substr(0, eq);
+  std::string value = eq == std::string::npos ? std::string() : arg.substr(eq + 1);
+  double number = atof(value.c_str());
+  if (name == "--duration") options.durationMs = (unsigned long)(number * 1000);
+  else if (name == "--scan-rate") options.scanRate = number;
+  else if (name == "--door-rate") options.doorRate = number;
+  else if (name == "--latency") options.latencyMs = (uint32_t)number;
+  else if (name == "--jitter") options.jitterMs = (uint32_t)number;
+  else if (name == "--error-rate") options.errorRate = number;
+  else if (name == "--script-error-rate") options.scriptErrorRate = number;
+  else if (name == "--result-error-rate") options.resultErrorRate = number;
+  else if (name == "--no-redirect") options.redirect = false;
+  else if (name == "--outage-at") options.outageAtMs = (unsigned long)(number * 1000);
+  else if (name == "--outage-for") options.outageForMs = (unsigned long)(number * 1000);
+  else if (name == "--outage-mode") options.outageMode = value;
+  else if (name == "--drain-timeout") options.drainTimeoutMs = (unsigned long)(number * 1000);
+  else if (name == "--seed") options.seed = (uint32_t)number;
+  else return false;
+  return true;
+}
+
+static bool outageModeValid() {
+  return options.outageMode == "refused" || options.outageMode == "http503" || options.outageMode == "timeout" ||
+         options.outageMode == "wifi";
+}
+
+static void setOutage(bool active) {
+  if (options.outageMode == "wifi") {
+    WiFi.setLinkUp(!active);
+  } else if (!active) {
+    standIn.setOutage(StandInOutage::NONE);
+  } else if (options.outageMode == "refused") {
+    standIn.setOutage(StandInOutage::REFUSED);
+  } else if (options.outageMode == "http503") {
+    standIn.setOutage(StandInOutage::HTTP_503);
+  } else {
+    standIn.setOutage(StandInOutage::TIMEOUT);
+  }
+}
+
+// =============================================================
+// Load task (the readers and door contacts)
+// =============================================================
+
+struct SoakScan {
+  unsigned long scannedMs;
+  unsigned long receivedMs;  // 0 = not delivered (yet)
+  uint32_t copies;
+};
+
+struct SoakStats {
+  std::vector<SoakScan> scans;  // Index = scan ID - 1
+  uint32_t doorEventsSent = DOOR_COUNT;  // setup() logs the initial state of every door
+  uint32_t doorRows = 0;        // Distinct door rows
+  uint32_t doorDuplicates = 0;
+  std::map<std::string, uint32_t> doorRowCopies;  // By date, time, access and door (one change per second at most)
+  uint32_t unknownRows = 0;
+  uint32_t maxBacklog = 0;
+  unsigned long backlogClearedMs = 0;  // First empty backlog after the outage, 0 = not seen
+};
+
+static SoakStats stats;
+
+static uint32_t scanFrame(uint32_t scanId) {
+  return DoorReaderFormat::encode(scanId);
+}
+
+static void sendFrame(uint8_t door, uint32_t frameBits) {
+  for (int bit = DoorReaderFormat::BITS - 1; bit >= 0; bit--) {
+    uint8_t pin = ((frameBits >> bit) & 1) ? DOORS[door].data1Pin : DOORS[door].data0Pin;
+    HostGpio::setLevel(pin, LOW);
+    HostGpio::setLevel(pin, HIGH);
+  }
+}
+
+static void collectRows() {
+  std::vector<StandInRow> rows = standIn.takeRows();
+  for (const StandInRow& row : rows) {
+    if (row.dongleId == LOG_DOOR_DONGLE_ID) {
+      if (stats.doorRowCopies[row.date + row.time + row.access + row.door]++ == 0) {
+        stats.doorRows++;
+      } else {
+        stats.doorDuplicates++;
+      }
+      continue;
+    }
+    uint32_t frameBits = (uint32_t)strtoul(row.dongleId.c_str(), nullptr, 2);
+    uint32_t scanId = (uint32_t)DoorReaderFormat::data(frameBits);
+    if (scanId == 0 || scanId > stats.scans.size() || scanFrame(scanId) != frameBits) {
+      stats.unknownRows++;
+      continue;
+    }
+    SoakScan& scan = stats.scans[scanId - 1];
+    if (scan.copies++ == 0) {
+      scan.receivedMs = row.receivedMs;
+    }
+  }
+}
+
+static uint32_t lostEvents() {
+  return droppedLogCount + failedLogRing.droppedCount();
+}
+
+static bool allAccountedFor() {
+  uint32_t delivered = stats.doorRows;
+  for (const SoakScan& scan : stats.scans) {
+    delivered += scan.copies > 0 ? 1 : 0;
+  }
+  return delivered + lostEvents() >= stats.scans.size() + stats.doorEventsSent;
+}
+
+// The backlog counters belong to the network task: sampled without a lock, good enough for a report
+static void sample(unsigned long now, unsigned long outageEndMs) {
+  uint32_t backlog = failedLogRing.pendingCount();
+  stats.maxBacklog = std::max(stats.maxBacklog, backlog);
+  if (options.outageForMs > 0 && now >= outageEndMs && stats.backlogClearedMs == 0 && backlog == 0) {
+    stats.backlogClearedMs = now;
+  }
+  collectRows();
+}
+
+static double percentile(std::vector<unsigned long>& values, double p) {
+  if (values.empty()) return 0;
+  size_t index = (size_t)(p * (values.size() - 1) + 0.5);
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return (double)values[index];
+}
+
+static bool printReport(unsigned long startMs, unsigned long outageStartMs, unsigned long outageEndMs) {
+  std::vector<unsigned long> latencies;
+  uint32_t delivered = 0;
+  uint32_t duplicates = stats.doorDuplicates;
+  uint32_t outageScans = 0;
+  uint32_t outageDelivered = 0;
+  unsigned long outageLastMs = 0;
+  for (const SoakScan& scan : stats.scans) {
+    bool duringOutage = options.outageForMs > 0 && scan.scannedMs >= outageStartMs && scan.scannedMs < outageEndMs;
+    outageScans += duringOutage ? 1 : 0;
+    if (scan.copies == 0) continue;
+    delivered++;
+    duplicates += scan.copies - 1;
+    latencies.push_back(scan.receivedMs - scan.scannedMs);
+    if (duringOutage) {
+      outageDelivered++;
+      outageLastMs = std::max(outageLastMs, scan.receivedMs);
+    }
+  }
+  uint32_t sent = stats.scans.size() + stats.doorEventsSent;
+  uint32_t rows = delivered + stats.doorRows;
+  uint32_t missing = sent > rows + lostEvents() ? sent - rows - lostEvents() : 0;
+
+  printf("\nSoak: %.0f s load, %.2f scans/s + %.2f door events/s on %d door(s), stand-in %u+%u ms, errors %.3f/%.3f/%.3f%s\n",
+         options.durationMs / 1000.0, options.scanRate, options.doorRate, DOOR_COUNT, (unsigned)options.latencyMs,
+         (unsigned)options.jitterMs, options.errorRate, options.scriptErrorRate, options.resultErrorRate, options.redirect ? "" : ", no redirect");
+  if (options.outageForMs > 0) {
+    printf("Outage: %s from %.1f s to %.1f s\n", options.outageMode.c_str(), (outageStartMs - startMs) / 1000.0,
+           (outageEndMs - startMs) / 1000.0);
+  }
+  printf("%-26s %u (%u scans, %u door)\n", "events sent", (unsigned)sent, (unsigned)stats.scans.size(),
+         (unsigned)stats.doorEventsSent);
+  printf("%-26s %u (%u scans, %u door), %u duplicate(s), %u unknown row(s)\n", "delivered", (unsigned)rows,
+         (unsigned)delivered, (unsigned)stats.doorRows, (unsigned)duplicates, (unsigned)stats.unknownRows);
+  printf("%-26s %u (%.2f %%)\n", "dropped at log ring", (unsigned)droppedLogCount,
+         sent > 0 ? 100.0 * droppedLogCount / sent : 0.0);
+  printf("%-26s %u\n", "overwritten in backlog", (unsigned)failedLogRing.droppedCount());
+  printf("%-26s %u\n", "missing", (unsigned)missing);
+  printf("%-26s p50 %.0f  p95 %.0f  p99 %.0f  max %.0f\n", "scan -> row latency ms", percentile(latencies, 0.50),
+         percentile(latencies, 0.95), percentile(latencies, 0.99), percentile(latencies, 1.0));
+  printf("%-26s %u events, now %u; log ring high-water %u of %u\n", "failed-log backlog max",
+         (unsigned)stats.maxBacklog, (unsigned)failedLogRing.pendingCount(), (unsigned)logEventRingHighWater.load(),
+         (unsigned)LOG_QUEUE_SIZE);
+  if (options.outageForMs > 0) {
+    if (stats.backlogClearedMs != 0) {
+      printf("%-26s %.1f s after the outage\n", "backlog cleared", (stats.backlogClearedMs - outageEndMs) / 1000.0);
+    } else {
+      printf("%-26s never\n", "backlog cleared");
+    }
+    printf("%-26s %u/%u, last %.1f s after the outage\n", "outage scans delivered", (unsigned)outageDelivered,
+           (unsigned)outageScans, outageLastMs > outageEndMs ? (outageLastMs - outageEndMs) / 1000.0 : 0.0);
+  }
+  StandInCounters counters = standIn.counters();
+  printf("%-26s %u requests, %u redirects, %u HTTP 500, %u script errors, %u result errors, %u outage rejects, "
+         "%u late timeouts\n", "stand-in", (unsigned)counters.requests, (unsigned)counters.redirects,
+         (unsigned)counters.httpErrors, (unsigned)counters.scriptErrors, (unsigned)counters.resultErrors,
+         (unsigned)counters.outageRejects, (unsigned)counters.lateTimeouts);
+  // Duplicates are reported, not failed: a batch the script wrote while the POST
+  // timed out is sent again (at-least-once). A lost result after the 302 is not.
+  return missing == 0 && stats.unknownRows == 0;
+}
+
+static void loadTaskLoop(void* param) {
+  (void)param;
+  unsigned long startMs = millis();
+  unsigned long outageStartMs = startMs + options.outageAtMs;
+  unsigned long outageEndMs = outageStartMs + options.outageForMs;
+  unsigned long endMs = startMs + options.durationMs;
+  double nextScanMs = startMs;
+  double nextDoorMs = startMs;
+  unsigned long nextSampleMs = startMs;
+  uint32_t doorTurn = 0;
+  bool outageActive = false;
+
+  printf("Soak: load for %.0f s ...\n", options.durationMs / 1000.0);
+  fflush(stdout);
+  for (unsigned long now = millis(); now < endMs; now = millis()) {
+    if (options.outageForMs > 0 && outageActive != (now >= outageStartMs && now < outageEndMs)) {
+      outageActive = !outageActive;
+      setOutage(outageActive);
+      printf("Soak: outage %s at %.1f s\n", outageActive ? "starts" : "ends", (now - startMs) / 1000.0);
+      fflush(stdout);
+    }
+    if (options.scanRate > 0 && now >= nextScanMs) {
+      SoakScan scan = { now, 0, 0 };
+      stats.scans.push_back(scan);
+      uint32_t scanId = stats.scans.size();
+      sendFrame(scanId % DOOR_COUNT, scanFrame(scanId));
+      nextScanMs += 1000.0 / options.scanRate;
+    }
+    if (options.doorRate > 0 && now >= nextDoorMs) {
+      uint8_t door = doorTurn++ % DOOR_COUNT;
+      uint8_t pin = DOORS[door].contactPin;
+      HostGpio::setLevel(pin, HostGpio::level(pin) == LOW ? HIGH : LOW);
+      stats.doorEventsSent++;
+      nextDoorMs += std::max(1000.0 / options.doorRate, (double)DOOR_DEBOUNCE_MS * 2 * DOOR_COUNT);
+    }
+    if (now >= nextSampleMs) {
+      sample(now, outageEndMs);
+      nextSampleMs += 100;
+    }
+    vTaskDelay(1);
+  }
+  if (outageActive) {
+    setOutage(false);
+    outageEndMs = millis();
+  }
+
+  printf("Soak: load done, waiting for the backlog ...\n");
+  fflush(stdout);
+  unsigned long drainEndMs = millis() + options.drainTimeoutMs;
+  while (millis() < drainEndMs) {
+    sample(millis(), outageEndMs);
+    if (allAccountedFor() && failedLogRing.pendingCount() == 0) break;
+    vTaskDelay(pdMS_TO_TICKS(100));
+  }
+  vTaskDelay(pdMS_TO_TICKS(500));  // Late duplicates
+  collectRows();
+
+  bool clean = printReport(startMs, outageStartMs, outageEndMs);
+  fflush(stdout);
+  _exit(clean ? 0 : 1);  // loop() never returns
+}
+
+// =============================================================
+// Main (the loop task, Core 1)
+// =============================================================
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!parseOption(argv[i])) {
+      printUsage();
+      return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+    }
+  }
+  if (!outageModeValid()) {
+    printUsage();
+    return 2;
+  }
+
+  ScriptStandInConfig config;
+  config.latencyMs = options.latencyMs;
+  config.latencyJitterMs = options.jitterMs;
+  config.errorRate = options.errorRate;
+  config.scriptErrorRate = options.scriptErrorRate;
+  config.resultErrorRate = options.resultErrorRate;
+  config.redirect = options.redirect;
+  config.seed = options.seed;
+  standIn.setConfig(config);
+
+  std::vector<std::string> entries;
+  char idStr[CharArrayDongleIdSize];
+  for (uint32_t scanId = AUTHORISED_EVERY; scanId <= LISTED_SCANS; scanId += AUTHORISED_EVERY) {
+    formatDongleId(scanFrame(scanId), idStr);
+    entries.push_back(idStr);
+  }
+  standIn.setDongleList(entries);
+  standIn.install();
+
+  HostFlash::reset();
+  setup();
+  xTaskCreatePinnedToCore(loadTaskLoop, "SoakLoad", 8192, nullptr, 1, nullptr, 1);
+  for (;;) {
+    loop();
+  }
+}
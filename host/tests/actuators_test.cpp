@@ -0,0 +1,131 @@
+// Tests for RelayPulse and BuzzerSequencer on the timer shim: the pin edges
+// of a pulse and a pattern, a re-triggered pulse, a pattern cut off by the
+// next one, and stale timer notifications.
+
+#include "Actuators.h"
+#include "check.h"
+#include <stdio.h>
+#include <vector>
+
+static const uint8_t RELAY_PIN = 30;
+static const uint8_t BUZZER_PIN = 31;
+static const long EARLY_MS = 2;   // Tick rounding (ActuatorTimer::isDue)
+static const long LATE_MS = 20;   // Timer thread and notification latency on a loaded host
+
+static RelayPulse relay;
+static BuzzerSequencer buzzer;
+
+struct Edge {
+  long atMs;  // Since the start of run()
+  int level;
+};
+
+// Play the owning task for durationMs: hand timer notifications to the
+// actuators and record the edges of pin
+static std::vector<Edge> run(uint8_t pin, unsigned long startMs, unsigned long durationMs) {
+  std::vector<Edge> edges;
+  int level = digitalRead(pin);
+  while (millis() - startMs < durationMs) {
+    uint32_t notifications = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &notifications, pdMS_TO_TICKS(durationMs - (millis() - startMs)));
+    if (notifications & MAIN_NOTIFY_RELAY_TIMER) {
+      relay.onTimer();
+    }
+    if (notifications & MAIN_NOTIFY_BUZZER_TIMER) {
+      buzzer.onTimer();
+    }
+    if (digitalRead(pin) != level) {
+      level = digitalRead(pin);
+      edges.push_back({ (long)(millis() - startMs), level });
+    }
+  }
+  return edges;
+}
+
+static bool edgeAt(const Edge& edge, long expectedMs, int level) {
+  bool ok = edge.level == level && edge.atMs >= expectedMs - EARLY_MS && edge.atMs <= expectedMs + LATE_MS;
+  if (!ok) {
+    printf("edge to %d at %ld ms, expected at %ld ms\n", edge.level, edge.atMs, expectedMs);
+  }
+  return ok;
+}
+
+static void testRelayPulse() {
+  unsigned long start = millis();
+  relay.pulse(100);
+  CHECK(digitalRead(RELAY_PIN) == HIGH && relay.isActive());
+  std::vector<Edge> edges = run(RELAY_PIN, start, 200);
+  CHECK(edges.size() == 1 && edgeAt(edges[0], 100, LOW));
+  CHECK(!relay.isActive());
+}
+
+static void testRelayRetriggerExtends() {
+  // A second scan 60 ms into the pulse: the relay stays on until 100 ms after it
+  unsigned long start = millis();
+  relay.pulse(100);
+  std::vector<Edge> edges = run(RELAY_PIN, start, 60);
+  CHECK(edges.empty());
+  relay.pulse(100);
+  unsigned long retriggeredAt = millis() - start;
+
+  // The first pulse's expiry, delivered late, does not end the second
+  relay.onTimer();
+  CHECK(digitalRead(RELAY_PIN) == HIGH);
+
+  edges = run(RELAY_PIN, start, 250);
+  CHECK(edges.size() == 1 && edgeAt(edges[0], (long)retriggeredAt + 100, LOW));
+}
+
+static void testBuzzerEdges() {
+  // AuthOk: beep 60, pause 60, beep 60
+  unsigned long start = millis();
+  buzzer.play(BuzzerSound::AuthOk);
+  CHECK(digitalRead(BUZZER_PIN) == HIGH && buzzer.isPlaying());
+  std::vector<Edge> edges = run(BUZZER_PIN, start, 300);
+  CHECK(edges.size() == 3);
+  if (edges.size() == 3) {
+    // Each step is timed from the previous edge, so lateness does not add up within a check
+    CHECK(edgeAt(edges[0], 60, LOW));
+    CHECK(edgeAt(edges[1], edges[0].atMs + 60, HIGH));
+    CHECK(edgeAt(edges[2], edges[1].atMs + 60, LOW));
+  }
+  CHECK(!buzzer.isPlaying());
+}
+
+static void testNewPatternCutsOff() {
+  // SOS is cut off 50 ms into its first beep by NoAuth (one 600 ms beep): no
+  // edge of SOS follows, the buzzer goes quiet 600 ms after the cut
+  unsigned long start = millis();
+  buzzer.play(BuzzerSound::SOS);
+  std::vector<Edge> edges = run(BUZZER_PIN, start, 50);
+  CHECK(edges.empty());
+  buzzer.play(BuzzerSound::NoAuth);
+  unsigned long cutAt = millis() - start;
+  CHECK(digitalRead(BUZZER_PIN) == HIGH);
+
+  // SOS's first step, delivered late, does not advance NoAuth
+  buzzer.onTimer();
+  CHECK(digitalRead(BUZZER_PIN) == HIGH);
+
+  edges = run(BUZZER_PIN, start, 800);
+  CHECK(edges.size() == 1 && edgeAt(edges[0], (long)cutAt + 600, LOW));
+  CHECK(!buzzer.isPlaying());
+
+  // A pattern replacing a finished one starts from its first step
+  start = millis();
+  buzzer.play(BuzzerSound::OK);
+  edges = run(BUZZER_PIN, start, 200);
+  CHECK(edges.size() == 1 && edgeAt(edges[0], 120, LOW));
+}
+
+int main() {
+  relay.begin(RELAY_PIN, xTaskGetCurrentTaskHandle(), MAIN_NOTIFY_RELAY_TIMER);
+  buzzer.begin(BUZZER_PIN, xTaskGetCurrentTaskHandle(), MAIN_NOTIFY_BUZZER_TIMER);
+  CHECK(digitalRead(RELAY_PIN) == LOW && digitalRead(BUZZER_PIN) == LOW);
+
+  testRelayPulse();
+  testRelayRetriggerExtends();
+  testBuzzerEdges();
+  testNewPatternCutsOff();
+  return checkSummary("actuators");
+}
@@ -0,0 +1,30 @@
+#ifndef HOST_TESTS_CHECK_H
+#define HOST_TESTS_CHECK_H
+
+// Assertions shared by the host tests: CHECK() reports a failed condition
+// with its location and carries on, so one run lists every failure;
+// checkSummary() turns the count into the exit code at the end of main().
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+// Print the result of test name; returns the exit code (1 if any CHECK failed)
+static inline int checkSummary(const char* name) {
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("%s: all checks passed\n", name);
+  return 0;
+}
+
+#endif // HOST_TESTS_CHECK_H
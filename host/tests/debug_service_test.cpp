@@ -0,0 +1,144 @@
+// Tests for the asynchronous DBG() sink: record encoding (literals by
+// pointer, buffers copied), formatting, per-core rings, the dropped-message
+// counter and concurrent producers. Built with DEBUG_MODE (see CMakeLists.txt).
+
+#include "DebugService.h"
+#include "check.h"
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+
+class Capture : public Print {
+  public:
+    std::string text;
+    size_t write(uint8_t c) override { text += (char)c; return 1; }
+};
+
+static std::string drainAll() {
+  Capture capture;
+  DebugService::getInstance()->drain(capture);
+  return capture.text;
+}
+
+static size_t countLines(const std::string& text, const std::string& prefix) {
+  size_t count = 0;
+  for (size_t start = 0; start < text.size();) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos) break;
+    if (text.compare(start, prefix.size(), prefix) == 0) count++;
+    start = end + 1;
+  }
+  return count;
+}
+
+static void testEncoding() {
+  char buffer[16] = "on the stack";
+  DebugRecord record;
+  record.argCount = 0;
+  record.textLength = 0;
+  encodeDebugArg(record, "literal");
+  encodeDebugArg(record, buffer);
+  encodeDebugArg(record, (const char*)nullptr);
+  CHECK(record.argCount == 3);
+  CHECK(record.types[0] == DEBUG_ARG_LITERAL);
+  CHECK(record.types[1] == DEBUG_ARG_TEXT);
+  CHECK(record.textLength == strlen(buffer) + 1);
+
+  // Copied strings fill the text area and are truncated, never overrun it
+  std::string longText(100, 'x');
+  encodeDebugArg(record, longText.c_str());
+  encodeDebugArg(record, longText.c_str());
+  CHECK(record.textLength == DEBUG_TEXT_BYTES);
+  char line[DEBUG_LINE_MAX];
+  size_t length = formatDebugRecord(record, line, sizeof(line));
+  size_t copied = DEBUG_TEXT_BYTES - (strlen(buffer) + 1) - 1;  // Rest of the text area minus its NUL
+  CHECK(length == strlen("literal") + strlen(buffer) + copied);
+
+  // Output is cut at the buffer size
+  CHECK(formatDebugRecord(record, line, 8) == 7);
+  CHECK(strcmp(line, "literal") == 0);
+}
+
+static void testFormatting() {
+  char buffer[16] = "buffer";
+  String text("string");
+  DBG(true, "int ", -42, " uint ", 4000000000u, " char ", 'c', " ip ", IPAddress(192, 168, 1, 7), " ", buffer, " ",
+      text);
+  strcpy(buffer, "changed");  // The record holds a copy
+  CHECK(drainAll() == "int -42 uint 4000000000 char c ip 192.168.1.7 buffer string\n");
+
+  DBG(false, "filtered by the flag");
+  CHECK(drainAll().empty());
+}
+
+static void testDroppedMessages() {
+  uint32_t droppedBefore = DebugService::getInstance()->droppedCount();
+  for (uint32_t i = 0; i < DEBUG_RING_SIZE + 5; i++) {
+    DBG(true, "message ", i);
+  }
+  CHECK(DebugService::getInstance()->droppedCount() == droppedBefore + 5);
+
+  std::string output = drainAll();
+  CHECK(countLines(output, "message ") == DEBUG_RING_SIZE);
+  CHECK(output.find("message 0\n") != std::string::npos);
+  CHECK(output.find("[debug] 5 message(s) dropped") != std::string::npos);
+
+  // Reported once
+  CHECK(drainAll().empty());
+}
+
+static const int MESSAGES_PER_TASK = 2000;
+static std::atomic<int> finishedTasks{0};
+
+static void producerTask(void* param) {
+  for (int i = 0; i < MESSAGES_PER_TASK; i++) {
+    DBG(true, "task ", (int)(intptr_t)param, " message ", i);
+  }
+  finishedTasks++;
+  for (;;) vTaskDelay(1000);
+}
+
+static void testConcurrentProducers() {
+  // Two tasks on Core 0 share a ring, the main thread (Core 1) uses the other;
+  // the drain runs meanwhile. Lines must never interleave.
+  finishedTasks = 0;
+  xTaskCreatePinnedToCore(producerTask, "P1", 4096, (void*)1, 1, nullptr, 0);
+  xTaskCreatePinnedToCore(producerTask, "P2", 4096, (void*)2, 1, nullptr, 0);
+  std::string output;
+  for (int i = 0; i < MESSAGES_PER_TASK; i++) {
+    DBG(true, "task ", 3, " message ", i);
+    if (i % 16 == 0) {
+      output += drainAll();
+    }
+  }
+  while (finishedTasks < 2) {
+    output += drainAll();
+    vTaskDelay(1);
+  }
+  output += drainAll();
+
+  CHECK(countLines(output, "task 3 ") > 0);
+  CHECK(countLines(output, "task ") + countLines(output, "[debug]") == countLines(output, ""));
+  for (size_t start = 0; start < output.size();) {
+    size_t end = output.find('\n', start);
+    int task, message;
+    char tail;
+    std::string line = output.substr(start, end - start);
+    bool wellFormed = sscanf(line.c_str(), "task %d message %d%c", &task, &message, &tail) == 2 ||
+                      line.compare(0, 7, "[debug]") == 0;
+    CHECK(wellFormed);
+    if (!wellFormed) break;
+    start = end + 1;
+  }
+}
+
+int main() {
+  testEncoding();
+  testFormatting();
+  testDroppedMessages();
+  testConcurrentProducers();
+
+  int exitCode = checkSummary("debug_service");
+  fflush(stdout);
+  _exit(exitCode);  // Producer tasks never return
+}
@@ -0,0 +1,210 @@
+// Tests for DongleListParser on the input the network delivers: chunks split
+// anywhere, truncated bodies, escapes, over-long strings, trailing garbage,
+// and a long list parsed without memory growing with the body.
+
+#include "DongleListParser.h"
+#include "check.h"
+#include <malloc.h>
+#include <stdio.h>
+#include <string>
+
+static const char ID_A[] = "00000000000000000000000011";
+static const char ID_B[] = "00000000000000000000000101";
+static const char ID_C[] = "00000000000000000000000111";
+
+// A read_pa_delta answer with every kind of token: keys, scalars, escapes,
+// door/schedule suffixes, a skipped entry and an ignored field
+static const std::string DELTA = std::string("{\"version\":17,\"hash\":305419896,\"reset\":false,\"note\":\"a \\\"b\\\" \\u00e4\",") +
+                                 "\"added\":[\"" + ID_A + ":1,2@1-5/7-19!2030-12-31\",\"" + ID_B + "\",\"x\\\"" + ID_C +
+                                 "\", 42],\n \"removed\":[\"" + ID_C + "\"]}";
+
+struct ParseResult {
+  bool ok;
+  DongleListParser::Status status;
+  uint32_t version;
+  uint32_t hash;
+  bool reset;
+  size_t skipped;
+  size_t addedSize;
+  uint32_t addedHash;
+  size_t removedSize;
+  uint32_t removedHash;
+
+  bool operator==(const ParseResult& other) const {
+    return ok == other.ok && status == other.status && version == other.version && hash == other.hash &&
+           reset == other.reset && skipped == other.skipped && addedSize == other.addedSize &&
+           addedHash == other.addedHash && removedSize == other.removedSize && removedHash == other.removedHash;
+  }
+};
+
+// Feed text in chunks of chunkSize bytes (0 = all at once)
+static ParseResult parse(const std::string& text, size_t chunkSize = 0) {
+  DongleListParser parser;
+  size_t step = chunkSize > 0 ? chunkSize : text.size();
+  for (size_t pos = 0; pos < text.size(); pos += step) {
+    parser.feed(text.data() + pos, std::min(step, text.size() - pos));
+  }
+  DongleTable added;
+  DongleTable removed;
+  ParseResult result;
+  result.ok = parser.finish(&added, &removed);
+  result.status = parser.status();
+  result.version = parser.version();
+  result.hash = parser.hash();
+  result.reset = parser.isReset();
+  result.skipped = parser.skippedCount();
+  result.addedSize = added.size();
+  result.addedHash = added.hash();
+  result.removedSize = removed.size();
+  result.removedHash = removed.hash();
+  return result;
+}
+
+static void testChunkBoundaries() {
+  ParseResult whole = parse(DELTA);
+  CHECK(whole.ok && whole.version == 17 && whole.hash == 305419896 && !whole.reset);
+  CHECK(whole.addedSize == 2 && whole.removedSize == 1 && whole.skipped == 2);
+
+  // Split in two at every offset, and byte by byte
+  for (size_t split = 1; split < DELTA.size(); split++) {
+    DongleListParser parser;
+    parser.feed(DELTA.data(), split);
+    parser.feed(DELTA.data() + split, DELTA.size() - split);
+    DongleTable added;
+    DongleTable removed;
+    bool ok = parser.finish(&added, &removed);
+    if (!ok || parser.version() != whole.version || parser.hash() != whole.hash ||
+        parser.skippedCount() != whole.skipped || added.hash() != whole.addedHash ||
+        removed.hash() != whole.removedHash) {
+      printf("split at %zu differs\n", split);
+      CHECK(false);
+      break;
+    }
+  }
+  CHECK(parse(DELTA, 1) == whole);
+}
+
+static void testTruncated() {
+  // Every cut short of the closing brace fails; nothing half-parsed is handed out
+  for (size_t length = 0; length < DELTA.size(); length++) {
+    ParseResult result = parse(DELTA.substr(0, length));
+    if (result.ok || result.status != DongleListParser::INVALID_INPUT || result.addedSize != 0) {
+      printf("truncated at %zu accepted\n", length);
+      CHECK(false);
+      break;
+    }
+  }
+  CHECK(!parse(std::string("[\"") + ID_A).ok);
+  CHECK(!parse("[[\"" + std::string(ID_A) + "\"]").ok);
+}
+
+static void testEscapes() {
+  // An escaped quote does not end the string; strings with escapes are never IDs or keys
+  ParseResult result = parse(std::string("[\"x\\\",\\\"") + ID_A + "\",\"\\\\\",\"" + ID_B + "\"]");
+  CHECK(result.ok && result.addedSize == 1 && result.skipped == 2);
+
+  DongleTable expected;
+  DongleListParser parser;
+  std::string plain = std::string("[\"") + ID_B + "\"]";
+  parser.feed(plain.data(), plain.size());
+  parser.finish(&expected);
+  CHECK(result.addedHash == expected.hash());
+
+  // \u escapes of '0'/'1' do not make an ID
+  result = parse("[\"\\u0030" + std::string(ID_A).substr(1) + "\"]");
+  CHECK(result.ok && result.addedSize == 0 && result.skipped == 1);
+
+  // An escaped key is unknown: its value is ignored
+  result = parse("{\"vers\\u0069on\":5,\"added\":[]}");
+  CHECK(result.ok && result.version == 0);
+}
+
+static void testOverlongToken() {
+  // Longer than any entry: skipped as a whole, not cut down to a valid ID with
+  // fewer doors; parsing goes on with the next string
+  std::string doors = ":1";
+  while (doors.size() < 300) {
+    doors += ",1";
+  }
+  ParseResult result = parse("[\"" + std::string(ID_A) + doors + "\",\"" + ID_B + "\"]");
+  CHECK(result.ok && result.addedSize == 1 && result.skipped == 1);
+
+  result = parse("[\"" + std::string(5000, '0') + "\",\"" + ID_B + "\"]");
+  CHECK(result.ok && result.addedSize == 1 && result.skipped == 1);
+
+  // An over-long key does not match a known one by its first characters
+  result = parse("{\"version" + std::string(300, 'x') + "\":5,\"added\":[]}");
+  CHECK(result.ok && result.version == 0);
+}
+
+static void testTrailingGarbage() {
+  std::string list = std::string("[\"") + ID_A + "\"]";
+  CHECK(parse(list + " \r\n").ok);
+
+  ParseResult result = parse(list + "x");
+  CHECK(!result.ok && result.status == DongleListParser::INVALID_INPUT);
+  CHECK(!parse(list + "[]").ok);
+  CHECK(!parse(DELTA + "}").ok);
+  CHECK(!parse(DELTA + ",{}").ok);
+
+  // Also when the garbage comes in a later chunk
+  DongleListParser parser;
+  parser.feed(list.data(), list.size());
+  CHECK(!parser.feed("]", 1));
+  DongleTable added;
+  CHECK(!parser.finish(&added) && added.size() == 0);
+}
+
+// Heap in use while text is parsed in network-sized chunks; the largest growth
+// over the start is returned. The list itself is built before measuring.
+static size_t peakHeapWhileParsing(const std::string& text, size_t* entries) {
+  size_t before = mallinfo2().uordblks;
+  size_t peak = 0;
+  DongleListParser parser;
+  for (size_t pos = 0; pos < text.size(); pos += 1460) {
+    parser.feed(text.data() + pos, std::min((size_t)1460, text.size() - pos));
+    peak = std::max(peak, mallinfo2().uordblks - before);
+  }
+  DongleTable table;
+  CHECK(parser.finish(&table));
+  *entries = table.size();
+  return peak;
+}
+
+static void testLongListConstantMemory() {
+  // 10000 entries, once bare and once with 1 KB of skipped text after every ID
+  // (a body over thirty times as long): memory is the ID table, nothing per byte
+  const int count = 10000;
+  std::string bare = "[";
+  std::string padded = "[";
+  std::string filler(1024, 'x');
+  for (int i = 0; i < count; i++) {
+    char id[CharArrayDongleIdSize];
+    formatDongleId((uint32_t)i, id);
+    bare += std::string(i > 0 ? "," : "") + "[\"" + id + "\"]";
+    padded += std::string(i > 0 ? "," : "") + "[\"" + id + "\",\"" + filler + "\"]";
+  }
+  bare += "]";
+  padded += "]";
+
+  size_t bareEntries = 0;
+  size_t paddedEntries = 0;
+  size_t barePeak = peakHeapWhileParsing(bare, &bareEntries);
+  size_t paddedPeak = peakHeapWhileParsing(padded, &paddedEntries);
+  CHECK(bareEntries == count && paddedEntries == count);
+  // The builder's ID array (10000 entries round up to a capacity of 16384) plus allocator slack
+  const size_t idTableBytes = 16384 * sizeof(uint32_t);
+  CHECK(barePeak <= idTableBytes + 4096);
+  CHECK(paddedPeak <= idTableBytes + 4096);
+  printf("%d entries (%zu KB body): %zu KB heap\n", count, padded.size() / 1024, paddedPeak / 1024);
+}
+
+int main() {
+  testChunkBoundaries();
+  testTruncated();
+  testEscapes();
+  testOverlongToken();
+  testTrailingGarbage();
+  testLongListConstantMemory();
+  return checkSummary("dongle_list_parser");
+}
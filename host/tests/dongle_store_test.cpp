@@ -0,0 +1,271 @@
+// Tests for the on-flash dongle table format (DongleStore): layout, A/B slot
+// selection, torn writes, corruption and schedules, against the esp_partition shim.
+
+#include "DongleStore.h"
+#include "check.h"
+#include <stdio.h>
+#include <vector>
+
+static void makeTable(DongleTable* table, std::vector<uint32_t> ids, bool openForAll = false) {
+  DongleTableBuilder builder;
+  for (uint32_t id : ids) {
+    builder.add(id);
+  }
+  if (openForAll) {
+    builder.setOpenForAll();
+  }
+  builder.build(table);
+}
+
+static const DongleStoreHeader* slotHeader(int slot) {
+  const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, DONGLE_PARTITION_LABEL);
+  return reinterpret_cast<const DongleStoreHeader*>(HostFlash::data(DONGLE_PARTITION_LABEL) + slot * (partition->size / 2));
+}
+
+static void testEmptyPartition() {
+  HostFlash::reset();
+  DongleStore store;
+  CHECK(store.begin());
+  DongleTable table;
+  uint32_t version = 123;
+  CHECK(!store.load(&table, &version));
+  CHECK(version == 123);
+  CHECK(store.capacity() == (0x10000 - sizeof(DongleStoreHeader)) / 4);
+}
+
+static void testMissingPartition() {
+  DongleStore store;
+  CHECK(!store.begin("no_such_label"));
+  DongleTable table;
+  makeTable(&table, {1});
+  CHECK(!store.save(table, 1));
+}
+
+static void testLayout() {
+  HostFlash::reset();
+  DongleStore store;
+  store.begin();
+  DongleTable table;
+  makeTable(&table, {30, 10, 20, 10}, true);
+  CHECK(store.save(table, 7));
+
+  // Slot A: little-endian header followed by the sorted, unique IDs
+  const DongleStoreHeader* header = slotHeader(0);
+  const uint8_t* raw = reinterpret_cast<const uint8_t*>(header);
+  CHECK(raw[0] == 'D' && raw[1] == 'N' && raw[2] == 'G' && raw[3] == 'L');
+  CHECK(header->formatVersion == DONGLE_STORE_FORMAT_VERSION);
+  CHECK(header->headerSize == 32);
+  CHECK(header->sequence == 1);
+  CHECK(header->count == 3);
+  CHECK(header->flags == DONGLE_STORE_FLAG_OPEN_FOR_ALL);
+  CHECK(header->listVersion == 7);
+  const uint32_t* ids = reinterpret_cast<const uint32_t*>(raw + 32);
+  CHECK(ids[0] == 10 && ids[1] == 20 && ids[2] == 30);
+  CHECK(header->idsCrc == crc32Update(0, ids, 12));
+  CHECK(header->headerCrc == crc32Update(0, header, 28));
+  CHECK(slotHeader(1)->magic == 0xFFFFFFFF);  // Slot B untouched
+}
+
+static void testZeroCopyLoad() {
+  HostFlash::reset();
+  {
+    DongleStore store;
+    store.begin();
+    DongleTable table;
+    makeTable(&table, {5, 3, 0x3FFFFFF});
+    CHECK(store.save(table, 42));
+  }
+
+  // Fresh boot: the table is a view into the mapped partition
+  DongleStore store;
+  CHECK(store.begin());
+  DongleTable table;
+  uint32_t version = 0;
+  CHECK(store.load(&table, &version));
+  CHECK(version == 42);
+  CHECK(table.size() == 3);
+  CHECK(!table.isOpenForAll());
+  CHECK(table.contains(3) && table.contains(5) && table.contains(0x3FFFFFF) && !table.contains(4));
+  CHECK(reinterpret_cast<const uint8_t*>(table.ids()) == HostFlash::data(DONGLE_PARTITION_LABEL) + 32);
+}
+
+static void testAlternatingSlots() {
+  HostFlash::reset();
+  DongleStore store;
+  store.begin();
+  for (uint32_t round = 1; round <= 5; round++) {
+    DongleTable table;
+    makeTable(&table, {round, round + 100});
+    CHECK(store.save(table, round));
+    CHECK(slotHeader((round - 1) % 2)->sequence == round);
+  }
+
+  DongleStore reboot;
+  reboot.begin();
+  DongleTable table;
+  uint32_t version = 0;
+  CHECK(reboot.load(&table, &version));
+  CHECK(version == 5 && table.contains(5) && table.contains(105) && !table.contains(4));
+}
+
+static void testSaveFromOwnView() {
+  // The published table is a view of the active slot; saving it (e.g. only the
+  // list version changed) must copy it into the other slot intact.
+  HostFlash::reset();
+  DongleStore store;
+  store.begin();
+  std::vector<uint32_t> many;
+  for (uint32_t i = 0; i < 1000; i++) {
+    many.push_back(i * 7919u % 0x3FFFFFF);
+  }
+  DongleTable table;
+  makeTable(&table, many);
+  CHECK(store.save(table, 1));
+
+  DongleTable view;
+  uint32_t version;
+  CHECK(store.load(&view, &version));
+  CHECK(store.save(view, 2));
+  DongleTable reloaded;
+  CHECK(store.load(&reloaded, &version));
+  CHECK(version == 2);
+  CHECK(reloaded.equals(table));
+}
+
+static void testTornWriteKeepsPreviousSlot() {
+  HostFlash::reset();
+  DongleStore store;
+  store.begin();
+  DongleTable first;
+  makeTable(&first, {1, 2, 3});
+  CHECK(store.save(first, 1));
+
+  // Power lost in the middle of the ID payload, and in the middle of the header
+  const long budgets[] = { 6, 12 + 16 };
+  for (long budget : budgets) {
+    DongleTable second;
+    makeTable(&second, {4, 5, 6});
+    HostFlash::failWritesAfter(budget);
+    CHECK(!store.save(second, 2));
+    HostFlash::failWritesAfter(-1);
+
+    DongleStore reboot;
+    reboot.begin();
+    DongleTable table;
+    uint32_t version = 0;
+    CHECK(reboot.load(&table, &version));
+    CHECK(version == 1 && table.equals(first));
+  }
+
+  // The next save after a failed one still goes to the inactive slot
+  DongleTable third;
+  makeTable(&third, {7});
+  CHECK(store.save(third, 3));
+  CHECK(slotHeader(0)->listVersion == 1);
+  CHECK(slotHeader(1)->listVersion == 3);
+}
+
+static void testCorruptionFallsBack() {
+  HostFlash::reset();
+  DongleStore store;
+  store.begin();
+  DongleTable older, newer;
+  makeTable(&older, {1});
+  makeTable(&newer, {2});
+  store.save(older, 1);
+  store.save(newer, 2);
+
+  // Flip a bit in the newer slot's IDs: its CRC no longer matches
+  const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, DONGLE_PARTITION_LABEL);
+  HostFlash::data(DONGLE_PARTITION_LABEL)[partition->size / 2 + 32] ^= 0x01;
+  {
+    DongleStore reboot;
+    reboot.begin();
+    DongleTable table;
+    uint32_t version = 0;
+    CHECK(reboot.load(&table, &version));
+    CHECK(version == 1 && table.contains(1));
+  }
+
+  // Corrupt the older header too: nothing valid is left
+  HostFlash::data(DONGLE_PARTITION_LABEL)[8] ^= 0x01;
+  DongleStore reboot;
+  reboot.begin();
+  DongleTable table;
+  uint32_t version = 0;
+  CHECK(!reboot.load(&table, &version));
+}
+
+static void testSchedules() {
+  // Restricted entries: version 2 slot with schedule indices and schedules after the IDs
+  HostFlash::reset();
+  DongleStore store;
+  store.begin();
+  AccessSchedule weekdays, expiring;
+  CHECK(compileAccessSchedule("1-5/7-19", nullptr, &weekdays));
+  CHECK(compileAccessSchedule(nullptr, "2030-01-01", &expiring));
+  DongleTableBuilder builder;
+  builder.add(30, &weekdays);
+  builder.add(10);
+  builder.add(20, &expiring);
+  builder.add(40, &weekdays);
+  builder.add(50);
+  DongleTable table;
+  builder.build(&table);
+  CHECK(store.save(table, 9));
+
+  const DongleStoreHeader* header = slotHeader(0);
+  CHECK(header->formatVersion == DONGLE_STORE_FORMAT_VERSION_SCHEDULES);
+  CHECK(header->count == 5 && header->scheduleCount == 2);
+  const uint8_t* raw = reinterpret_cast<const uint8_t*>(header);
+  const uint8_t* scheduleOf = raw + 32 + 5 * 4;
+  CHECK(scheduleOf[0] == 0 && scheduleOf[1] != 0 && scheduleOf[2] != 0 && scheduleOf[4] == 0);
+  CHECK(scheduleOf[5] == 0 && scheduleOf[6] == 0 && scheduleOf[7] == 0);  // Padding
+  CHECK(header->idsCrc == crc32Update(0, raw + 32, 5 * 4 + 8 + 2 * sizeof(AccessSchedule)));
+
+  DongleStore reboot;
+  reboot.begin();
+  DongleTable loaded;
+  uint32_t version = 0;
+  CHECK(reboot.load(&loaded, &version));
+  CHECK(version == 9 && loaded.equals(table) && loaded.hash() == table.hash());
+  CHECK(loaded.scheduleIndices() == scheduleOf);  // Zero-copy as well
+  CHECK(sameAccessSchedule(*loaded.scheduleAt(2), weekdays) && loaded.scheduleAt(0) == nullptr);
+
+  // Saving the view again, then a plain table: back to version 1
+  CHECK(reboot.save(loaded, 10));
+  CHECK(slotHeader(1)->formatVersion == DONGLE_STORE_FORMAT_VERSION_SCHEDULES);
+  DongleTable plain;
+  makeTable(&plain, {1, 2});
+  CHECK(reboot.save(plain, 11));
+  CHECK(slotHeader(0)->formatVersion == DONGLE_STORE_FORMAT_VERSION && slotHeader(0)->scheduleCount == 0);
+}
+
+static void testTooLarge() {
+  HostFlash::reset();
+  DongleStore store;
+  store.begin();
+  DongleTableBuilder builder;
+  for (uint32_t i = 0; i <= store.capacity(); i++) {
+    builder.add(i);
+  }
+  DongleTable table;
+  builder.build(&table);
+  CHECK(!store.save(table, 1));
+  CHECK(HostFlash::eraseCount() == 0);
+}
+
+int main() {
+  testEmptyPartition();
+  testMissingPartition();
+  testLayout();
+  testZeroCopyLoad();
+  testAlternatingSlots();
+  testSaveFromOwnView();
+  testTornWriteKeepsPreviousSlot();
+  testCorruptionFallsBack();
+  testSchedules();
+  testTooLarge();
+
+  return checkSummary("dongle_store");
+}
@@ -0,0 +1,393 @@
+// Tests for per-door and time-restricted dongle table entries: the
+// ":doors", "@windows" and "!expiry" suffixes of the dongle list, schedule
+// compilation, merging duplicates, lookups and delta replacement; and
+// PublishedDongleTable with readers running while tables are replaced.
+
+#include "DongleListParser.h"
+#include "check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+
+static const char ID_A[] = "00000000000000000000000011";  // 3
+static const char ID_B[] = "00000000000000000000000101";  // 5
+static const char ID_ALL_ONES[] = "11111111111111111111111111";
+static const time_t NOW = 1700000000;  // Tue 14.11.2023 22:13:20 UTC (TZ is set to UTC in main)
+
+static std::string entry(const char* id, const char* doors = nullptr) {
+  return doors == nullptr ? std::string(id) : std::string(id) + ":" + doors;
+}
+
+static bool hourSet(const AccessSchedule& schedule, int day, int hour) {
+  int h = day * 24 + hour;
+  return (schedule.hours[h >> 3] >> (h & 7)) & 1;
+}
+
+static bool parse(const std::string& json, DongleTable* added, DongleTable* removed = nullptr,
+                  size_t* skipped = nullptr) {
+  DongleListParser parser;
+  parser.feed(json.data(), json.size());
+  if (skipped != nullptr) {
+    *skipped = parser.skippedCount();
+  }
+  return parser.finish(added, removed);
+}
+
+static void testDoorSuffix() {
+  std::string json = "[[\"" + entry(ID_A, "1,3") + "\"],[\"" + entry(ID_B) + "\"],[\"" + entry(ID_ALL_ONES, "2") + "\"]]";
+  DongleTable table;
+  CHECK(parse(json, &table));
+  CHECK(table.size() == 3);
+  CHECK(table.ids()[0] == makeDongleEntry(3, 0x05));
+  CHECK(table.allows(3, 0, NOW) && !table.allows(3, 1, NOW) && table.allows(3, 2, NOW));
+  CHECK(table.allows(5, 0, NOW) && table.allows(5, 5, NOW));  // No suffix: every door
+  CHECK(!table.allows(0x3FFFFFF, 0, NOW) && table.allows(0x3FFFFFF, 1, NOW));
+  CHECK(table.contains(3) && table.contains(0x3FFFFFF) && !table.contains(4));
+  CHECK(!table.allows(4, 0, NOW));
+}
+
+static void testInvalidDoors() {
+  size_t skipped = 0;
+  std::string json = "[\"" + entry(ID_A, "9") + "\",\"" + entry(ID_B, "x") + "\",\"" + entry(ID_A, "") + "\",\"" +
+                     entry(ID_B, "2,7") + "\"]";
+  DongleTable table;
+  CHECK(parse(json, &table, nullptr, &skipped));
+  CHECK(skipped == 3);  // Only unknown doors, not a number, empty list: never "every door"
+  CHECK(table.size() == 1 && table.allows(5, 1, NOW) && !table.allows(5, 0, NOW));
+
+  // All MAX_DOORS listed is the same as no suffix
+  CHECK(parse("[\"" + entry(ID_ALL_ONES, "1,2,3,4,5,6") + "\"]", &table));
+  CHECK(table.size() == 1 && table.ids()[0] == 0x3FFFFFF && table.allows(0x3FFFFFF, 4, NOW));
+}
+
+static void testMergeDuplicates() {
+  std::string json = "[\"" + entry(ID_A, "1") + "\",\"" + entry(ID_A, "3") + "\",\"" + entry(ID_B, "2") + "\",\"" +
+                     entry(ID_B) + "\"]";
+  DongleTable table;
+  CHECK(parse(json, &table));
+  CHECK(table.size() == 2);
+  CHECK(table.ids()[0] == makeDongleEntry(3, 0x05));
+  CHECK(table.ids()[1] == makeDongleEntry(5, 0));  // Every door wins
+}
+
+static void testDeltaReplacesEntry() {
+  DongleTable base;
+  CHECK(parse("[\"" + entry(ID_A, "1") + "\",\"" + entry(ID_B) + "\"]", &base));
+
+  // Door change of ID_A: old entry removed, new one added; ID_B removed
+  std::string delta = "{\"version\":2,\"hash\":0,\"reset\":false,\"added\":[\"" + entry(ID_A, "2") +
+                      "\"],\"removed\":[\"" + entry(ID_A, "1") + "\",\"" + entry(ID_B) + "\"]}";
+  DongleTable added, removed;
+  CHECK(parse(delta, &added, &removed));
+  DongleTable merged;
+  CHECK(merged.assignDelta(base, added, removed));
+  CHECK(merged.size() == 1);
+  CHECK(!merged.allows(3, 0, NOW) && merged.allows(3, 1, NOW));
+  CHECK(!merged.contains(5));
+
+  // Removal order does not matter: the same delta against a table without ID_A
+  DongleTable onlyB;
+  CHECK(parse("[\"" + entry(ID_B) + "\"]", &onlyB));
+  CHECK(merged.assignDelta(onlyB, added, removed));
+  CHECK(merged.size() == 1 && merged.allows(3, 1, NOW));
+}
+
+static void testHashCoversDoors() {
+  DongleTable oneDoor, twoDoors;
+  CHECK(parse("[\"" + entry(ID_A, "1") + "\"]", &oneDoor));
+  CHECK(parse("[\"" + entry(ID_A, "1,2") + "\"]", &twoDoors));
+  CHECK(oneDoor.hash() != twoDoors.hash());
+  CHECK(!oneDoor.equals(twoDoors));
+
+  // googleScript: CRC-32 over the little-endian entry words
+  uint32_t word = makeDongleEntry(3, 0x01);
+  CHECK(oneDoor.hash() == crc32Update(0, &word, sizeof(word)));
+}
+
+static void testCompileWindows() {
+  AccessSchedule schedule;
+  CHECK(compileAccessSchedule("1-5/7-19;6/9-13", nullptr, &schedule));
+  CHECK(hourSet(schedule, 0, 7) && hourSet(schedule, 0, 18) && hourSet(schedule, 4, 12));
+  CHECK(!hourSet(schedule, 0, 6) && !hourSet(schedule, 0, 19) && !hourSet(schedule, 6, 12));
+  CHECK(hourSet(schedule, 5, 9) && hourSet(schedule, 5, 12) && !hourSet(schedule, 5, 13));
+  CHECK(schedule.expiresDay == ACCESS_NO_EXPIRY && schedule.reserved == 0);
+
+  // Past midnight, and day ranges wrapping over the weekend
+  CHECK(compileAccessSchedule("6-1/22-6", nullptr, &schedule));
+  CHECK(hourSet(schedule, 5, 22) && hourSet(schedule, 6, 3) && hourSet(schedule, 6, 23));
+  CHECK(hourSet(schedule, 0, 23) && hourSet(schedule, 1, 5) && !hourSet(schedule, 1, 6));
+  CHECK(!hourSet(schedule, 4, 23) && !hourSet(schedule, 5, 21));
+  CHECK(compileAccessSchedule("7/20-2", nullptr, &schedule));
+  CHECK(hourSet(schedule, 6, 23) && hourSet(schedule, 0, 1) && !hourSet(schedule, 0, 2));
+  CHECK(compileAccessSchedule("3/0-24", nullptr, &schedule));
+  CHECK(hourSet(schedule, 2, 0) && hourSet(schedule, 2, 23) && !hourSet(schedule, 3, 0));
+
+  // Expiry only: every hour until the end of the day
+  CHECK(compileAccessSchedule(nullptr, "2023-11-14", &schedule));
+  CHECK(schedule.expiresDay == 19675 && hourSet(schedule, 6, 23));
+
+  const char* invalid[] = { "", "8/1-2", "0/1-2", "1/7", "1-5/7-25", "1/24-2", "1/7-19;", "1/7-19 ", "Mo/7-19" };
+  for (const char* windows : invalid) {
+    CHECK(!compileAccessSchedule(windows, nullptr, &schedule));
+  }
+  const char* invalidDates[] = { "2023-13-01", "2023-11-00", "23-11", "2023-11-14x", "1970-01-01", "2200-01-01" };
+  for (const char* expiry : invalidDates) {
+    CHECK(!compileAccessSchedule(nullptr, expiry, &schedule));
+  }
+}
+
+static void testScheduledLookup() {
+  // NOW is Tuesday 22:13 UTC
+  std::string json = "[\"" + entry(ID_A, "1") + "@2/22-23\",\"" + std::string(ID_B) + "!2023-11-14\"]";
+  DongleTable table;
+  CHECK(parse(json, &table));
+  CHECK(table.scheduleCount() == 2);
+  CHECK(table.allows(3, 0, NOW) && !table.allows(3, 1, NOW));
+  CHECK(!table.allows(3, 0, NOW + 3600) && !table.allows(3, 0, NOW - 3600));
+  CHECK(table.allows(5, 3, NOW) && !table.allows(5, 3, NOW + 2 * 3600));  // Expired at midnight
+  CHECK(!table.allows(3, 0, 0) && !table.allows(5, 0, 0));                // Clock not set: denied
+
+  AccessTime at = accessTimeAt(NOW);
+  CHECK(at.valid && at.day == 19675 && at.hourOfWeek == 24 + 22);
+
+  // A malformed schedule drops the entry instead of granting every hour
+  size_t skipped = 0;
+  CHECK(parse("[\"" + std::string(ID_A) + "@2/22\",\"" + std::string(ID_B) + "!tomorrow\"]", &table, nullptr, &skipped));
+  CHECK(table.size() == 0 && skipped == 2);
+}
+
+static void testScheduleSharingAndMerge() {
+  std::string json = "[\"" + std::string(ID_A) + "@1-5/7-19\",\"" + std::string(ID_B) + "@1-5/7-19\",\"" +
+                     std::string(ID_ALL_ONES) + "\"]";
+  DongleTable table;
+  CHECK(parse(json, &table));
+  CHECK(table.size() == 3 && table.scheduleCount() == 1);
+  CHECK(table.scheduleAt(0) == table.scheduleAt(1) && table.scheduleAt(2) == nullptr);
+
+  // Duplicate IDs: an unrestricted entry wins, as for doors
+  CHECK(parse("[\"" + std::string(ID_A) + "@1/7-8\",\"" + std::string(ID_A) + "\"]", &table));
+  CHECK(table.size() == 1 && table.scheduleAt(0) == nullptr);
+
+  // Both restricted: the union of their hours and the later expiry, like the
+  // merged entry googleScript sends for several rows of one ID
+  CHECK(parse("[\"" + std::string(ID_A) + "@2/9-10!2031-01-01\",\"" + std::string(ID_A) + "@1/7-8!2030-01-01\",\"" +
+              std::string(ID_B) + "@2/9-10\"]", &table));
+  DongleTable merged;
+  CHECK(parse("[\"" + std::string(ID_A) + "@1/7-8;2/9-10!2031-01-01\",\"" + std::string(ID_B) + "@2/9-10\"]", &merged));
+  CHECK(table.size() == 2 && table.equals(merged) && table.hash() == merged.hash());
+  const time_t mondayAt7 = NOW - (24 + 15) * 3600 - 13 * 60 - 20;
+  const time_t tuesdayAt9 = NOW - 13 * 3600 - 13 * 60 - 20;
+  CHECK(table.allows(3, 0, mondayAt7) && table.allows(3, 0, tuesdayAt9) && !table.allows(3, 0, tuesdayAt9 + 3600));
+  CHECK(table.scheduleAt(0)->expiresDay == merged.scheduleAt(0)->expiresDay);
+
+  // No expiry wins, in either order
+  CHECK(parse("[\"" + std::string(ID_A) + "@1/7-8!2030-01-01\",\"" + std::string(ID_A) + "@2/9-10\"]", &table));
+  CHECK(table.size() == 1 && table.scheduleAt(0)->expiresDay == ACCESS_NO_EXPIRY);
+  CHECK(hourSet(*table.scheduleAt(0), 0, 7) && hourSet(*table.scheduleAt(0), 1, 9) && !hourSet(*table.scheduleAt(0), 1, 7));
+}
+
+static void testScheduledDelta() {
+  DongleTable base;
+  CHECK(parse("[\"" + std::string(ID_A) + "@1/7-8\",\"" + std::string(ID_B) + "\",\"" + std::string(ID_ALL_ONES) +
+              "@2/22-23\"]", &base));
+
+  // New hours for ID_A; ID_B gets an expiry; ID_ALL_ONES untouched
+  std::string delta = "{\"version\":3,\"hash\":0,\"reset\":false,\"added\":[\"" + std::string(ID_A) + "@2/22-23\",\"" +
+                      std::string(ID_B) + "!2030-01-01\"],\"removed\":[\"" + std::string(ID_A) + "@1/7-8\",\"" +
+                      std::string(ID_B) + "\"]}";
+  DongleTable added, removed;
+  CHECK(parse(delta, &added, &removed));
+  DongleTable merged;
+  CHECK(merged.assignDelta(base, added, removed));
+  CHECK(merged.size() == 3);
+  CHECK(merged.scheduleCount() == 2);  // "2/22-23" shared by ID_A and ID_ALL_ONES
+  CHECK(merged.allows(3, 0, NOW) && merged.allows(5, 0, NOW) && merged.allows(0x3FFFFFF, 0, NOW));
+  CHECK(!merged.allows(3, 0, NOW + 3600));
+
+  // Same content as the full list of the new version
+  DongleTable full;
+  CHECK(parse("[\"" + std::string(ID_A) + "@2/22-23\",\"" + std::string(ID_B) + "!2030-01-01\",\"" +
+              std::string(ID_ALL_ONES) + "@2/22-23\"]", &full));
+  CHECK(merged.equals(full) && merged.hash() == full.hash());
+  CHECK(!merged.equals(base) && merged.hash() != base.hash());
+
+  // Dropping the schedules leaves a plain table again
+  DongleTable plain;
+  CHECK(parse("[\"" + std::string(ID_A) + "\",\"" + std::string(ID_B) + "\",\"" + std::string(ID_ALL_ONES) + "\"]", &plain));
+  DongleTable noRemovals;
+  CHECK(merged.assignDelta(merged, plain, noRemovals));
+  CHECK(merged.scheduleCount() == 0 && merged.scheduleIndices() == nullptr && merged.equals(plain));
+}
+
+static void testScheduleHash() {
+  // googleScript: after the entry words, entry word + 24 schedule bytes of every restricted entry
+  DongleTable table;
+  CHECK(parse("[\"" + std::string(ID_A) + "\",\"" + std::string(ID_B) + ":2@1/7-8!2030-01-01\"]", &table));
+  AccessSchedule schedule;
+  CHECK(compileAccessSchedule("1/7-8", "2030-01-01", &schedule));
+  uint32_t words[2] = { 3, makeDongleEntry(5, 0x02) };
+  uint32_t crc = crc32Update(0, words, sizeof(words));
+  crc = crc32Update(crc, &words[1], sizeof(uint32_t));
+  crc = crc32Update(crc, &schedule, sizeof(schedule));
+  CHECK(table.hash() == crc);
+}
+
+static void testWindowsTextLimit() {
+  // The longest entry googleScript sends: every door, ACCESS_WINDOWS_TEXT_MAX of windows, an expiry
+  std::string windows = "1/0-10";
+  for (int i = 0; i < 8; i++) {
+    windows += ";2/1" + std::to_string(i) + "-1" + std::to_string(i + 1);
+  }
+  windows += ";3-4/10-11";
+  CHECK(windows.size() == ACCESS_WINDOWS_TEXT_MAX);
+  std::string longest = entry(ID_B, "1,2,3,4,5,6") + "@" + windows + "!2030-01-01";
+  AccessSchedule schedule;
+  CHECK(compileAccessSchedule(windows.c_str(), "2030-01-01", &schedule));
+  uint32_t words[2] = { 3, 5 };
+  uint32_t crc = crc32Update(0, words, sizeof(words));
+  crc = crc32Update(crc, &words[1], sizeof(uint32_t));
+  uint32_t scriptHash = crc32Update(crc, &schedule, sizeof(schedule));
+
+  DongleTable table;
+  size_t skipped = 0;
+  CHECK(parse("[\"" + std::string(ID_A) + "\",\"" + longest + "\"]", &table, nullptr, &skipped));
+  CHECK(skipped == 0 && table.size() == 2 && table.hash() == scriptHash);
+
+  // Nine windows are over the limit: the parser skips the entry, so the table can
+  // never match a hash that includes it (googleScript drops such rows instead)
+  std::string nineWindows = "1-5/10-19";
+  for (int i = 0; i < 8; i++) {
+    nineWindows += ";1-5/10-19";
+  }
+  std::string tooLong = entry(ID_B, "1,2,3,4,5,6") + "@" + nineWindows + "!2030-01-01";
+  CHECK(compileAccessSchedule(nineWindows.c_str(), "2030-01-01", &schedule));
+  scriptHash = crc32Update(crc, &schedule, sizeof(schedule));
+  CHECK(parse("[\"" + std::string(ID_A) + "\",\"" + tooLong + "\"]", &table, nullptr, &skipped));
+  CHECK(skipped == 1 && table.size() == 1 && table.hash() != scriptHash);
+}
+
+// Generation g of a published table: entries (g << 8) + i for i < 1 + g % 200, so
+// a reader can tell from the first entry which size and contents it must find
+static size_t generationSize(uint32_t generation) {
+  return 1 + generation % 200;
+}
+
+static bool isWholeGeneration(const DongleTable& table) {
+  if (table.size() == 0) {
+    return false;
+  }
+  uint32_t generation = table.ids()[0] >> 8;
+  if (table.size() != generationSize(generation)) {
+    return false;
+  }
+  for (size_t i = 0; i < table.size(); i++) {
+    if (table.ids()[i] != (generation << 8) + i) {
+      return false;
+    }
+  }
+  return table.contains((generation << 8) + table.size() - 1);
+}
+
+// Publish generation g; the retired table is overwritten before it is freed,
+// so a reader still using it would see a torn table
+static void publishGeneration(PublishedDongleTable& published, uint32_t generation) {
+  size_t count = generationSize(generation);
+  uint32_t* ids = new uint32_t[count];
+  for (size_t i = 0; i < count; i++) {
+    ids[i] = (generation << 8) + i;
+  }
+  DongleTable table;
+  table.adopt(ids, count, false);
+  published.publish(table);
+  if (table.size() > 0) {
+    memset(const_cast<uint32_t*>(table.ids()), 0xA5, table.size() * sizeof(uint32_t));
+  }
+}
+
+static void testConcurrentReaders() {
+  // Two readers pin and look up in a loop (and check again before unpinning)
+  // while the writer publishes and reclaims one generation after the other
+  PublishedDongleTable published;
+  publishGeneration(published, 1);
+  std::atomic<bool> done{false};
+  std::atomic<uint32_t> reads{0};
+  std::atomic<uint32_t> torn{0};
+  auto reader = [&]() {
+    while (!done.load()) {
+      PublishedDongleTable::Reader table(published);
+      bool whole = isWholeGeneration(*table);
+      std::this_thread::yield();
+      if (!whole || !isWholeGeneration(*table)) {
+        torn++;
+      }
+      reads++;
+    }
+  };
+  std::thread first(reader);
+  std::thread second(reader);
+  for (uint32_t generation = 2; generation <= 1000; generation++) {
+    // Every 100 generations the readers catch up: reads always overlap the
+    // publishes, even when the threads are scheduled late
+    if (generation % 100 == 0) {
+      uint32_t readsBefore = reads.load();
+      while (reads.load() < readsBefore + 2) {
+        std::this_thread::yield();
+      }
+    }
+    publishGeneration(published, generation);
+  }
+  done = true;
+  first.join();
+  second.join();
+  CHECK(torn == 0);
+
+  PublishedDongleTable::Reader table(published);
+  CHECK(table->size() == generationSize(1000) && table->ids()[0] == 1000u << 8);
+}
+
+static void testPublishWaitsForPinnedReader() {
+  PublishedDongleTable published;
+  publishGeneration(published, 1);
+  std::atomic<int> publishes{0};
+  std::thread writer;
+  {
+    PublishedDongleTable::Reader pinned(published);
+    writer = std::thread([&]() {
+      publishGeneration(published, 2);
+      publishes++;
+      publishGeneration(published, 3);
+      publishes++;
+    });
+    vTaskDelay(50);
+
+    // The new table is visible at once, the pinned one is neither reclaimed nor reused
+    PublishedDongleTable::Reader latest(published);
+    CHECK(latest->ids()[0] == 2u << 8);
+    CHECK(publishes == 0);
+    CHECK(pinned->ids()[0] == 1u << 8 && isWholeGeneration(*pinned));
+  }
+  writer.join();
+  CHECK(publishes == 2);
+  PublishedDongleTable::Reader table(published);
+  CHECK(table->ids()[0] == 3u << 8 && isWholeGeneration(*table));
+}
+
+int main() {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+  testDoorSuffix();
+  testInvalidDoors();
+  testMergeDuplicates();
+  testDeltaReplacesEntry();
+  testHashCoversDoors();
+  testCompileWindows();
+  testScheduledLookup();
+  testScheduleSharingAndMerge();
+  testScheduledDelta();
+  testScheduleHash();
+  testWindowsTextLimit();
+  testConcurrentReaders();
+  testPublishWaitsForPinnedReader();
+  return checkSummary("dongle_table");
+}
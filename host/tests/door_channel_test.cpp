@@ -0,0 +1,215 @@
+// Tests for DoorChannel against the timer and GPIO shims: door contact
+// debouncing, stalled Wiegand frames, and two doors (built with
+// HOST_TEST_SECOND_DOOR) that share the MAIN_NOTIFY_* bits, so every door
+// sees the other door's wake-ups and must only act on its own.
+
+#include "NetworkTask.cpp"  // Unity include: reaches logEventRing and networkTaskHandle
+#include "DoorChannel.h"
+#include "WiegandFormat.h"
+#include "check.h"
+#include <stdio.h>
+#include <vector>
+
+static_assert(DOOR_COUNT == 2, "build with HOST_TEST_SECOND_DOOR");
+
+static DoorChannel doors[DOOR_COUNT];
+static const uint32_t GRANTED_FRAME = DoorReaderFormat::encode(0x0253B1);
+
+// Hand notification bits to every door, as loop() in RFID_null7b.ino does
+static void dispatch(uint32_t notifications) {
+  for (DoorChannel& door : doors) {
+    if (notifications & MAIN_NOTIFY_RELAY_TIMER) {
+      door.onRelayTimer();
+    }
+    if (notifications & MAIN_NOTIFY_BUZZER_TIMER) {
+      door.onBuzzerTimer();
+    }
+  }
+  for (DoorChannel& door : doors) {
+    if (notifications & MAIN_NOTIFY_WIEGAND_FRAME) {
+      door.handleWiegandFrames();
+    }
+    if (notifications & MAIN_NOTIFY_WIEGAND_TIMEOUT) {
+      door.resetStalledWiegandFrame();
+    }
+    if (notifications & MAIN_NOTIFY_DOOR_SETTLED) {
+      door.trackDoorStateChange();
+    }
+  }
+}
+
+// Wait up to timeoutMs for a wake-up; returns its bits (0 = timed out)
+static uint32_t waitForNotifications(unsigned long timeoutMs) {
+  uint32_t notifications = 0;
+  if (xTaskNotifyWait(0, UINT32_MAX, &notifications, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+    return 0;
+  }
+  return notifications;
+}
+
+// One pass of loop(): wait up to timeoutMs and dispatch; returns the bits (0 = timed out)
+static uint32_t dispatchOnce(unsigned long timeoutMs) {
+  uint32_t notifications = waitForNotifications(timeoutMs);
+  dispatch(notifications);
+  return notifications;
+}
+
+// Run loop() passes until one brings bit (true) or timeoutMs pass without it.
+// With held, the bits of that pass are handed back instead of dispatched.
+static bool dispatchUntil(uint32_t bit, unsigned long timeoutMs, uint32_t* held = nullptr) {
+  unsigned long start = millis();
+  while (millis() - start < timeoutMs) {
+    uint32_t notifications = waitForNotifications(timeoutMs - (millis() - start));
+    if (held != nullptr && (notifications & bit)) {
+      *held = notifications;
+      return true;
+    }
+    dispatch(notifications);
+    if (notifications & bit) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Run loop() passes until nothing happens for idleMs
+static void dispatchUntilIdle(unsigned long idleMs) {
+  while (dispatchOnce(idleMs) != 0) {
+  }
+}
+
+// Take the logged events out of the queue
+static std::vector<LogEvent> takeLogEvents() {
+  std::vector<LogEvent> taken;
+  const LogEvent* events;
+  while (uint32_t count = logEventRing.peek(&events)) {
+    taken.insert(taken.end(), events, events + count);
+    logEventRing.release(count);
+  }
+  return taken;
+}
+
+// Wiegand pulses of frame bits [from, to) (MSB first) on door 0's reader
+static void sendBits(uint32_t frameBits, int from, int to) {
+  for (int i = from; i < to; i++) {
+    int bit = DoorReaderFormat::BITS - 1 - i;
+    uint8_t pin = ((frameBits >> bit) & 1) ? DOORS[0].data1Pin : DOORS[0].data0Pin;
+    HostGpio::setLevel(pin, LOW);
+    HostGpio::setLevel(pin, HIGH);
+  }
+}
+
+static bool scanLogged(const std::vector<LogEvent>& events, LogEventType type, uint32_t dongleId) {
+  for (const LogEvent& event : events) {
+    if (event.type == type && event.dongleId == dongleId && event.door == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void setUp() {
+  uint32_t* ids = new uint32_t[1];
+  ids[0] = GRANTED_FRAME;
+  DongleTable table;
+  table.adopt(ids, 1, false);
+  ramDongleTable.publish(table);
+
+  // Stand in for the network task: enqueueLogEvent() only queues once it exists
+  networkTaskHandle = xTaskGetCurrentTaskHandle();
+  for (uint8_t door = 0; door < DOOR_COUNT; door++) {
+    HostGpio::setLevel(DOORS[door].contactPin, DOOR_IS_CLOSED);
+    doors[door].begin(door, xTaskGetCurrentTaskHandle());
+    doors[door].trackDoorStateChange();
+  }
+  dispatchUntilIdle(20);
+  std::vector<LogEvent> events = takeLogEvents();
+  CHECK(events.size() == 2 && events[0].type == LOG_EVENT_DOOR_CLOSED && events[1].type == LOG_EVENT_DOOR_CLOSED);
+}
+
+static void testBounceLogsOnce() {
+  // Edges a few ms apart, ending in the new state: one change once the contact is stable
+  for (int edge = 0; edge < 7; edge++) {
+    HostGpio::setLevel(DOORS[0].contactPin, edge % 2 == 0 ? DOOR_IS_OPEN : DOOR_IS_CLOSED);
+    delay(DOOR_DEBOUNCE_MS / 10);
+  }
+  dispatchUntilIdle(2 * DOOR_DEBOUNCE_MS);
+  std::vector<LogEvent> events = takeLogEvents();
+  CHECK(events.size() == 1 && events[0].type == LOG_EVENT_DOOR_OPEN && events[0].door == 0);
+
+  // Bouncing back to where it was: nothing changed, nothing logged
+  HostGpio::setLevel(DOORS[0].contactPin, DOOR_IS_CLOSED);
+  HostGpio::setLevel(DOORS[0].contactPin, DOOR_IS_OPEN);
+  dispatchUntilIdle(2 * DOOR_DEBOUNCE_MS);
+  CHECK(takeLogEvents().empty());
+
+  HostGpio::setLevel(DOORS[0].contactPin, DOOR_IS_CLOSED);
+  dispatchUntilIdle(2 * DOOR_DEBOUNCE_MS);
+  events = takeLogEvents();
+  CHECK(events.size() == 1 && events[0].type == LOG_EVENT_DOOR_CLOSED);
+}
+
+static void testStalledFrameCleared() {
+  // Half a frame, then nothing: dropped after WIEGAND_TIMEOUT_MS, so the next
+  // scan starts on a clean frame instead of completing the stale one
+  sendBits(GRANTED_FRAME, 0, 10);
+  dispatchUntilIdle(WIEGAND_TIMEOUT_MS + 50);
+  sendBits(GRANTED_FRAME, 0, DoorReaderFormat::BITS);
+  dispatchUntilIdle(20);
+  std::vector<LogEvent> events = takeLogEvents();
+  CHECK(events.size() == 1 && scanLogged(events, LOG_EVENT_AUTHORISED, GRANTED_FRAME));
+}
+
+static void testLateBitRearmsTimer() {
+  // The timeout has fired, but a bit arrives before loop() handles it: the frame is
+  // still being received and completes with the rest of its bits
+  sendBits(GRANTED_FRAME, 0, 13);
+  uint32_t notifications = 0;
+  CHECK(dispatchUntil(MAIN_NOTIFY_WIEGAND_TIMEOUT, 2 * WIEGAND_TIMEOUT_MS, &notifications));
+  sendBits(GRANTED_FRAME, 13, 14);
+  dispatch(notifications);
+  sendBits(GRANTED_FRAME, 14, DoorReaderFormat::BITS);
+  dispatchUntilIdle(20);
+  std::vector<LogEvent> events = takeLogEvents();
+  CHECK(events.size() == 1 && scanLogged(events, LOG_EVENT_AUTHORISED, GRANTED_FRAME));
+
+  // Same, but the frame then stalls: the timer is armed again and drops it
+  sendBits(GRANTED_FRAME, 0, 13);
+  CHECK(dispatchUntil(MAIN_NOTIFY_WIEGAND_TIMEOUT, 2 * WIEGAND_TIMEOUT_MS, &notifications));
+  sendBits(GRANTED_FRAME, 13, 14);
+  dispatch(notifications);
+  CHECK(dispatchUntil(MAIN_NOTIFY_WIEGAND_TIMEOUT, 2 * WIEGAND_TIMEOUT_MS));
+  sendBits(GRANTED_FRAME, 0, DoorReaderFormat::BITS);
+  dispatchUntilIdle(20);
+  events = takeLogEvents();
+  CHECK(events.size() == 1 && scanLogged(events, LOG_EVENT_AUTHORISED, GRANTED_FRAME));
+}
+
+static void testOtherDoorBouncing() {
+  // Door 0 opens once; door 1's contact bounces (ending open) until door 0's
+  // timer has fired. Door 1 is then back closed: neither its bounce nor its
+  // state at the moment of door 0's wake-up may be logged.
+  HostGpio::setLevel(DOORS[0].contactPin, DOOR_IS_OPEN);
+  uint32_t notifications = 0;
+  while (!(notifications & MAIN_NOTIFY_DOOR_SETTLED)) {
+    HostGpio::setLevel(DOORS[1].contactPin, DOOR_IS_OPEN);
+    HostGpio::setLevel(DOORS[1].contactPin, DOOR_IS_CLOSED);
+    HostGpio::setLevel(DOORS[1].contactPin, DOOR_IS_OPEN);
+    notifications = dispatchOnce(10);
+  }
+  HostGpio::setLevel(DOORS[1].contactPin, DOOR_IS_CLOSED);
+  dispatchUntilIdle(2 * DOOR_DEBOUNCE_MS);
+
+  std::vector<LogEvent> events = takeLogEvents();
+  CHECK(events.size() == 1);
+  CHECK(events.size() >= 1 && events[0].type == LOG_EVENT_DOOR_OPEN && events[0].door == 0);
+}
+
+int main() {
+  setUp();
+  testBounceLogsOnce();
+  testStalledFrameCleared();
+  testLateBitRearmsTimer();
+  testOtherDoorBouncing();
+  return checkSummary("door_channel");
+}
@@ -0,0 +1,261 @@
+// Tests for the dongle list googleScript builds for the firmware, run under
+// Node.js: every entry must fit the firmware parser's limits, or the device
+// skips it and its hash never matches the script's (DongleListParser.h).
+// Also the read_pa_delta netting, and the cache of the dongle sheet: a list
+// and the hash sent with it always come from the same read.
+//
+//   node host/tests/google_script_test.js googleScript
+
+'use strict';
+const crypto = require('crypto');
+const fs = require('fs');
+const vm = require('vm');
+
+let failures = 0;
+
+function check(cond, what) {
+  if (!cond) {
+    console.log('CHECK failed: ' + what);
+    failures++;
+  }
+}
+
+// The Apps Script services are only used by the request handlers, not by the list building
+const script = vm.createContext({ Utilities: {}, Session: {} });
+vm.runInContext(fs.readFileSync(process.argv[2] || 'googleScript', 'utf8'), script);
+const formatScheduleWindows = script.formatScheduleWindows_;
+const compileSchedule = script.compileSchedule_;
+const readDongleList = script.readDongleList_;
+const dongleListHash = script.dongleListHash_;
+const buildDongleDelta = script.buildDongleDelta_;
+
+// As in the firmware: ACCESS_WINDOWS_TEXT_MAX and DongleListParser::MAX_ENTRY_TOKEN
+const WINDOWS_TEXT_MAX = 80;
+const ENTRY_TOKEN_MAX = 26 + 2 * 6 + 1 + WINDOWS_TEXT_MAX + 1 + 10;
+
+const ID_A = '00000000000000000000000011';
+const ID_B = '00000000000000000000000101';
+
+function row(id, doors, windows, expiry) {
+  return ['Name', '', id, '', '', doors || '', windows || '', expiry || ''];
+}
+
+function windowsOf(entry) {
+  const match = /@([^!]*)/.exec(entry);
+  return match ? match[1] : null;
+}
+
+// What the firmware accepts of an entry (the hash is then computed over the rest)
+function firmwareAccepts(entry) {
+  return entry.length <= ENTRY_TOKEN_MAX;
+}
+
+function sameBytes(a, b) {
+  return a !== null && b !== null && a.length == b.length && a.every(function(value, i) { return value === b[i]; });
+}
+
+function testFormatRoundTrip() {
+  check(formatScheduleWindows(compileSchedule('1-5/7-19;6/9-13', null)) === '1-5/7-19;6/9-13', 'weekdays and Saturday');
+  check(formatScheduleWindows(compileSchedule('1-7/22-6', null)) === '1-7/22-6', 'every night');
+  check(formatScheduleWindows(compileSchedule('6-1/22-6', null)) === '6-1/22-6', 'weekend nights wrap');
+  check(formatScheduleWindows(compileSchedule('1-7/0-24', null)) === '1-7/0-24', 'every hour');
+  check(formatScheduleWindows(compileSchedule('1/7-12;1/10-19;2/7-19', null)) === '1-2/7-19', 'overlaps joined');
+
+  // Any hours: the text compiles back to the same bitmap (random seed fixed for repeatability)
+  let seed = 1;
+  const random = function() {
+    seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF;
+    return seed / 0x80000000;
+  };
+  for (let round = 0; round < 2000; round++) {
+    const bytes = compileSchedule(null, null);
+    for (let i = 0; i < 21; i++) {
+      bytes[i] = round % 2 == 0 ? Math.floor(random() * 256) : (random() < 0.5 ? 0 : 0xFF);
+    }
+    const text = formatScheduleWindows(bytes);
+    if (!sameBytes(compileSchedule(text, null), bytes)) {
+      check(false, 'round trip of ' + JSON.stringify(bytes) + ' as ' + text);
+      break;
+    }
+  }
+}
+
+function testWindowsLimit() {
+  // Eleven weekday windows ("1-5/0-1;...;1-5/20-21", 99 characters) are too long
+  // for the firmware: the row is dropped
+  const many = [];
+  for (let i = 0; i < 11; i++) {
+    many.push('Mo-Fr ' + (2 * i) + '-' + (2 * i + 1));
+  }
+  let list = readDongleList([row(ID_A, '1,2', many.join('; '), '31.12.2030'), row(ID_B)]);
+  check(list.length == 1 && list[0] === ID_B, 'row with too many windows dropped: ' + JSON.stringify(list));
+
+  // Repeated windows count once
+  const same = [];
+  for (let i = 0; i < 9; i++) {
+    same.push('Mo-Fr 10-19');
+  }
+  list = readDongleList([row(ID_A, '', same.join('; '), '')]);
+  check(list.length == 1 && list[0] === ID_A + '@1-5/10-19', 'repeated windows: ' + JSON.stringify(list));
+
+  // Rows of one ID whose union would be too long: the later row does not count
+  const early = many.slice(0, 5).join('; ');
+  const late = many.slice(5).join('; ');
+  list = readDongleList([row(ID_A, '1', early, '31.12.2030'), row(ID_A, '2', late, '31.12.2031')]);
+  check(list.length == 1 && windowsOf(list[0]) === '1-5/0-1;1-5/2-3;1-5/4-5;1-5/6-7;1-5/8-9' &&
+        list[0].indexOf(':1@') > 0 && list[0].indexOf('!2030-12-31') > 0, 'union too long: ' + JSON.stringify(list));
+
+  // A union that fits is merged as before, in its shortest form
+  list = readDongleList([row(ID_A, '1', 'Mo 7-12', ''), row(ID_A, '2', 'Mo 12-19; Di 7-19', '')]);
+  check(list.length == 1 && list[0] === ID_A + ':1,2@1-2/7-19', 'union merged: ' + JSON.stringify(list));
+}
+
+function testHashMatchesFirmware() {
+  // A sheet full of long schedules: every entry fits, so the firmware's table
+  // (only the entries it accepts) hashes like the script's list
+  const rows = [];
+  for (let id = 1; id <= 64; id++) {
+    const windows = [];
+    for (let w = 0; w < id % 16; w++) {
+      windows.push(['Mo', 'Di', 'Mi', 'Do', 'Fr', 'Sa', 'So'][(id + w) % 7] + ' ' + w + '-' + (w + 1 + id % 3));
+    }
+    const binary = ('0'.repeat(26) + id.toString(2)).slice(-26);
+    rows.push(row(binary, '1,2,3,4,5,6', windows.join('; '), '31.12.2030'));
+    rows.push(row(binary, '3', windows.reverse().join('; '), '01.01.2031'));
+  }
+  const list = readDongleList(rows);
+  const accepted = list.filter(firmwareAccepts);
+  check(list.every(function(entry) { return windowsOf(entry) === null || windowsOf(entry).length <= WINDOWS_TEXT_MAX; }),
+        'windows text within ACCESS_WINDOWS_TEXT_MAX');
+  check(accepted.length == list.length && dongleListHash(accepted) === dongleListHash(list),
+        'firmware accepts every entry (' + accepted.length + ' of ' + list.length + ')');
+}
+
+// Dongle sheet stand-in for readDongleSheet_: rows A:H from row 2, counting the reads
+function dongleSheetStub(rows) {
+  const sheet = { rows: rows, reads: 0 };
+  sheet.getLastRow = function() { return sheet.rows.length + 1; };
+  sheet.getRange = function() {
+    return { getValues: function() { sheet.reads++; return sheet.rows.map(function(r) { return r.slice(); }); } };
+  };
+  sheet.getName = function() { return vm.runInContext('spreadsheetname_db_pa', script); };
+  return sheet;
+}
+
+// CacheService stand-in (entries do not expire); maxBytes mimics the 100 KB limit per entry
+function cacheStub(maxBytes) {
+  const entries = {};
+  return {
+    entries: entries,
+    get: function(key) { return key in entries ? entries[key] : null; },
+    put: function(key, value) {
+      if (value.length > maxBytes) {
+        throw new Error('Argument too large: value');
+      }
+      entries[key] = value;
+    },
+    remove: function(key) { delete entries[key]; },
+  };
+}
+
+// The list, its hash and its digest belong together
+function selfConsistent(dongleSheet) {
+  const digest = crypto.createHash('sha256').update(dongleSheet.list.join('\n'), 'utf8').digest('base64');
+  return dongleSheet.hash === dongleListHash(dongleSheet.list) && dongleSheet.digest === digest;
+}
+
+function testDongleCache() {
+  script.Utilities.DigestAlgorithm = { SHA_256: 'sha256' };
+  script.Utilities.Charset = { UTF_8: 'utf8' };
+  script.Utilities.computeDigest = function(algorithm, text, charset) {
+    return crypto.createHash(algorithm).update(text, charset).digest();
+  };
+  script.Utilities.base64Encode = function(bytes) { return Buffer.from(bytes).toString('base64'); };
+  const sheet = dongleSheetStub([row(ID_A, '1')]);
+  let cache = cacheStub(100 * 1024);
+  script.CacheService = { getScriptCache: function() { return cache; } };
+  script.openSpreadsheet_ = function() { return { getSheetByName: function() { return sheet; } }; };
+  const cacheKey = vm.runInContext('DONGLE_CACHE_KEY', script);
+  const readDongleSheet = script.readDongleSheet_;
+
+  let read = readDongleSheet();
+  check(sheet.reads == 1 && read.list.length == 1 && selfConsistent(read), 'first read: ' + JSON.stringify(read));
+  check(selfConsistent(JSON.parse(cache.entries[cacheKey])), 'cached as read');
+  check(JSON.stringify(readDongleSheet()) === JSON.stringify(read) && sheet.reads == 1, 'served from the cache');
+
+  // Changed without a trigger: the stale entry is served whole, with its own
+  // hash, never the new list's hash with the old list (or the reverse)
+  sheet.rows.push(row(ID_B));
+  read = readDongleSheet();
+  check(sheet.reads == 1 && read.list.length == 1 && selfConsistent(read), 'stale but consistent: ' + JSON.stringify(read));
+  const delta = buildDongleDelta(read, { version: 1, base: 1 }, 0);
+  check(delta.reset && delta.hash === dongleListHash(delta.added), 'full answer matches its hash');
+
+  // An edit elsewhere keeps the cache; an edit of the dongle sheet or a
+  // structural change (no e.range) drops it, and the next request reads the sheet
+  const otherSheet = { getName: function() { return 'Log'; } };
+  script.onDongleSheetChange({ range: { getSheet: function() { return otherSheet; } } });
+  check(cacheKey in cache.entries, 'edit of another sheet keeps the cache');
+  script.onDongleSheetChange({ range: { getSheet: function() { return sheet; } } });
+  check(!(cacheKey in cache.entries), 'edit of the dongle sheet drops the cache');
+  read = readDongleSheet();
+  check(sheet.reads == 2 && read.list.length == 2 && selfConsistent(read), 'read after the edit: ' + JSON.stringify(read));
+  sheet.rows.pop();
+  script.onDongleSheetChange({});
+  read = readDongleSheet();
+  check(sheet.reads == 3 && read.list.length == 1 && selfConsistent(read), 'read after a structural change');
+
+  // Too large for one cache entry: every request reads the sheet
+  cache = cacheStub(10);
+  read = readDongleSheet();
+  check(Object.keys(cache.entries).length == 0 && sheet.reads == 4 && selfConsistent(read), 'uncached when too large');
+  readDongleSheet();
+  check(sheet.reads == 5, 'read again without a cache');
+}
+
+function testDeltaNetting() {
+  // Changelog rows [version, '+'|'-', id]: the delta since a version nets them per id
+  const changelog = [
+    [6, '-', ID_A],
+    [6, '+', 'C'], [7, '-', 'C'],      // Added and removed again: not in the delta
+    [7, '-', ID_B], [8, '+', ID_B],    // Removed and added back: not in the delta
+    [7, '+', 'D'],
+    [8, '-', 'E:1'], [8, '+', 'E:2'],  // Changed entry: old one removed, new one added
+  ];
+  script.openSpreadsheet_ = function() { return null; };
+  script.getSyncSheet_ = function() {
+    return {
+      getLastRow: function() { return changelog.length; },
+      getRange: function() { return { getValues: function() { return changelog; } }; },
+    };
+  };
+  const sheet = { list: ['full list'], hash: 1234 };
+  const sync = { version: 8, base: 1 };
+
+  let delta = buildDongleDelta(sheet, sync, 5);
+  check(!delta.reset && delta.version == 8 && delta.hash == 1234, 'delta header: ' + JSON.stringify(delta));
+  check(JSON.stringify(delta.added.sort()) === JSON.stringify(['D', 'E:2']), 'netted added: ' + JSON.stringify(delta.added));
+  check(JSON.stringify(delta.removed.sort()) === JSON.stringify([ID_A, 'E:1']), 'netted removed: ' + JSON.stringify(delta.removed));
+
+  // Since 7, B's removal is already known: its return is a change
+  delta = buildDongleDelta(sheet, sync, 7);
+  check(JSON.stringify(delta.added.sort()) === JSON.stringify([ID_B, 'E:2']) &&
+        JSON.stringify(delta.removed) === JSON.stringify(['E:1']), 'since 7: ' + JSON.stringify(delta));
+
+  // Up to date, and versions without a changelog: nothing, and the full list
+  delta = buildDongleDelta(sheet, sync, 8);
+  check(!delta.reset && delta.added.length == 0 && delta.removed.length == 0, 'up to date: ' + JSON.stringify(delta));
+  delta = buildDongleDelta(sheet, { version: 8, base: 6 }, 5);
+  check(delta.reset && delta.added === sheet.list, 'before base: ' + JSON.stringify(delta));
+}
+
+testFormatRoundTrip();
+testWindowsLimit();
+testHashMatchesFirmware();
+testDongleCache();
+testDeltaNetting();
+if (failures > 0) {
+  console.log(failures + ' check(s) failed');
+  process.exit(1);
+}
+console.log('google_script: all checks passed');
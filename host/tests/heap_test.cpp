@@ -0,0 +1,155 @@
+// Heap regression test for the steady-state paths. After a warm-up round,
+// a scan (Wiegand edges through the decision, relay, buzzer and log event)
+// and the network task's log handling (taking events from the ring,
+// batching, spilling to and replaying from the flash backlog, building the
+// POST body, metrics snapshot) must not allocate.
+//
+// malloc, calloc and realloc are replaced for the whole executable (glibc);
+// operator new allocates through them. The HTTP transport is not covered:
+// the shim's HTTPClient works on std::string, and on the device HTTPClient
+// and mbedTLS allocate internally.
+
+#include "NetworkTask.cpp"  // Unity include: reaches receiveLogEvents, failedLogRing, buildLogBatchBody
+#include "DoorChannel.h"
+#include "WiegandFormat.h"
+#include "check.h"
+#include <stdio.h>
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+static std::atomic<bool> counting{false};
+static std::atomic<uint32_t> allocations{0};
+static std::atomic<size_t> firstAllocationSize{0};
+
+static void countAllocation(size_t size) {
+  if (counting.load(std::memory_order_relaxed) && allocations.fetch_add(1, std::memory_order_relaxed) == 0) {
+    firstAllocationSize.store(size, std::memory_order_relaxed);
+  }
+}
+
+extern "C" void* malloc(size_t size) {
+  countAllocation(size);
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  countAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+  countAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+static DoorChannel door;
+static const uint32_t GRANTED_FRAME = DoorReaderFormat::encode(0x0253B1);
+static const uint32_t DENIED_FRAME = DoorReaderFormat::encode(0x0253B2);
+
+// Count the allocations of one call, after a first (warm-up) call that may allocate
+template<typename Fn>
+static uint32_t allocationsAfterWarmUp(const char* name, Fn fn) {
+  fn();
+  allocations = 0;
+  counting = true;
+  for (int round = 0; round < 50; round++) {
+    fn();
+  }
+  counting = false;
+  if (allocations > 0) {
+    printf("%s: %u allocation(s), first of %zu bytes\n", name, (unsigned)allocations.load(), firstAllocationSize.load());
+  }
+  return allocations;
+}
+
+static void sendFrame(uint32_t frameBits) {
+  for (int bit = DoorReaderFormat::BITS - 1; bit >= 0; bit--) {
+    uint8_t pin = ((frameBits >> bit) & 1) ? DOORS[0].data1Pin : DOORS[0].data0Pin;
+    HostGpio::setLevel(pin, LOW);
+    HostGpio::setLevel(pin, HIGH);
+  }
+}
+
+static void setUp() {
+  uint32_t* ids = new uint32_t[1];
+  ids[0] = GRANTED_FRAME;
+  DongleTable table;
+  table.adopt(ids, 1, false);
+  ramDongleTable.publish(table);
+
+  // Stand in for the network task: enqueueLogEvent() only queues once it exists
+  networkTaskHandle = xTaskGetCurrentTaskHandle();
+  door.begin(0, xTaskGetCurrentTaskHandle());
+  CHECK(failedLogRing.begin());
+}
+
+static void testHookCounts() {
+  // Otherwise a libc whose malloc cannot be replaced would pass every test below
+  void* (*volatile allocate)(size_t) = malloc;
+  allocations = 0;
+  counting = true;
+  free(allocate(16));
+  counting = false;
+  CHECK(allocations == 1 && firstAllocationSize == 16);
+}
+
+static void testScan() {
+  uint32_t scanAllocations = allocationsAfterWarmUp("scan", []() {
+    sendFrame(GRANTED_FRAME);
+    sendFrame(DENIED_FRAME);
+    door.handleWiegandFrames();
+    door.onRelayTimer();
+    door.onBuzzerTimer();
+    HostGpio::setLevel(DOORS[0].contactPin, !digitalRead(DOORS[0].contactPin));
+    door.trackDoorStateChange();
+  });
+  CHECK(scanAllocations == 0);
+  CHECK(logEventRing.size() > 0);
+}
+
+static void testLogDispatch() {
+  // Events left over from testScan would fill a batch, which is sent
+  const LogEvent* events;
+  while (uint32_t count = logEventRing.peek(&events)) {
+    logEventRing.release(count);
+  }
+
+  // Online: events are collected into the pending batch (short of a full one,
+  // which would be sent) and its body is built; then it is spilled and
+  // replayed from the backlog in a prioritized batch
+  linkMonitor.onWifi(true);
+  uint32_t onlineAllocations = allocationsAfterWarmUp("online batching", []() {
+    for (int i = 0; i < LOG_BATCH_MAX_ENTRIES - 1; i++) {
+      enqueueLogEvent(LOG_EVENT_AUTHORISED, GRANTED_FRAME, 0);
+    }
+    receiveLogEvents();
+    buildLogBatchBody(pendingLogs, pendingLogCount, logBatchBody, sizeof(logBatchBody));
+    spillPendingLogs();
+    int count = failedLogRing.peekPrioritized(storedLogBatch, LOG_BATCH_MAX_ENTRIES);
+    buildLogBatchBody(storedLogBatch, count, logBatchBody, sizeof(logBatchBody));
+    failedLogRing.consume();
+  });
+  CHECK(onlineAllocations == 0);
+  CHECK(failedLogRing.pendingCount() == 0);
+
+  // Offline: new events go straight to the flash backlog
+  linkMonitor.onWifi(false);
+  uint32_t offlineAllocations = allocationsAfterWarmUp("offline spill", []() {
+    enqueueLogEvent(LOG_EVENT_DENIED, DENIED_FRAME, 0);
+    enqueueLogEvent(LOG_EVENT_DOOR_OPEN, 0, 0);
+    receiveLogEvents();
+    updateMetricsGauges();
+  });
+  CHECK(offlineAllocations == 0);
+  CHECK(failedLogRing.pendingCount() == 2 * 51);
+}
+
+int main() {
+  setUp();
+  testHookCounts();
+  testScan();
+  testLogDispatch();
+  return checkSummary("heap");
+}
@@ -0,0 +1,118 @@
+// Tests for the connectivity state machine (LinkMonitor) and its backoff:
+// interval growth, jitter bounds, cap, reset, state transitions on request
+// outcomes and WiFi changes, and the request timeout per state.
+
+#include "LinkMonitor.h"
+#include "check.h"
+#include <climits>
+#include <stdio.h>
+
+static void testBackoffGrowth() {
+  Backoff backoff(1000, 30000);
+  CHECK(backoff.due(0));
+  CHECK(backoff.msUntilDue(0) == 0);
+
+  unsigned long expected[] = { 1000, 2000, 4000, 8000, 16000, 30000, 30000 };
+  for (unsigned long interval : expected) {
+    backoff.fail(5000, 0);
+    CHECK(backoff.intervalMs() == interval);
+    CHECK(backoff.msUntilDue(5000) == interval - interval / 2);  // random 0: lower end of the upper half
+  }
+
+  backoff.reset();
+  CHECK(backoff.due(5000));
+  backoff.fail(5000, 0);
+  CHECK(backoff.intervalMs() == 1000);
+}
+
+static void testBackoffJitter() {
+  // Every random value lands in [interval / 2, interval]
+  Backoff backoff(1000, 30000);
+  for (int step = 0; step < 4; step++) {
+    backoff.fail(0, 0);
+  }
+  uint32_t interval = (uint32_t)backoff.intervalMs();
+  uint32_t randoms[] = { 1, interval / 2, interval / 2 + 1, 123456789, UINT32_MAX };
+  for (uint32_t random : randoms) {
+    Backoff jittered = backoff;
+    jittered.fail(0, random);
+    unsigned long delay = jittered.msUntilDue(0);
+    CHECK(delay >= jittered.intervalMs() / 2 && delay <= jittered.intervalMs());
+  }
+}
+
+static void testBackoffWrap() {
+  // millis() wraps after 49 days: due times across the wrap still work
+  Backoff backoff(1000, 30000);
+  unsigned long now = ULONG_MAX - 200;
+  backoff.fail(now, 0);
+  CHECK(!backoff.due(now));
+  CHECK(!backoff.due(now + 400));  // Wrapped, 400 ms later
+  CHECK(backoff.due(now + 500));
+}
+
+static void testStateTransitions() {
+  // Boot: offline until WiFi is up; the first association goes online with the full timeout
+  LinkMonitor link;
+  CHECK(link.state() == LINK_OFFLINE);
+  CHECK(!link.requestDue(0));
+  link.onWifi(true);
+  CHECK(link.state() == LINK_ONLINE);
+  CHECK(link.requestDue(0));
+  CHECK(link.requestTimeoutMs() == SCRIPT_HTTP_TIMEOUT_MS);
+
+  link.onRequest(false, 1000, 0);
+  CHECK(link.state() == LINK_DEGRADED);
+  CHECK(link.requestTimeoutMs() == SCRIPT_PROBE_TIMEOUT_MS);
+  CHECK(!link.requestDue(1000));
+  CHECK(link.msUntilRequestDue(1000) == LINK_RETRY_MIN_MS / 2);
+  CHECK(link.requestDue(1000 + LINK_RETRY_MIN_MS / 2));
+
+  for (int i = 1; i < LINK_OFFLINE_AFTER_FAILURES; i++) {
+    link.onRequest(false, 2000, 0);
+  }
+  CHECK(link.state() == LINK_OFFLINE);
+  CHECK(link.requestTimeoutMs() == SCRIPT_PROBE_TIMEOUT_MS);
+
+  // One success is enough
+  link.onRequest(true, 3000, 0);
+  CHECK(link.state() == LINK_ONLINE);
+  CHECK(link.requestDue(3000));
+  CHECK(link.requestTimeoutMs() == SCRIPT_HTTP_TIMEOUT_MS);
+}
+
+static void testWifi() {
+  LinkMonitor link;
+  link.onWifi(false);  // Still associating at boot: unchanged
+  CHECK(link.state() == LINK_OFFLINE);
+  link.onWifi(true);
+  link.onWifi(false);
+  CHECK(link.state() == LINK_OFFLINE);
+  CHECK(!link.requestDue(0));
+  CHECK(link.msUntilRequestDue(0) == ULONG_MAX);
+
+  // Back: degraded, probe at once, even during a long backoff
+  for (int i = 0; i < 10; i++) {
+    link.onRequest(false, 0, 0);
+  }
+  link.onWifi(true);
+  CHECK(link.state() == LINK_DEGRADED);
+  CHECK(link.requestDue(0));
+  CHECK(link.requestTimeoutMs() == SCRIPT_PROBE_TIMEOUT_MS);
+  link.onRequest(true, 0, 0);
+  CHECK(link.state() == LINK_ONLINE);
+
+  // Unchanged status is no event
+  link.onWifi(true);
+  CHECK(link.state() == LINK_ONLINE);
+}
+
+int main() {
+  testBackoffGrowth();
+  testBackoffJitter();
+  testBackoffWrap();
+  testStateTransitions();
+  testWifi();
+
+  return checkSummary("link_monitor");
+}
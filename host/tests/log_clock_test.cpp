@@ -0,0 +1,76 @@
+// Tests for LogClock: uptime stamps to wall time, boot-relative stamps
+// before the clock is set and their back-fill (this boot only).
+
+#include "LogClock.h"
+#include "check.h"
+#include <stdio.h>
+
+static const uint32_t NOW = 1760000000;  // 2025-10-09
+
+static void testSetClock() {
+  LogClock clock;
+  clock.begin(7);
+  clock.sync(NOW, 100);
+  CHECK(clock.isSet());
+  CHECK(clock.fromUptime(100) == NOW);
+  CHECK(clock.fromUptime(160) == NOW + 60);
+
+  // NTP correction: later stamps follow it
+  clock.sync(NOW + 202, 200);
+  CHECK(clock.fromUptime(200) == NOW + 202);
+}
+
+static void testBeforeSync() {
+  LogClock clock;
+  clock.begin(7);
+  clock.sync(30, 30);  // time() before NTP counts from 1970
+  CHECK(!clock.isSet());
+
+  uint32_t stamp = clock.fromUptime(2);
+  CHECK(stamp < LOG_EVENT_MIN_VALID_EPOCH);
+  CHECK(clock.backfill(stamp) == stamp);  // Nothing to back-fill with yet
+
+  clock.sync(NOW, 12);
+  CHECK(clock.backfill(stamp) == NOW - 10);
+  CHECK(clock.backfill(NOW + 5) == NOW + 5);  // Wall time stays
+}
+
+static void testOtherBoots() {
+  LogClock previous;
+  previous.begin(6);
+  uint32_t previousStamp = previous.fromUptime(2);
+
+  LogClock clock;
+  clock.begin(7);
+  clock.sync(NOW, 12);
+  CHECK(clock.backfill(previousStamp) == previousStamp);
+  CHECK(clock.backfill(2) == 2);  // Firmware before boot numbers: time() before NTP
+
+  // Clamped after 48 days without a clock: left as is
+  LogClock unsynced;
+  unsynced.begin(7);
+  uint32_t clamped = unsynced.fromUptime(LOG_CLOCK_UPTIME_MASK + 1000);
+  CHECK(clamped < LOG_EVENT_MIN_VALID_EPOCH);
+  CHECK(clock.backfill(clamped) == clamped);
+}
+
+static void testBootIds() {
+  CHECK(LogClock::nextBootId(0) == 1);
+  CHECK(LogClock::nextBootId(1) == 2);
+  CHECK(LogClock::nextBootId(LOG_CLOCK_BOOT_IDS) == 1);  // Wraps, skipping 0
+
+  LogClock clock;
+  clock.begin(LOG_CLOCK_BOOT_IDS);
+  uint32_t stamp = clock.fromUptime(LOG_CLOCK_UPTIME_MASK - 1);
+  CHECK(stamp < LOG_EVENT_MIN_VALID_EPOCH);
+  clock.sync(NOW, LOG_CLOCK_UPTIME_MASK);
+  CHECK(clock.backfill(stamp) == NOW - 1);
+}
+
+int main() {
+  testSetClock();
+  testBeforeSync();
+  testOtherBoots();
+  testBootIds();
+  return checkSummary("log_clock");
+}
@@ -0,0 +1,225 @@
+// Tests for the failed-log flash ring (LogRing): append/drain order, access
+// events first, wrap-around and overwrite of the oldest sector, reboot scan and
+// torn writes, against the esp_partition shim.
+
+#include "LogRing.h"
+#include "check.h"
+#include <stdio.h>
+
+static const char SMALL_RING[] = "logring_small";  // 3 sectors = 612 records
+static const uint32_t PER_SECTOR = SPI_FLASH_SEC_SIZE / LOG_RING_RECORD_SIZE;
+
+static LogEvent makeEvent(int n) {
+  LogEvent event;
+  event.epoch = 1700000000 + n;
+  event.dongleId = n;
+  event.type = n % LOG_EVENT_TYPE_COUNT;
+  return event;
+}
+
+static bool isEvent(const LogEvent& event, int n) {
+  return event.epoch == 1700000000u + n && event.dongleId == (uint32_t)n && event.type == (uint32_t)n % LOG_EVENT_TYPE_COUNT;
+}
+
+static void freshSmallRing() {
+  static bool added = false;
+  if (!added) {
+    HostFlash::addPartition(SMALL_RING, LOG_RING_PARTITION_SUBTYPE, 3 * SPI_FLASH_SEC_SIZE);
+    added = true;
+  }
+  HostFlash::reset();
+}
+
+static void testEmptyPartition() {
+  HostFlash::reset();
+  LogRing ring;
+  CHECK(ring.begin());
+  CHECK(ring.pendingCount() == 0);
+  CHECK(ring.capacity() == (0x40000 / SPI_FLASH_SEC_SIZE - 1) * PER_SECTOR);
+  LogEvent event;
+  CHECK(ring.peek(&event, 1) == 0);
+}
+
+static void testMissingPartition() {
+  LogRing ring;
+  CHECK(!ring.begin("no_such_label"));
+  CHECK(!ring.append(makeEvent(1)));
+}
+
+static void testAppendPeekConsume() {
+  HostFlash::reset();
+  LogRing ring;
+  ring.begin();
+  for (int i = 0; i < 30; i++) {
+    CHECK(ring.append(makeEvent(i)));
+  }
+  CHECK(ring.pendingCount() == 30);
+
+  // peek without consume returns the same batch again
+  LogEvent batch[25];
+  CHECK(ring.peek(batch, 25) == 25);
+  CHECK(ring.peek(batch, 25) == 25);
+  CHECK(isEvent(batch[0], 0) && isEvent(batch[24], 24));
+  ring.consume();
+  CHECK(ring.pendingCount() == 5);
+  CHECK(ring.peek(batch, 25) == 5);
+  CHECK(isEvent(batch[0], 25) && isEvent(batch[4], 29));
+  ring.consume();
+  CHECK(ring.pendingCount() == 0);
+  CHECK(ring.peek(batch, 25) == 0);
+
+  // Sending only clears bits: one erase for the first sector, none since
+  CHECK(HostFlash::eraseCount() == 1);
+}
+
+static void testRebootScan() {
+  HostFlash::reset();
+  {
+    LogRing ring;
+    ring.begin();
+    for (int i = 0; i < 10; i++) {
+      ring.append(makeEvent(i));
+    }
+    LogEvent batch[4];
+    ring.peek(batch, 4);
+    ring.consume();
+  }
+
+  LogRing reboot;
+  CHECK(reboot.begin());
+  CHECK(reboot.pendingCount() == 6);
+  LogEvent batch[25];
+  CHECK(reboot.peek(batch, 25) == 6);
+  CHECK(isEvent(batch[0], 4) && isEvent(batch[5], 9));
+
+  // Appending continues after the newest record
+  CHECK(reboot.append(makeEvent(10)));
+  CHECK(reboot.peek(batch, 25) == 7);
+  CHECK(isEvent(batch[6], 10));
+  const LogRingRecord* records = reinterpret_cast<const LogRingRecord*>(HostFlash::data(LOG_RING_PARTITION_LABEL));
+  CHECK(records[10].sequence == 11);
+}
+
+static void testWrapOverwritesOldest() {
+  freshSmallRing();
+  LogRing ring;
+  CHECK(ring.begin(SMALL_RING));
+  CHECK(ring.capacity() == 2 * PER_SECTOR);
+
+  // One record into the fourth "sector" wraps and erases the first one
+  const int total = 3 * PER_SECTOR + 1;
+  for (int i = 0; i < total; i++) {
+    CHECK(ring.append(makeEvent(i)));
+  }
+  CHECK(ring.droppedCount() == PER_SECTOR);
+  CHECK(ring.pendingCount() == 2 * PER_SECTOR + 1);
+
+  LogEvent batch[25];
+  CHECK(ring.peek(batch, 1) == 1);
+  CHECK(isEvent(batch[0], PER_SECTOR));
+
+  // Same view after a reboot: oldest surviving record first, newest last
+  LogRing reboot;
+  reboot.begin(SMALL_RING);
+  CHECK(reboot.pendingCount() == 2 * PER_SECTOR + 1);
+  int drained = 0;
+  int last = -1;
+  int count;
+  while ((count = reboot.peek(batch, 25)) > 0) {
+    if (drained == 0) {
+      CHECK(isEvent(batch[0], PER_SECTOR));
+    }
+    drained += count;
+    last = count - 1;
+    reboot.consume();
+  }
+  CHECK(drained == (int)(2 * PER_SECTOR + 1));
+  CHECK(last >= 0 && isEvent(batch[last], total - 1));
+  CHECK(reboot.pendingCount() == 0);
+}
+
+static void testPrioritizedPeek() {
+  // makeEvent(n): types 0/1 are scans, 2/3 door events
+  HostFlash::reset();
+  LogRing ring;
+  ring.begin();
+  for (int i = 0; i < 12; i++) {
+    ring.append(makeEvent(i));
+  }
+  LogEvent batch[25];
+  CHECK(ring.peekPrioritized(batch, 4) == 4);
+  CHECK(isEvent(batch[0], 0) && isEvent(batch[1], 1) && isEvent(batch[2], 4) && isEvent(batch[3], 5));
+  ring.consume();
+  CHECK(ring.pendingCount() == 8);
+
+  // Remaining scans first, then the door events oldest first
+  CHECK(ring.peekPrioritized(batch, 25) == 8);
+  int expected[] = { 8, 9, 2, 3, 6, 7, 10, 11 };
+  for (int i = 0; i < 8; i++) {
+    CHECK(isEvent(batch[i], expected[i]));
+  }
+
+  // The sent scans leave holes: plain order and a reboot skip them
+  CHECK(ring.peek(batch, 25) == 8);
+  CHECK(isEvent(batch[0], 2) && isEvent(batch[4], 8));
+  LogRing reboot;
+  reboot.begin();
+  CHECK(reboot.pendingCount() == 8);
+  CHECK(reboot.peek(batch, 3) == 3);
+  CHECK(isEvent(batch[0], 2) && isEvent(batch[1], 3) && isEvent(batch[2], 6));
+}
+
+static void testConsumeAfterOverwrite() {
+  // Records peeked, then overwritten before consume(): their slots now hold new records
+  freshSmallRing();
+  LogRing ring;
+  ring.begin(SMALL_RING);
+  ring.append(makeEvent(0));
+  LogEvent batch[25];
+  CHECK(ring.peek(batch, 1) == 1);
+  for (uint32_t i = 1; i <= 3 * PER_SECTOR; i++) {
+    ring.append(makeEvent(i));
+  }
+  uint32_t pending = ring.pendingCount();
+  CHECK(pending == 2 * PER_SECTOR + 1);
+  ring.consume();
+  CHECK(ring.pendingCount() == pending);
+}
+
+static void testTornWrite() {
+  HostFlash::reset();
+  {
+    LogRing ring;
+    ring.begin();
+    ring.append(makeEvent(0));
+    ring.append(makeEvent(1));
+    HostFlash::failWritesAfter(10);  // Power lost halfway through the third record
+    CHECK(!ring.append(makeEvent(2)));
+    HostFlash::failWritesAfter(-1);
+  }
+
+  LogRing reboot;
+  reboot.begin();
+  CHECK(reboot.pendingCount() == 2);
+
+  // The torn slot is skipped, not overwritten
+  CHECK(reboot.append(makeEvent(3)));
+  LogEvent batch[25];
+  CHECK(reboot.peek(batch, 25) == 3);
+  CHECK(isEvent(batch[0], 0) && isEvent(batch[1], 1) && isEvent(batch[2], 3));
+  const LogRingRecord* records = reinterpret_cast<const LogRingRecord*>(HostFlash::data(LOG_RING_PARTITION_LABEL));
+  CHECK(records[3].sequence == 3);
+}
+
+int main() {
+  testEmptyPartition();
+  testMissingPartition();
+  testAppendPeekConsume();
+  testRebootScan();
+  testWrapOverwritesOldest();
+  testPrioritizedPeek();
+  testConsumeAfterOverwrite();
+  testTornWrite();
+
+  return checkSummary("log_ring");
+}
@@ -0,0 +1,130 @@
+// Tests for NetworkMetrics: request histograms, failure table, gauges and
+// the /metrics handler, scraped through the esp_http_server shim.
+
+#include "Metrics.h"
+#include "LatencyTrace.h"
+#include "check.h"
+#include <esp_http_server.h>
+#include <stdio.h>
+#include <string>
+
+class StringPrint : public Print {
+  public:
+    std::string text;
+    size_t write(uint8_t c) override { text += (char)c; return 1; }
+};
+
+static std::string scrape(const NetworkMetrics& metrics) {
+  StringPrint out;
+  metrics.print(out);
+  return out.text;
+}
+
+static bool hasLine(const std::string& text, const std::string& line) {
+  return text.find(line + "\n") != std::string::npos;
+}
+
+static void testRequestHistogram() {
+  NetworkMetrics metrics;
+  metrics.recordRequest(SCRIPT_ACTION_READ_PA_DELTA, 200, true, 80);
+  metrics.recordRequest(SCRIPT_ACTION_READ_PA_DELTA, 200, true, 100);   // Bounds are inclusive
+  metrics.recordRequest(SCRIPT_ACTION_READ_PA_DELTA, 200, true, 1500);
+  metrics.recordRequest(SCRIPT_ACTION_READ_PA_DELTA, -11, false, 25000); // Beyond the last bound
+  std::string text = scrape(metrics);
+
+  CHECK(hasLine(text, "# TYPE rfid_script_request_duration_ms histogram"));
+  CHECK(hasLine(text, "rfid_script_request_duration_ms_bucket{action=\"read_pa_delta\",le=\"100\"} 2"));
+  CHECK(hasLine(text, "rfid_script_request_duration_ms_bucket{action=\"read_pa_delta\",le=\"1000\"} 2"));
+  CHECK(hasLine(text, "rfid_script_request_duration_ms_bucket{action=\"read_pa_delta\",le=\"2000\"} 3"));
+  CHECK(hasLine(text, "rfid_script_request_duration_ms_bucket{action=\"read_pa_delta\",le=\"20000\"} 3"));
+  CHECK(hasLine(text, "rfid_script_request_duration_ms_bucket{action=\"read_pa_delta\",le=\"+Inf\"} 4"));
+  CHECK(hasLine(text, "rfid_script_request_duration_ms_sum{action=\"read_pa_delta\"} 26680"));
+  CHECK(hasLine(text, "rfid_script_request_duration_ms_count{action=\"read_pa_delta\"} 4"));
+  CHECK(hasLine(text, "rfid_script_request_duration_ms_count{action=\"write_log_batch\"} 0"));
+}
+
+static void testFailuresByCode() {
+  NetworkMetrics metrics;
+  metrics.recordRequest(SCRIPT_ACTION_WRITE_LOG_BATCH, -1, false, 10);
+  metrics.recordRequest(SCRIPT_ACTION_WRITE_LOG_BATCH, -1, false, 10);
+  metrics.recordRequest(SCRIPT_ACTION_WRITE_LOG_BATCH, 200, false, 10);
+  metrics.recordRequest(SCRIPT_ACTION_READ_PA_DELTA, -1, false, 10);
+  metrics.recordRequest(SCRIPT_ACTION_READ_PA_DELTA, 200, true, 10);
+  std::string text = scrape(metrics);
+
+  CHECK(hasLine(text, "rfid_script_request_failures_total{action=\"write_log_batch\",code=\"-1\"} 2"));
+  CHECK(hasLine(text, "rfid_script_request_failures_total{action=\"write_log_batch\",code=\"200\"} 1"));
+  CHECK(hasLine(text, "rfid_script_request_failures_total{action=\"read_pa_delta\",code=\"-1\"} 1"));
+  CHECK(text.find("read_pa_delta\",code=\"200\"") == std::string::npos);
+
+  // Table full: further codes are counted as "other"
+  for (int code = 500; code < 500 + METRICS_FAILURE_SLOTS; code++) {
+    metrics.recordRequest(SCRIPT_ACTION_READ_PA_DELTA, code, false, 10);
+  }
+  text = scrape(metrics);
+  CHECK(hasLine(text, "rfid_script_request_failures_total{action=\"read_pa_delta\",code=\"other\"} 3"));
+  CHECK(hasLine(text, "rfid_script_request_failures_total{action=\"read_pa_delta\",code=\"504\"} 1"));
+}
+
+static void testGauges() {
+  NetworkMetrics metrics;
+  metrics.setLogQueueDepthMax(17);
+  metrics.setLogCounts(2, 40, 7);
+  metrics.setDongleTable(1234, 56);
+  metrics.setLinkState(2);
+  metrics.setBootReadyMs(42);
+  std::string text = scrape(metrics);
+
+  CHECK(hasLine(text, "rfid_log_queue_depth_max 17"));
+  CHECK(hasLine(text, "rfid_log_queue_capacity " + std::to_string(LOG_QUEUE_SIZE)));
+  CHECK(hasLine(text, "rfid_log_events_dropped_total 2"));
+  CHECK(hasLine(text, "rfid_log_backlog_events 40"));
+  CHECK(hasLine(text, "rfid_log_backlog_overwritten_total 7"));
+  CHECK(hasLine(text, "rfid_dongle_table_size 1234"));
+  CHECK(hasLine(text, "rfid_dongle_table_version 56"));
+  CHECK(hasLine(text, "rfid_link_state 2"));
+  CHECK(hasLine(text, "rfid_boot_ready_ms 42"));
+  CHECK(hasLine(text, "# TYPE rfid_heap_free_bytes gauge"));
+}
+
+static void testScanLatency() {
+  NetworkMetrics metrics;
+  requestLatencyTraceReset();
+  traceScanStart(traceTimestamp());
+  traceScanStage(LATENCY_STAGE_DECISION);
+  std::string text = scrape(metrics);
+
+  CHECK(hasLine(text, "rfid_scan_latency_us_bucket{stage=\"decision\",le=\"+Inf\"} 1"));
+  CHECK(hasLine(text, "rfid_scan_latency_us_count{stage=\"decision\"} 1"));
+  CHECK(hasLine(text, "rfid_scan_latency_us_count{stage=\"relay\"} 0"));
+  CHECK(hasLine(text, "rfid_scan_latency_us_bucket{stage=\"wake\",le=\"32768\"} 0"));
+}
+
+static void testServer() {
+  HostHttpd::reset();
+  NetworkMetrics metrics;
+  metrics.setDongleTable(9, 3);
+  CHECK(startMetricsServer(&metrics));
+  CHECK(HostHttpd::port() == METRICS_HTTP_PORT);
+
+  std::string body;
+  std::string contentType;
+  CHECK(HostHttpd::get("/metrics", &body, &contentType));
+  CHECK(contentType == "text/plain; version=0.0.4");
+  CHECK(body == scrape(metrics));
+  CHECK(body.size() > 512);  // Spans several chunks
+  CHECK(hasLine(body, "rfid_dongle_table_size 9"));
+  CHECK(!HostHttpd::get("/", &body));
+
+  CHECK(!startMetricsServer(&metrics));  // Port already in use
+  HostHttpd::reset();
+}
+
+int main() {
+  testRequestHistogram();
+  testFailuresByCode();
+  testGauges();
+  testScanLatency();
+  testServer();
+  return checkSummary("metrics");
+}
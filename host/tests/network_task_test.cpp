@@ -0,0 +1,315 @@
+// Tests for the network task, through its file-static helpers: which log
+// batch uploads count as delivered when the web app's answer is lost on the
+// way back, the migration of failed logs kept in NVS by firmware before the
+// log ring, the dongle list: migration of the list kept in NVS, and
+// the sync (deltas, hash mismatch, full download), and the WiFi events.
+
+#include "NetworkTask.cpp"  // Unity include: reaches flushPendingLogs, pendingLogs, failedLogRing
+#include "check.h"
+#include <map>
+#include <stdio.h>
+#include <vector>
+
+static const char RESULT_LOCATION[] = "https://script.googleusercontent.com/macros/echo?user_content_key=1";
+static const char SIGN_IN_LOCATION[] = "https://accounts.google.com/ServiceLogin?continue=x";
+
+static int scriptPosts = 0;
+
+// Apps Script stand-in: the POST is answered with a 302 to location, the
+// result fetch with resultCode (and the script's answer if it is 200)
+static void serve(const char* location, int resultCode, const char* result = "{\"success\":true,\"count\":1}") {
+  scriptPosts = 0;
+  std::string resultLocation = location;
+  std::string resultBody = result;
+  HostHttp::setHandler([resultLocation, resultCode, resultBody](const HostHttp::Request& request) {
+    HostHttp::Response response = { 0, std::string(), std::string() };
+    if (request.method == "GET") {
+      response.code = resultCode;
+      response.body = resultCode == 200 ? resultBody : std::string();
+      return response;
+    }
+    scriptPosts++;
+    response.code = 302;
+    response.body = "<HTML>Moved Temporarily</HTML>";
+    response.location = resultLocation;
+    return response;
+  });
+}
+
+// Upload one event as a fresh batch; returns the events left in the flash backlog
+static uint32_t flushOneEvent() {
+  while (failedLogRing.pendingCount() > 0) {
+    failedLogRing.peek(storedLogBatch, LOG_BATCH_MAX_ENTRIES);
+    failedLogRing.consume();
+  }
+  pendingLogs[0] = makeLogEvent(LOG_EVENT_AUTHORISED, 0x0253B1);
+  pendingLogCount = 1;
+  flushPendingLogs();
+  CHECK(pendingLogCount == 0);
+  return failedLogRing.pendingCount();
+}
+
+static void testResultDelivered() {
+  serve(RESULT_LOCATION, 200);
+  CHECK(flushOneEvent() == 0);
+  CHECK(scriptPosts == 1);
+}
+
+static void testResultLostAfterRedirect() {
+  // The script has run: the batch must not be written a second time
+  serve(RESULT_LOCATION, 500);
+  CHECK(flushOneEvent() == 0);
+  CHECK(scriptPosts == 1);
+
+  // Also when the kept-alive content connection fails (ScriptClient must not repeat the POST)
+  serve(RESULT_LOCATION, 200);
+  flushOneEvent();
+  serve(RESULT_LOCATION, HTTPC_ERROR_CONNECTION_REFUSED);
+  CHECK(flushOneEvent() == 0);
+  CHECK(scriptPosts == 1);
+}
+
+static void testNotDelivered() {
+  // The script reported an error: kept for a retry
+  serve(RESULT_LOCATION, 200, "{\"success\":false,\"message\":\"Fehler\"}");
+  CHECK(flushOneEvent() == 1);
+
+  // A redirect to the sign-in page means the script never ran
+  serve(SIGN_IN_LOCATION, 500);
+  CHECK(flushOneEvent() == 1);
+
+  // Rejected before the script ran
+  HostHttp::setHandler([](const HostHttp::Request&) {
+    HostHttp::Response response = { 503, std::string(), std::string() };
+    return response;
+  });
+  CHECK(flushOneEvent() == 1);
+}
+
+// Leave garbage on the stack where the next call keeps its locals
+static void __attribute__((noinline)) dirtyStack() {
+  volatile uint8_t junk[4096];
+  for (size_t i = 0; i < sizeof(junk); i++) {
+    junk[i] = 0xFF;
+  }
+}
+
+static void testMigrateLegacyFailedLogs() {
+  while (failedLogRing.pendingCount() > 0) {
+    failedLogRing.peek(storedLogBatch, LOG_BATCH_MAX_ENTRIES);
+    failedLogRing.consume();
+  }
+  Preferences prefs;
+  prefs.begin(PERS_MEM_FAILED_LOGS, false);
+  prefs.putString("keyArray", "[\"log1\",\"log2\",\"log3\"]");
+  prefs.putString("log1", "14.11.2023,22:13:20,authorised,00000000100101001110110001");
+  prefs.putString("log2", "Date Error,Date Err,door_is_open,doorstate");
+  prefs.putString("log3", "14.11.2023,22:13:21,unknown,00000000100101001110110001");  // Dropped
+  prefs.end();
+
+  dirtyStack();
+  migrateLegacyFailedLogs();
+  LogEvent events[4];
+  CHECK(failedLogRing.peek(events, 4) == 2);
+  CHECK(events[0].type == LOG_EVENT_AUTHORISED && events[0].dongleId == 0x0253B1 && events[0].door == 0);
+  CHECK(events[0].epoch >= LOG_EVENT_MIN_VALID_EPOCH);
+  CHECK(events[1].type == LOG_EVENT_DOOR_OPEN && events[1].dongleId == 0 && events[1].door == 0);
+  CHECK(events[1].epoch == 0);
+
+  prefs.begin(PERS_MEM_FAILED_LOGS, true);
+  CHECK(!prefs.isKey("keyArray"));
+  prefs.end();
+}
+
+static const char ID_A[] = "00000000000000000000000011";
+static const char ID_B[] = "00000000000000000000000101";
+static const char ID_C[] = "00000000000000000000000111";
+static const char ID_D[] = "00000000000000000000001001";
+
+static std::vector<uint32_t> dongleQueries;  // "since" of every read_pa_delta request
+static std::vector<uint32_t> dongleQueryTimeouts;  // HTTP timeout of each of them
+
+static std::string jsonList(std::vector<std::string> entries) {
+  std::string json = "[";
+  for (size_t i = 0; i < entries.size(); i++) {
+    json += (i > 0 ? ",\"" : "\"") + entries[i] + "\"";
+  }
+  return json + "]";
+}
+
+static void makeTable(DongleTable* table, std::vector<std::string> entries) {
+  std::string json = jsonList(entries);
+  DongleListParser parser;
+  parser.feed(json.data(), json.size());
+  CHECK(parser.finish(table));
+}
+
+// read_pa_delta answer; hash is that of the server's complete list
+static std::string deltaAnswer(uint32_t version, bool reset, std::vector<std::string> added,
+                               std::vector<std::string> removed, std::vector<std::string> serverList) {
+  DongleTable server;
+  makeTable(&server, serverList);
+  return "{\"version\":" + std::to_string(version) + ",\"hash\":" + std::to_string(server.hash()) +
+         ",\"reset\":" + (reset ? "true" : "false") + ",\"added\":" + jsonList(added) +
+         ",\"removed\":" + jsonList(removed) + "}";
+}
+
+// Apps Script stand-in for read_pa_delta: since=N is answered with answers[N], 503 without one
+static void serveDongleDeltas(std::map<uint32_t, std::string> answers) {
+  dongleQueries.clear();
+  dongleQueryTimeouts.clear();
+  HostHttp::setHandler([answers](const HostHttp::Request& request) {
+    HostHttp::Response response = { 503, std::string(), std::string() };
+    size_t since = request.url.find("since=");
+    if (since == std::string::npos) {
+      return response;
+    }
+    uint32_t version = (uint32_t)strtoul(request.url.c_str() + since + 6, nullptr, 10);
+    dongleQueries.push_back(version);
+    dongleQueryTimeouts.push_back(request.timeoutMs);
+    auto answer = answers.find(version);
+    if (answer != answers.end()) {
+      response.code = 200;
+      response.body = answer->second;
+    }
+    return response;
+  });
+}
+
+static void startDongleTable(std::vector<std::string> entries, uint32_t version) {
+  DongleTable table;
+  makeTable(&table, entries);
+  ramDongleTable.publish(table);
+  dongleListVersion = version;
+  dongleStoreDirty = false;
+}
+
+static bool publishedTableIs(std::vector<std::string> entries) {
+  DongleTable expected;
+  makeTable(&expected, entries);
+  PublishedDongleTable::Reader current(ramDongleTable);
+  return current->equals(expected);
+}
+
+static void testMigrateLegacyDongleJson() {
+  // Firmware before the "dongles" partition kept the read_pa answer in NVS: it
+  // is used at boot, and removed once the first sync has saved the list to flash
+  Preferences prefs;
+  prefs.begin("dongleStore", false);
+  prefs.putString(PERS_MEM_DONGLE_IDS, "[[\"" + std::string(ID_A) + "\"],[\"" + ID_B + "\"]]");
+  prefs.end();
+
+  loadDonglesFromPersistentMemory();  // Flash partition still empty
+  CHECK(publishedTableIs({ ID_A, ID_B }));
+  CHECK(dongleStoreDirty && dongleListVersion == 0);
+
+  serveDongleDeltas({ { 0, deltaAnswer(3, true, { ID_A, ID_B }, {}, { ID_A, ID_B }) } });
+  fetchAndStoreDongleIds();
+  CHECK(!dongleStoreDirty && dongleListVersion == 3);
+  prefs.begin("dongleStore", true);
+  CHECK(!prefs.isKey(PERS_MEM_DONGLE_IDS));
+  prefs.end();
+  DongleTable stored;
+  uint32_t storedVersion = 0;
+  CHECK(dongleStore.load(&stored, &storedVersion) && storedVersion == 3 && stored.size() == 2);
+}
+
+static void testDeltaAddsAndRemovesSameId() {
+  // B moves from door 1 to door 2 (old entry removed, new one added); C is listed
+  // in both, which the added entry wins; D was never here
+  startDongleTable({ ID_A, std::string(ID_B) + ":1" }, 5);
+  serveDongleDeltas({ { 5, deltaAnswer(6, false, { std::string(ID_B) + ":2", ID_C },
+                                       { std::string(ID_B) + ":1", ID_C, ID_D },
+                                       { ID_A, std::string(ID_B) + ":2", ID_C }) } });
+  fetchAndStoreDongleIds();
+  CHECK(dongleQueries == std::vector<uint32_t>({ 5 }));  // Hash matched: no full download
+  CHECK(dongleListVersion == 6);
+  CHECK(publishedTableIs({ ID_A, std::string(ID_B) + ":2", ID_C }));
+
+  PublishedDongleTable::Reader current(ramDongleTable);
+  uint32_t idB = decodeDongleId(ID_B);
+  CHECK(!current->allows(idB, 0, time(nullptr)) && current->allows(idB, 1, time(nullptr)));
+}
+
+static void testHashMismatchForcesFullSync() {
+  // The device lost C (e.g. a flash write): the delta alone does not reproduce
+  // the server's list, so the whole list is downloaded
+  startDongleTable({ ID_A }, 5);
+  serveDongleDeltas({ { 5, deltaAnswer(6, false, { ID_B }, {}, { ID_A, ID_B, ID_C }) },
+                      { 0, deltaAnswer(6, true, { ID_A, ID_B, ID_C }, {}, { ID_A, ID_B, ID_C }) } });
+  fetchAndStoreDongleIds();
+  CHECK(dongleQueries == std::vector<uint32_t>({ 5, 0 }));
+  CHECK(dongleListVersion == 6);
+  CHECK(publishedTableIs({ ID_A, ID_B, ID_C }));
+
+  // Full download failing too: the mismatched delta is never published
+  startDongleTable({ ID_A }, 5);
+  serveDongleDeltas({ { 5, deltaAnswer(6, false, { ID_B }, {}, { ID_A, ID_B, ID_C }) } });
+  fetchAndStoreDongleIds();
+  CHECK(dongleQueries == std::vector<uint32_t>({ 5, 0 }));
+  CHECK(dongleListVersion == 5);
+  CHECK(publishedTableIs({ ID_A }));
+}
+
+// The WiFi event handler woke the task
+static bool wifiEventWoke() {
+  uint32_t notifications = 0;
+  return xTaskNotifyWait(0, UINT32_MAX, &notifications, 0) == pdTRUE && (notifications & NOTIFY_WIFI_EVENT);
+}
+
+static void testWifiEvents() {
+  // Stand in for the network task: the event handlers wake this thread
+  networkTaskHandle = xTaskGetCurrentTaskHandle();
+  WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+  CHECK(linkMonitor.state() == LINK_OFFLINE);  // Boot: no requests before WiFi is up
+
+  // First association: the initial dongle fetch, with the full timeout (it
+  // fails here, which counts against the link)
+  serveDongleDeltas({});
+  WiFi.begin(SSID, WIFI_PASSWORD);
+  CHECK(wifiEventWoke());
+  handleWifiEvent();
+  CHECK(dongleQueries == std::vector<uint32_t>({ 0 }));
+  CHECK(dongleQueryTimeouts == std::vector<uint32_t>({ SCRIPT_HTTP_TIMEOUT_MS }));
+  CHECK(linkMonitor.state() == LINK_DEGRADED && !linkMonitor.requestDue(millis()));
+
+  // Lost: no requests, a reconnect is scheduled
+  HostWiFi::setLinkUp(false);
+  CHECK(wifiEventWoke());
+  handleWifiEvent();
+  CHECK(linkMonitor.state() == LINK_OFFLINE && !linkMonitor.requestDue(millis()));
+  unsigned long untilReconnect = reconnectWifiIfDue();
+  CHECK(untilReconnect > 0 && untilReconnect <= WIFI_RECONNECT_MIN_MS);
+
+  // Back: a probe at once (despite the failure's backoff) with the short timeout,
+  // no second initial fetch
+  HostWiFi::setLinkUp(true);
+  CHECK(wifiEventWoke());
+  handleWifiEvent();
+  CHECK(linkMonitor.state() == LINK_DEGRADED && linkMonitor.requestDue(millis()));
+  CHECK(linkMonitor.requestTimeoutMs() == SCRIPT_PROBE_TIMEOUT_MS);
+  CHECK(wifiReconnect.intervalMs() == 0);
+  CHECK(dongleQueries.size() == 1);
+
+  // A repeated event changes nothing
+  onWifiEvent(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  CHECK(wifiEventWoke());
+  handleWifiEvent();
+  CHECK(linkMonitor.state() == LINK_DEGRADED);
+
+  networkTaskHandle = nullptr;  // loadDonglesFromPersistentMemory() runs before the task
+}
+
+int main() {
+  testWifiEvents();
+  CHECK(failedLogRing.begin());
+  testResultDelivered();
+  testResultLostAfterRedirect();
+  testNotDelivered();
+  testMigrateLegacyFailedLogs();
+  testMigrateLegacyDongleJson();
+  testDeltaAddsAndRemovesSameId();
+  testHashMismatchForcesFullSync();
+  return checkSummary("network_task");
+}
@@ -0,0 +1,168 @@
+// Tests for the Wiegand format engine (parity masks, encode/validate for
+// 26/34/37-bit frames) and the SPSC ring that carries frames from the ISR
+// (and log events from Core 1 to the network task).
+
+#include "WiegandFormat.h"
+#include "SpscRing.h"
+#include "check.h"
+#include <stdio.h>
+#include <thread>
+
+template<typename Format>
+static void checkFormat(typename Format::Frame payload) {
+  typedef typename Format::Frame Frame;
+  Frame frame = Format::encode(payload);
+  CHECK(Format::hasValidParity(frame));
+  CHECK(Format::data(frame) == payload);
+  CHECK((frame >> Format::BITS) == 0);
+
+  // Every single-bit error is caught, parity bits included
+  for (int bit = 0; bit < Format::BITS; bit++) {
+    CHECK(!Format::hasValidParity(frame ^ ((Frame)1 << bit)));
+  }
+}
+
+static void testFormats() {
+  // Known H10301 frame: facility 37, card 21425 (as stored in the sheet)
+  CHECK(Wiegand26::encode((37 << 16) | 21425) == 0b10010010101010011101100011u);
+  CHECK(Wiegand26::data(0b10010010101010011101100011u) == ((37u << 16) | 21425));
+
+  checkFormat<Wiegand26>(0);
+  checkFormat<Wiegand26>(0xFFFFFF);
+  checkFormat<Wiegand26>(0x0253B1);
+  checkFormat<Wiegand34>(0);
+  checkFormat<Wiegand34>(0xFFFFFFFF);
+  checkFormat<Wiegand34>(0x12345678);
+  checkFormat<Wiegand37>(0);
+  checkFormat<Wiegand37>(0x7FFFFFFFFULL);
+  checkFormat<Wiegand37>(0x2468ACE13ULL);
+
+  CHECK(!Wiegand26::hasValidParity(0));  // All zero: odd parity fails
+  CHECK(sizeof(Wiegand26::Frame) == 4);
+  CHECK(sizeof(Wiegand37::Frame) == 8);
+}
+
+static void testRingOrderAndFull() {
+  SpscRing<uint32_t, 4> ring;
+  uint32_t value;
+  CHECK(!ring.pop(&value));
+  for (uint32_t round = 0; round < 3; round++) {  // Counters wrap past the slot count
+    for (uint32_t i = 0; i < 4; i++) {
+      CHECK(ring.push(round * 10 + i));
+    }
+    CHECK(!ring.push(99));  // Full: rejected, nothing overwritten
+    CHECK(ring.size() == 4);
+    for (uint32_t i = 0; i < 4; i++) {
+      CHECK(ring.pop(&value) && value == round * 10 + i);
+    }
+    CHECK(!ring.pop(&value));
+  }
+}
+
+static void testRingAcrossThreads() {
+  static SpscRing<WiegandFrame, 8> ring;
+  const uint32_t count = 100000;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < count; i++) {
+      WiegandFrame frame = { i, i * 3 };
+      while (!ring.push(frame)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expected = 0;
+  bool inOrder = true;
+  while (expected < count) {
+    WiegandFrame frame;
+    if (ring.pop(&frame)) {
+      inOrder = inOrder && frame.bits == expected && frame.endCycles == expected * 3;
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  CHECK(inOrder);
+  CHECK(ring.size() == 0);
+}
+
+static void testRingInPlace() {
+  SpscRing<uint32_t, 8> ring;
+  const uint32_t* items;
+  CHECK(ring.peek(&items) == 0);
+
+  // Reserved but not committed: invisible to the consumer
+  uint32_t* slot = ring.reserve();
+  CHECK(slot != nullptr);
+  *slot = 100;
+  CHECK(ring.peek(&items) == 0);
+  ring.commit();
+  CHECK(ring.peek(&items) == 1 && items[0] == 100);
+  ring.release(1);
+
+  // 1 slot used up: 6 items run to the end of the buffer, the 7th wraps
+  for (uint32_t i = 0; i < 7; i++) {
+    slot = ring.reserve();
+    CHECK(slot != nullptr);
+    *slot = i;
+    ring.commit();
+  }
+  CHECK(ring.peek(&items) == 7);
+  CHECK(items[0] == 0 && items[6] == 6);
+  ring.release(4);
+  CHECK(ring.peek(&items) == 3 && items[0] == 4);
+  ring.release(3);
+  CHECK(ring.size() == 0);
+
+  // Full: no slot reserved, nothing overwritten
+  for (uint32_t i = 0; i < 8; i++) {
+    CHECK(ring.push(i));
+  }
+  CHECK(ring.reserve() == nullptr);
+  uint32_t value;
+  CHECK(ring.pop(&value) && value == 0);
+  CHECK(ring.reserve() != nullptr);
+}
+
+static void testRingBatchesAcrossThreads() {
+  static SpscRing<WiegandFrame, 16> ring;
+  const uint32_t count = 100000;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < count; i++) {
+      WiegandFrame* slot;
+      while ((slot = ring.reserve()) == nullptr) {
+        std::this_thread::yield();
+      }
+      slot->bits = i;
+      slot->endCycles = i * 3;
+      ring.commit();
+    }
+  });
+  uint32_t expected = 0;
+  bool inOrder = true;
+  while (expected < count) {
+    const WiegandFrame* frames;
+    uint32_t available = ring.peek(&frames);
+    if (available == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (uint32_t i = 0; i < available; i++) {
+      inOrder = inOrder && frames[i].bits == expected && frames[i].endCycles == expected * 3;
+      expected++;
+    }
+    ring.release(available);
+  }
+  producer.join();
+  CHECK(inOrder);
+  CHECK(ring.size() == 0);
+}
+
+int main() {
+  testFormats();
+  testRingOrderAndFull();
+  testRingAcrossThreads();
+  testRingInPlace();
+  testRingBatchesAcrossThreads();
+  return checkSummary("wiegand");
+}